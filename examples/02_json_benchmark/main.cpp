@@ -0,0 +1,189 @@
+#include <bg2e/tools/JsonParser.hpp>
+#include <bg2e/tools/JsonDocument.hpp>
+#include <bg2e/tools/JsonLazyDocument.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/JsonStructuralIndex.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <random>
+
+// Usage: json-benchmark [file.json] [copies]
+// The input document is replicated `copies` times inside a top level array.
+
+std::string loadFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+std::string buildInput(const std::string& document, size_t copies)
+{
+    std::string result = "[\n";
+    for (size_t i = 0; i < copies; ++i)
+    {
+        result += document;
+        result += i < copies - 1 ? ",\n" : "\n";
+    }
+    result += "]\n";
+    return result;
+}
+
+// Number heavy document: a list of `count` 4x4 matrices
+std::string buildMatrixInput(size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+    std::string result = "[\n";
+    for (size_t i = 0; i < count; ++i)
+    {
+        result += "[";
+        for (int j = 0; j < 16; ++j)
+        {
+            result += std::to_string(dist(rng));
+            result += j < 15 ? "," : "";
+        }
+        result += i < count - 1 ? "],\n" : "]\n";
+    }
+    result += "]\n";
+    return result;
+}
+
+void runBenchmark(const std::string& name, size_t bytes, uint32_t iterations, const std::function<void()>& fn)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+    double seconds = elapsed.count() / iterations;
+    double mbPerSecond = static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+    std::cout << std::left << std::setw(32) << name
+        << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms"
+        << std::setw(12) << std::setprecision(2) << mbPerSecond << " MB/s" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    using namespace bg2e::tools;
+
+    std::string path = argc > 1 ? argv[1] : "data/test.bg2mat";
+    size_t copies = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    std::string input = buildInput(loadFile(path), copies);
+    std::cout << "Input: " << path << " x " << copies << " (" << input.size() << " bytes)" << std::endl;
+
+    runBenchmark("JsonParser(std::istream*)", input.size(), 3, [&]() {
+        std::stringstream stream(input);
+        JsonParser parser(&stream);
+        parser.parse();
+    });
+
+    runBenchmark("JsonParser (tokenizer)", input.size(), 20, [&]() {
+        JsonParser parser;
+        parser.parse(input, JsonParseMode::Tokenizer);
+    });
+
+    runBenchmark("JsonParser (structural)", input.size(), 20, [&]() {
+        JsonParser parser;
+        parser.parse(input, JsonParseMode::StructuralIndex);
+    });
+
+    size_t threads = ThreadPool::shared().threadCount() + 1;
+    runBenchmark("JsonParser (" + std::to_string(threads) + " threads)", input.size(), 20, [&]() {
+        JsonParser parser;
+        parser.parse(input, JsonParseMode::Parallel);
+    });
+
+    runBenchmark("JsonDocument (tokenizer)", input.size(), 20, [&]() {
+        JsonDocument document;
+        document.parse(input, JsonParseMode::Tokenizer);
+    });
+
+    runBenchmark("JsonDocument (structural)", input.size(), 20, [&]() {
+        JsonDocument document;
+        document.parse(input, JsonParseMode::StructuralIndex);
+    });
+
+    // Stage one alone, compared with a scalar tokenizer pass over the same input
+    runBenchmark("JsonBufferTokenizer", input.size(), 20, [&]() {
+        JsonBufferTokenizer tokenizer(input);
+        volatile size_t count = 0;
+        while (tokenizer.hasMoreTokens())
+        {
+            tokenizer.getToken();
+            count = count + 1;
+        }
+    });
+
+    JsonStructuralIndex index;
+    runBenchmark(std::string("JsonStructuralIndex (") + JsonStructuralIndex::implementation() + ")", input.size(), 20, [&]() {
+        index.build(input);
+    });
+
+    JsonDocument document(input);
+    std::cout << "JsonDocument: " << document.nodeCount() << " nodes, "
+        << document.memorySize() << " bytes in a single allocation" << std::endl;
+
+    std::string matrices = buildMatrixInput(copies * 100);
+    std::cout << std::endl << "Input: " << copies * 100 << " matrices (" << matrices.size() << " bytes)" << std::endl;
+
+    std::vector<std::string_view> numberTokens;
+    JsonBufferTokenizer tokenizer(matrices);
+    while (tokenizer.hasMoreTokens())
+    {
+        auto token = tokenizer.getToken();
+        if (token.type == JsonTokenType::Number)
+        {
+            numberTokens.push_back(token.value);
+        }
+    }
+
+    runBenchmark("std::stof(std::string)", matrices.size(), 5, [&]() {
+        volatile float sum = 0.0f;
+        for (auto & token : numberTokens)
+        {
+            sum = sum + std::stof(std::string(token));
+        }
+    });
+
+    runBenchmark("parseJsonNumber", matrices.size(), 5, [&]() {
+        volatile double sum = 0.0;
+        for (auto & token : numberTokens)
+        {
+            sum = sum + parseJsonNumber(token).doubleValue;
+        }
+    });
+
+    runBenchmark("JsonParser (tokenizer)", matrices.size(), 5, [&]() {
+        JsonParser parser;
+        parser.parse(matrices, JsonParseMode::Tokenizer);
+    });
+
+    runBenchmark("JsonDocument (tokenizer)", matrices.size(), 5, [&]() {
+        JsonDocument document;
+        document.parse(matrices, JsonParseMode::Tokenizer);
+    });
+
+    runBenchmark("JsonDocument (structural)", matrices.size(), 5, [&]() {
+        JsonDocument document;
+        document.parse(matrices, JsonParseMode::StructuralIndex);
+    });
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <bg2e/base/Bg2Reader.hpp>
+#include <bg2e/base/Bg2Writer.hpp>
+#include <bg2e/base/Bg2CookedModel.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+
+// Usage: bg2-benchmark [file.bg2] [copies]
+// The poly lists of the input file are replicated `copies` times in a larger model.
+
+std::vector<bg2e::Byte> loadFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    return std::vector<bg2e::Byte>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Replaces the poly list count of the header and repeats the data between the first
+// plst chunk and the endf chunk
+std::vector<bg2e::Byte> buildInput(const std::vector<bg2e::Byte>& model, size_t copies)
+{
+    const std::string plst = "plst";
+    const std::string endf = "endf";
+    auto begin = std::search(model.begin(), model.end(), plst.begin(), plst.end());
+    auto end = std::find_end(model.begin(), model.end(), endf.begin(), endf.end());
+    if (model.size() < 12 || begin == model.end() || end == model.end())
+    {
+        throw std::runtime_error("Invalid bg2 file");
+    }
+
+    bool bigEndian = model[0] == 0;
+    auto swap = [](uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0x0000FF00) | ((v << 8) & 0x00FF0000) | (v << 24);
+    };
+    uint32_t count = 0;
+    std::memcpy(&count, model.data() + 8, 4);
+    count = bigEndian ? swap(swap(count) * static_cast<uint32_t>(copies)) : count * static_cast<uint32_t>(copies);
+
+    std::vector<bg2e::Byte> result(model.begin(), begin);
+    std::memcpy(result.data() + 8, &count, 4);
+    for (size_t i = 0; i < copies; ++i)
+    {
+        result.insert(result.end(), begin, end);
+    }
+    result.insert(result.end(), end, model.end());
+    return result;
+}
+
+void runBenchmark(const std::string& name, size_t bytes, uint32_t iterations, const std::function<void()>& fn)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+    double seconds = elapsed.count() / iterations;
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(32) << name
+        << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms"
+        << std::setw(12) << std::setprecision(3) << seconds * 1000.0 / megabytes << " ms/MB"
+        << std::setw(12) << std::setprecision(2) << megabytes / seconds << " MB/s" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    using namespace bg2e::base;
+
+    std::string path = argc > 1 ? argv[1] : "data/test.bg2";
+    size_t copies = argc > 2 ? std::stoul(argv[2]) : 500;
+
+    std::vector<bg2e::Byte> input = buildInput(loadFile(path), copies);
+    std::cout << "Threads: " << bg2e::tools::ThreadPool::shared().threadCount() + 1 << std::endl;
+    std::cout << "Input: " << path << " x " << copies << " (" << input.size() << " bytes)" << std::endl;
+
+    runBenchmark("Bg2Reader (file)", loadFile(path).size(), 200, [&]() {
+        Bg2Reader reader;
+        reader.load(path);
+    });
+
+    runBenchmark("Bg2Reader (memory, serial)", input.size(), 20, [&]() {
+        Bg2Reader reader;
+        reader.setParallel(false);
+        reader.load(input.data(), input.size());
+    });
+
+    runBenchmark("Bg2Reader (memory)", input.size(), 20, [&]() {
+        Bg2Reader reader;
+        reader.load(input.data(), input.size());
+    });
+
+    runBenchmark("Bg2Reader (tangents, serial)", input.size(), 5, [&]() {
+        Bg2Reader reader;
+        reader.setParallel(false);
+        reader.setGenerateTangents(true);
+        reader.load(input.data(), input.size());
+    });
+
+    runBenchmark("Bg2Reader (tangents)", input.size(), 5, [&]() {
+        Bg2Reader reader;
+        reader.setGenerateTangents(true);
+        reader.load(input.data(), input.size());
+    });
+
+    std::string outPath = "bg2-benchmark.bg2";
+    {
+        std::ofstream out(outPath, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(input.data()), input.size());
+    }
+    runBenchmark("Bg2Reader (mapped file)", input.size(), 20, [&]() {
+        Bg2Reader reader;
+        reader.load(outPath);
+    });
+    std::remove(outPath.c_str());
+
+    Bg2Reader reader;
+    reader.load(input.data(), input.size());
+
+    // Cooked model: the blocks are copied to a buffer, as they would be to a staging buffer
+    Bg2Writer writer;
+    for (size_t i = 0; i < reader.polyLists().size(); ++i)
+    {
+        writer.addPolyList(reader.polyLists()[i], reader.materialNames()[i]);
+    }
+    writer.setMaterials(reader.materials());
+    writer.setJoints(reader.joints());
+    std::string cookedPath = "bg2-benchmark.bg2c";
+    writer.saveCooked(cookedPath);
+    size_t cookedSize = loadFile(cookedPath).size();
+    std::vector<bg2e::Byte> staging(cookedSize);
+    runBenchmark("Bg2CookedModel (mapped file)", cookedSize, 20, [&]() {
+        Bg2CookedModel model;
+        model.load(cookedPath);
+        size_t offset = 0;
+        for (auto & plist : model.polyLists())
+        {
+            std::memcpy(staging.data() + offset, plist.vertexData, plist.vertexDataSize());
+            offset += plist.vertexDataSize();
+            std::memcpy(staging.data() + offset, plist.indexData, plist.indexDataSize());
+            offset += plist.indexDataSize();
+        }
+    });
+    std::remove(cookedPath.c_str());
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (auto & plist : reader.polyLists())
+    {
+        vertexCount += plist->vertex().size() / 3;
+        indexCount += plist->index().size();
+    }
+    std::cout << "Bg2Reader: " << reader.polyLists().size() << " poly lists, "
+        << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/base/MeshOptimizer.hpp>
+#include <bg2e/base/MeshSimplifier.hpp>
+#include <bg2e/base/MeshletBuilder.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <algorithm>
+
+// Usage: mesh-benchmark [triangles]
+// The input is a procedural height field grid with about `triangles` triangles.
+
+std::shared_ptr<bg2e::base::PolyList> buildGrid(size_t triangles)
+{
+    const uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(triangles) / 2.0));
+    const uint32_t rowVertices = side + 1;
+    std::vector<float> vertex;
+    std::vector<float> normal;
+    std::vector<float> texCoord;
+    std::vector<uint32_t> index;
+    vertex.reserve(rowVertices * rowVertices * 3);
+    normal.reserve(rowVertices * rowVertices * 3);
+    texCoord.reserve(rowVertices * rowVertices * 2);
+    index.reserve(side * side * 6);
+
+    for (uint32_t y = 0; y < rowVertices; ++y)
+    {
+        for (uint32_t x = 0; x < rowVertices; ++x)
+        {
+            float u = static_cast<float>(x) / side;
+            float v = static_cast<float>(y) / side;
+            float h = 0.05f * std::sin(u * 20.0f) * std::cos(v * 20.0f);
+            float dx = std::cos(u * 20.0f) * std::cos(v * 20.0f);
+            float dy = -std::sin(u * 20.0f) * std::sin(v * 20.0f);
+            glm::vec3 n = glm::normalize(glm::vec3{ -dx, -dy, 1.0f });
+            vertex.insert(vertex.end(), { u, v, h });
+            normal.insert(normal.end(), { n.x, n.y, n.z });
+            texCoord.insert(texCoord.end(), { u, v });
+        }
+    }
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            uint32_t i = y * rowVertices + x;
+            index.insert(index.end(), { i, i + 1, i + rowVertices + 1, i, i + rowVertices + 1, i + rowVertices });
+        }
+    }
+
+    auto result = std::make_shared<bg2e::base::PolyList>();
+    result->setName("grid");
+    result->setVertex(std::move(vertex));
+    result->setNormal(std::move(normal));
+    result->setTexCoord0(std::move(texCoord));
+    result->setIndex(std::move(index));
+    return result;
+}
+
+// Tangent generation of previous versions, that used a hash map to find the vertices
+std::vector<float> legacyTangents(const bg2e::base::PolyList& plist)
+{
+    const auto& vertex = plist.vertex();
+    const auto& texCoord = plist.texCoord0();
+    const auto& index = plist.index();
+    std::vector<float> result;
+    std::unordered_map<uint32_t, bool> generatedIndexes;
+    for (uint32_t i = 0; i + 2 < index.size(); i += 3)
+    {
+        uint32_t vi[] = { index[i] * 3, index[i + 1] * 3, index[i + 2] * 3 };
+        uint32_t ti[] = { index[i] * 2, index[i + 1] * 2, index[i + 2] * 2 };
+        glm::vec3 edge1 = glm::vec3{ vertex[vi[1]], vertex[vi[1] + 1], vertex[vi[1] + 2] } - glm::vec3{ vertex[vi[0]], vertex[vi[0] + 1], vertex[vi[0] + 2] };
+        glm::vec3 edge2 = glm::vec3{ vertex[vi[2]], vertex[vi[2] + 1], vertex[vi[2] + 2] } - glm::vec3{ vertex[vi[0]], vertex[vi[0] + 1], vertex[vi[0] + 2] };
+        glm::vec2 delta1 = glm::vec2{ texCoord[ti[1]], texCoord[ti[1] + 1] } - glm::vec2{ texCoord[ti[0]], texCoord[ti[0] + 1] };
+        glm::vec2 delta2 = glm::vec2{ texCoord[ti[2]], texCoord[ti[2] + 1] } - glm::vec2{ texCoord[ti[0]], texCoord[ti[0] + 1] };
+        float den = delta1.x * delta2.y - delta2.x * delta1.y;
+        glm::vec3 tangent = den == 0.0f ? glm::vec3{ 0.0f, 0.0f, 1.0f } : glm::normalize((edge1 * delta2.y - edge2 * delta1.y) / den);
+        for (uint32_t v : vi)
+        {
+            if (!generatedIndexes[v])
+            {
+                result.insert(result.end(), { tangent.x, tangent.y, tangent.z });
+                generatedIndexes[v] = true;
+            }
+        }
+    }
+    return result;
+}
+
+// Random triangle order, as in the meshes exported by CAD tools
+void shuffleTriangles(bg2e::base::PolyList& plist)
+{
+    std::vector<uint32_t> index = plist.index();
+    std::vector<uint32_t> order(index.size() / 3);
+    for (uint32_t t = 0; t < order.size(); ++t)
+    {
+        order[t] = t;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+    std::vector<uint32_t> result;
+    result.reserve(index.size());
+    for (auto t : order)
+    {
+        result.insert(result.end(), index.begin() + t * 3, index.begin() + t * 3 + 3);
+    }
+    plist.setIndex(std::move(result));
+}
+
+void printCacheStats(const std::string& name, const bg2e::base::VertexCacheStats& stats)
+{
+    std::cout << std::left << std::setw(32) << name
+        << std::right << std::fixed << std::setprecision(3)
+        << "ACMR " << std::setw(7) << stats.acmr << "   ATVR " << std::setw(7) << stats.atvr << std::endl;
+}
+
+void runBenchmark(const std::string& name, size_t items, uint32_t iterations, const std::function<void()>& fn)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+    double seconds = elapsed.count() / iterations;
+    std::cout << std::left << std::setw(32) << name
+        << std::right << std::setw(12) << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms"
+        << std::setw(12) << std::setprecision(2) << static_cast<double>(items) / seconds / 1.0e6 << " Mtri/s" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    using namespace bg2e::base;
+
+    size_t triangles = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    auto plist = buildGrid(triangles);
+    triangles = plist->index().size() / 3;
+    std::cout << "Threads: " << bg2e::tools::ThreadPool::shared().threadCount() + 1 << std::endl;
+    std::cout << "Input: " << plist->vertex().size() / 3 << " vertices, " << triangles << " triangles" << std::endl;
+
+    runBenchmark("Tangents (legacy)", triangles, 3, [&]() {
+        legacyTangents(*plist);
+    });
+
+    runBenchmark("Tangents (serial)", triangles, 10, [&]() {
+        plist->rebuildTangents(false);
+    });
+
+    runBenchmark("Tangents", triangles, 10, [&]() {
+        plist->rebuildTangents();
+    });
+
+    shuffleTriangles(*plist);
+    MeshOptimizer optimizer;
+    printCacheStats("Vertex cache (shuffled)", MeshOptimizer::analyzeVertexCache(*plist));
+
+    auto cacheOnly = plist->clone();
+    runBenchmark("MeshOptimizer (vertex cache)", triangles, 1, [&]() {
+        optimizer.optimizeVertexCache(*cacheOnly);
+    });
+    printCacheStats("Vertex cache (Tipsify)", MeshOptimizer::analyzeVertexCache(*cacheOnly));
+
+    MeshOptimizerResult result;
+    runBenchmark("MeshOptimizer (all passes)", triangles, 1, [&]() {
+        result = optimizer.optimize(*plist);
+    });
+    printCacheStats("Vertex cache (before)", result.before);
+    printCacheStats("Vertex cache (after)", result.after);
+
+    MeshSimplifier simplifier;
+    std::vector<uint32_t> simplified;
+    float error = 0.0f;
+    runBenchmark("MeshSimplifier (10%)", triangles, 1, [&]() {
+        simplified = simplifier.simplify(*plist, triangles / 10, 1.0f, &error);
+    });
+    std::cout << "Simplified: " << simplified.size() / 3 << " triangles, error " << std::setprecision(5) << error << std::endl;
+
+    runBenchmark("MeshSimplifier (LOD chain)", triangles, 1, [&]() {
+        simplifier.buildLods(*plist);
+    });
+    for (size_t i = 0; i < plist->lods().size(); ++i)
+    {
+        const auto& lod = plist->lods()[i];
+        std::cout << "LOD " << i + 1 << ": " << lod.index.size() / 3 << " triangles, error " << std::setprecision(5) << lod.error << std::endl;
+    }
+
+    MeshletBuilder meshletBuilder;
+    PolyListMeshlets meshlets;
+    runBenchmark("MeshletBuilder", triangles, 1, [&]() {
+        meshlets = meshletBuilder.build(*plist);
+    });
+    std::cout << "Meshlets: " << meshlets.meshlets.size() << ", "
+        << std::setprecision(1) << static_cast<double>(triangles) / meshlets.meshlets.size() << " triangles per meshlet" << std::endl;
+
+    // Cameras over the grid looking down, and under the grid looking up, where the cones
+    // cull the meshlets that are inside the frustum
+    glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+    std::vector<glm::vec3> cameras;
+    std::vector<MeshletFrustum> frustums;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1.0f);
+    for (int i = 0; i < 64; ++i)
+    {
+        glm::vec3 target{ coordinate(random), coordinate(random), 0.0f };
+        glm::vec3 eye = target + glm::vec3{ 0.1f, 0.1f, i % 2 == 0 ? 0.5f : -0.5f };
+        cameras.push_back(eye);
+        frustums.push_back(MeshletFrustum::fromMatrix(projection * glm::lookAt(eye, target, glm::vec3{ 0.0f, 0.0f, 1.0f })));
+    }
+    std::vector<uint32_t> visible;
+    size_t visibleCount = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        visibleCount += MeshletBuilder::cull(meshlets, frustums[i], cameras[i], visible);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+    std::cout << std::left << std::setw(32) << "Meshlet culling"
+        << std::right << std::setw(12) << std::setprecision(3) << elapsed.count() / cameras.size() << " ms"
+        << std::setw(12) << std::setprecision(0) << static_cast<double>(meshlets.meshlets.size() * cameras.size()) / elapsed.count() << " meshlets/ms" << std::endl;
+    std::cout << "Visible: " << std::setprecision(1) << 100.0 * visibleCount / (meshlets.meshlets.size() * cameras.size()) << "%" << std::endl;
+
+    return 0;
+}
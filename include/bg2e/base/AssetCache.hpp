@@ -0,0 +1,159 @@
+#ifndef bg2e_base_assetcache_hpp
+#define bg2e_base_assetcache_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/base/Image.hpp>
+#include <bg2e/base/Bg2CookedModel.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace bg2e {
+namespace base {
+
+struct AssetCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+
+    // Current size of the entries on disk
+    uint64_t size = 0;
+    size_t entryCount = 0;
+};
+
+// Mip level of a cached image, in RGBA8 format
+struct CachedImageLevel
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const Byte* data = nullptr;
+    size_t size = 0;
+};
+
+// Decoded image and mip chain, mapped from an AssetCache entry
+class BG2E_EXPORT CachedImage
+{
+    friend class AssetCache;
+public:
+    inline const std::vector<CachedImageLevel>& levels() const { return _levels; }
+    inline uint32_t width() const { return _levels.empty() ? 0 : _levels[0].width; }
+    inline uint32_t height() const { return _levels.empty() ? 0 : _levels[0].height; }
+
+    // Copies a mip level to a new Image
+    std::shared_ptr<Image> image(size_t level = 0) const;
+
+protected:
+    tools::MappedFile _file;
+    std::vector<CachedImageLevel> _levels;
+
+    bool parse();
+};
+
+// Cache of cooked assets on disk. Entries are named with the XXH64 hash of the source file
+// contents and the cooking parameters, so they are valid until the source changes. The
+// key of an OBJ model also includes the contents of its .mtl files. Concurrent loads of the
+// same asset cook it once: the other callers wait and map the stored entry. The
+// least recently used entries are removed when the cache is larger than maxSize().
+// Cooked results are memory mapped from the cache directory, in the first load after the
+// cooking and in the following launches.
+class BG2E_EXPORT AssetCache
+{
+public:
+    // The directory is created if it does not exist. Throws std::runtime_error if it can
+    // not be created
+    AssetCache(const std::string& directory, uint64_t maxSize = 1024ull * 1024ull * 1024ull);
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    inline const std::string& directory() const { return _directory; }
+    inline uint64_t maxSize() const { return _maxSize; }
+
+    // Zero disables the eviction
+    void setMaxSize(uint64_t size);
+
+    // Content hash of the source file and the parameters, in hexadecimal. Throws
+    // std::runtime_error if the source file can not be read
+    std::string key(const std::string& sourcePath, std::string_view parameters) const;
+
+    // Maps the entry if it exists, and updates its last use time
+    bool find(const std::string& key, tools::MappedFile& result);
+
+    // Stores the entry and maps it. The new entry is never evicted by this call
+    void store(const std::string& key, const std::vector<Byte>& data, tools::MappedFile& result);
+
+    void remove(const std::string& key);
+    void clear();
+
+    // Decodes the image with stb_image, and builds the box filtered mip chain if mipmaps
+    // is true. Throws std::runtime_error if the image can not be loaded
+    std::shared_ptr<CachedImage> loadImage(const std::string& path, bool mipmaps = true);
+
+    // Loads .obj files with ObjImporter, and other files with Bg2Reader, and stores the
+    // model in the cooked bg2 format, with tangents and bounds. If optimize is true, the
+    // levels of detail are built with MeshSimplifier, and the poly lists are reordered with
+    // MeshOptimizer before they are stored
+    std::shared_ptr<Bg2CookedModel> loadModel(const std::string& path, bool optimize = true);
+
+    AssetCacheStats stats();
+    void resetStats();
+
+protected:
+    struct Entry
+    {
+        uint64_t size = 0;
+        uint64_t lastUse = 0;
+    };
+
+    std::string _directory;
+    uint64_t _maxSize;
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, Entry> _entries;
+    // Keys that are being loaded or cooked
+    std::unordered_set<std::string> _loading;
+    std::condition_variable _loadingDone;
+    uint64_t _size = 0;
+    uint64_t _useCounter = 0;
+    AssetCacheStats _stats;
+
+    std::string entryPath(const std::string& key) const;
+
+    // Marks the key as being loaded while the scope exists. It waits while another thread
+    // loads the same key, so only one of them cooks it, and the entry is never replaced
+    // while it is being mapped
+    class LoadingScope
+    {
+    public:
+        LoadingScope(AssetCache& cache, const std::string& key);
+        ~LoadingScope();
+
+    protected:
+        AssetCache& _cache;
+        std::string _key;
+    };
+
+    // Removes an entry returned by find() that could not be parsed, and counts it as a
+    // miss. The caller must close the mapping first
+    void reject(const std::string& key);
+
+    // Must be called with the mutex locked
+    void scan();
+    void touch(const std::string& key, Entry& entry);
+    void evict(const std::string& keep);
+};
+
+}
+}
+
+#endif
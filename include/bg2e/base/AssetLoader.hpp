@@ -0,0 +1,278 @@
+#ifndef bg2e_base_assetloader_hpp
+#define bg2e_base_assetloader_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/base/Image.hpp>
+#include <bg2e/base/Bg2Reader.hpp>
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <typeinfo>
+#include <cstdint>
+#include <stdexcept>
+
+namespace bg2e {
+namespace base {
+
+// Requests with higher priority are decoded first. Requests with the same priority are
+// decoded in order
+enum class AssetPriority
+{
+    Background = 0,
+    Normal,
+    High,
+    Visible
+};
+
+enum class AssetStatus
+{
+    Pending,
+    Loading,
+    Loaded,
+    Failed,
+    Cancelled
+};
+
+// Thrown by AssetHandle::get() if the request has been cancelled
+class AssetCancelledError : public std::runtime_error
+{
+public:
+    AssetCancelledError(const std::string& path) :std::runtime_error("Asset load cancelled: '" + path + "'") {}
+};
+
+class AssetLoader;
+class AssetRequest;
+
+// State of one AssetLoader::load() call. The handles copied from the result of the call
+// share it. A cancelled subscription is detached from its request, and its callback is not
+// called
+struct AssetSubscription
+{
+    std::function<void(AssetRequest&)> callback;
+    std::atomic<bool> cancelled{ false };
+};
+
+// Shared state of a load request. The same request is used by all the handles to a path
+// that is requested while it is pending or loading
+class BG2E_EXPORT AssetRequest : public std::enable_shared_from_this<AssetRequest>
+{
+    friend class AssetLoader;
+public:
+    inline const std::string& path() const { return _path; }
+    inline AssetStatus status() const { return _status.load(); }
+
+    inline bool isDone() const
+    {
+        AssetStatus s = status();
+        return s == AssetStatus::Loaded || s == AssetStatus::Failed || s == AssetStatus::Cancelled;
+    }
+
+    // Blocks until the request is done. Rethrows the decoder exception, or throws
+    // AssetCancelledError
+    inline const std::shared_ptr<void>& result() const { return _future.get(); }
+    inline void wait() const { _future.wait(); }
+
+protected:
+    std::string _path;
+    std::string _key;
+    AssetPriority _priority = AssetPriority::Normal;
+    uint64_t _sequence = 0;
+    std::function<std::shared_ptr<void>()> _decode;
+
+    // Subscriptions that are not cancelled. The decode is cancelled with the last one
+    std::vector<std::shared_ptr<AssetSubscription>> _subscriptions;
+    bool _cancelRequested = false;
+
+    std::atomic<AssetStatus> _status{ AssetStatus::Pending };
+    std::promise<std::shared_ptr<void>> _promise;
+    std::shared_future<std::shared_ptr<void>> _future{ _promise.get_future().share() };
+};
+
+template <typename T>
+class AssetHandle
+{
+public:
+    AssetHandle() {}
+    AssetHandle(const std::shared_ptr<AssetRequest>& request) :_request(request) {}
+    AssetHandle(const std::shared_ptr<AssetRequest>& request, const std::shared_ptr<AssetSubscription>& subscription)
+        :_request(request), _subscription(subscription) {}
+
+    inline bool isValid() const { return _request != nullptr; }
+    inline const std::string& path() const { return _request->path(); }
+
+    // A handle that has been cancelled is cancelled, even if the request is still being
+    // decoded for other handles
+    inline bool isCancelled() const { return _subscription && _subscription->cancelled.load(); }
+    inline AssetStatus status() const { return isCancelled() ? AssetStatus::Cancelled : _request->status(); }
+    inline bool isDone() const { return isCancelled() || _request->isDone(); }
+
+    inline void wait() const
+    {
+        if (!isCancelled())
+        {
+            _request->wait();
+        }
+    }
+
+    // Blocks until the asset is decoded. Rethrows the decoder exception, or throws
+    // AssetCancelledError
+    inline std::shared_ptr<T> get() const
+    {
+        if (isCancelled())
+        {
+            throw AssetCancelledError(path());
+        }
+        return std::static_pointer_cast<T>(_request->result());
+    }
+
+    inline const std::shared_ptr<AssetRequest>& request() const { return _request; }
+    inline const std::shared_ptr<AssetSubscription>& subscription() const { return _subscription; }
+
+protected:
+    std::shared_ptr<AssetRequest> _request;
+    std::shared_ptr<AssetSubscription> _subscription;
+};
+
+// Decodes assets on a set of worker threads. Concurrent requests for the same path and
+// asset type share the same decode, and completion callbacks are called from
+// dispatchCallbacks(), that must be called from the main loop thread.
+class BG2E_EXPORT AssetLoader
+{
+public:
+    template <typename T>
+    using Decoder = std::function<std::shared_ptr<T>(const std::string&)>;
+
+    template <typename T>
+    using Callback = std::function<void(const AssetHandle<T>&)>;
+
+    // Zero threads uses one thread less than the hardware concurrency
+    AssetLoader(size_t threadCount = 0);
+
+    // Pending requests are cancelled, and the requests being decoded are completed
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Loader used by the engine. MainLoop dispatches its callbacks once per frame
+    static AssetLoader& shared();
+
+    inline size_t threadCount() const { return _workers.size(); }
+
+    template <typename T>
+    AssetHandle<T> load(
+        const std::string& path,
+        const Decoder<T>& decoder,
+        AssetPriority priority = AssetPriority::Normal,
+        const Callback<T>& callback = nullptr)
+    {
+        auto subscription = std::make_shared<AssetSubscription>();
+        if (callback)
+        {
+            subscription->callback = [callback](AssetRequest& request) {
+                callback(AssetHandle<T>(request.shared_from_this()));
+            };
+        }
+        auto request = enqueue(
+            path,
+            path + "\n" + typeid(T).name(),
+            [decoder, path]() { return std::static_pointer_cast<void>(decoder(path)); },
+            priority,
+            subscription);
+        return AssetHandle<T>(request, subscription);
+    }
+
+    // Image::LoadFromFile() on a worker thread
+    AssetHandle<Image> loadImage(
+        const std::string& path,
+        AssetPriority priority = AssetPriority::Normal,
+        const Callback<Image>& callback = nullptr);
+
+    // Bg2Reader::load() on a worker thread
+    AssetHandle<Bg2Reader> loadBg2Model(
+        const std::string& path,
+        AssetPriority priority = AssetPriority::Normal,
+        const Callback<Bg2Reader>& callback = nullptr);
+
+    // Changes the priority of a pending request
+    void setPriority(const std::shared_ptr<AssetRequest>& request, AssetPriority priority);
+
+    // Cancels the request for all its handles. A pending request is cancelled immediately.
+    // A request that is being decoded is cancelled when the decoder returns, and its result
+    // is discarded. Returns false if the request is already done
+    bool cancel(const std::shared_ptr<AssetRequest>& request);
+
+    template <typename T>
+    inline void setPriority(const AssetHandle<T>& handle, AssetPriority priority) { setPriority(handle.request(), priority); }
+
+    // Cancels the handle, and the handles copied from it. If other load() calls share the
+    // request, the handle is only detached: its callback is not called, and the asset is
+    // still decoded for the rest. The request is cancelled with its last handle. Returns
+    // false if the handle or the request are already done
+    template <typename T>
+    inline bool cancel(const AssetHandle<T>& handle)
+    {
+        return handle.subscription() ? cancel(handle.request(), handle.subscription()) : cancel(handle.request());
+    }
+
+    // Calls the callbacks of the requests that are done, including failed and cancelled
+    // requests, in completion order. Returns the number of requests dispatched
+    size_t dispatchCallbacks(size_t maxRequests = SIZE_MAX);
+
+    // Requests that are pending or being decoded
+    size_t activeRequestCount();
+
+protected:
+    struct QueueEntry
+    {
+        AssetPriority priority;
+        uint64_t sequence;
+        std::shared_ptr<AssetRequest> request;
+
+        inline bool operator<(const QueueEntry& other) const
+        {
+            return priority != other.priority ? priority > other.priority : sequence < other.sequence;
+        }
+    };
+
+    std::vector<std::thread> _workers;
+    std::set<QueueEntry> _queue;
+    std::unordered_map<std::string, std::shared_ptr<AssetRequest>> _activeRequests;
+    std::deque<std::shared_ptr<AssetRequest>> _completed;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    uint64_t _nextSequence = 0;
+    bool _stop = false;
+
+    std::shared_ptr<AssetRequest> enqueue(
+        const std::string& path,
+        const std::string& key,
+        std::function<std::shared_ptr<void>()>&& decode,
+        AssetPriority priority,
+        const std::shared_ptr<AssetSubscription>& subscription);
+
+    bool cancel(const std::shared_ptr<AssetRequest>& request, const std::shared_ptr<AssetSubscription>& subscription);
+
+    // Must be called with the mutex locked
+    bool cancelRequest(const std::shared_ptr<AssetRequest>& request);
+
+    void workerLoop();
+
+    // Must be called with the mutex locked
+    void finishCancelled(const std::shared_ptr<AssetRequest>& request);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef bg2e_base_bg2cookedmodel_hpp
+#define bg2e_base_bg2cookedmodel_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Cooked .bg2 files store each poly list as an interleaved vertex block and a uint32 index
+// block, in the host byte order and aligned to Bg2CookedBlockAlignment bytes from the start
+// of the file. The attributes of a vertex are float vectors, stored in BufferType order:
+// position (3), normal (3), texCoord0, texCoord1, texCoord2 (2), color (4) and tangent (3).
+// The levels of detail of the poly list follow the index block, as additional index blocks.
+const size_t Bg2CookedBlockAlignment = 16;
+
+// Size in bytes of the attribute, or zero if it is not a vertex attribute
+BG2E_EXPORT uint32_t bg2CookedAttributeSize(BufferType attribute);
+
+// Index block of a level of detail, and its estimated error relative to the full detail. See
+// PolyListLod
+struct Bg2CookedLod
+{
+    float error = 0.0f;
+    uint32_t indexCount = 0;
+    const uint32_t* indexData = nullptr;
+
+    inline size_t indexDataSize() const { return static_cast<size_t>(indexCount) * sizeof(uint32_t); }
+};
+
+// View of a poly list in a cooked file. The pointers refer to the file data
+struct Bg2CookedPolyList
+{
+    std::string_view name;
+    std::string_view materialName;
+
+    // BufferType flags of the vertex attributes
+    uint32_t attributes = 0;
+    uint32_t stride = 0;
+
+    uint32_t vertexCount = 0;
+    const Byte* vertexData = nullptr;
+
+    uint32_t indexCount = 0;
+    const uint32_t* indexData = nullptr;
+
+    PolyListBounds bounds;
+
+    // Levels of detail, from the most detailed
+    std::vector<Bg2CookedLod> lods;
+
+    inline size_t vertexDataSize() const { return static_cast<size_t>(vertexCount) * stride; }
+    inline size_t indexDataSize() const { return static_cast<size_t>(indexCount) * sizeof(uint32_t); }
+
+    // Offset of the attribute inside a vertex. The attribute must be present
+    uint32_t attributeOffset(BufferType attribute) const;
+};
+
+// Loader of cooked .bg2 files. The file is mapped in memory and the vertex and index blocks
+// are used in place, so they can be copied to a staging buffer without any per vertex work.
+// Only the chunk headers are validated; the index values are not checked.
+class BG2E_EXPORT Bg2CookedModel
+{
+public:
+    Bg2CookedModel();
+
+    Bg2CookedModel(const Bg2CookedModel&) = delete;
+    Bg2CookedModel& operator=(const Bg2CookedModel&) = delete;
+
+    // Throws std::runtime_error if the file can not be opened or it is not a valid cooked
+    // bg2 file. The file stays mapped until the model is cleared
+    void load(const std::string& path);
+
+    // Takes the ownership of a mapped file
+    void load(tools::MappedFile&& file);
+
+    // The data is not copied, and it must be valid while the model is used. It must be
+    // aligned to Bg2CookedBlockAlignment bytes
+    void load(const Byte* data, size_t size);
+
+    void clear();
+
+    inline const std::vector<Bg2CookedPolyList>& polyLists() const { return _polyLists; }
+
+    // List of material objects, and joint object of the model, or nullptr
+    inline const std::shared_ptr<tools::JsonNode>& materials() const { return _materials; }
+    inline const std::shared_ptr<tools::JsonNode>& joints() const { return _joints; }
+
+    // Copies the vertex and index blocks, and the levels of detail, to a PolyList
+    std::shared_ptr<PolyList> polyList(size_t index) const;
+
+protected:
+    tools::MappedFile _file;
+    std::vector<Bg2CookedPolyList> _polyLists;
+    std::shared_ptr<tools::JsonNode> _materials;
+    std::shared_ptr<tools::JsonNode> _joints;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef bg2e_base_bg2reader_hpp
+#define bg2e_base_bg2reader_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/Json.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Reader for the .bg2 chunked model format. The file is mapped in memory and each vertex
+// and index array is copied into its PolyList with a single bulk copy, converting the byte
+// order in the same pass if the file endianness does not match the host. A first pass finds
+// the chunks, and then the poly lists and the material JSON are decoded in parallel in the
+// shared thread pool.
+class BG2E_EXPORT Bg2Reader
+{
+public:
+    Bg2Reader();
+
+    // Throws std::runtime_error if the file can not be opened or it is not a valid bg2 file
+    void load(const std::string& path);
+    void load(const Byte* data, size_t size);
+
+    void clear();
+
+    // Decode the poly lists in the shared thread pool. Enabled by default
+    inline void setParallel(bool p) { _parallel = p; }
+    inline bool parallel() const { return _parallel; }
+
+    // Build the poly list tangents while loading. Disabled by default
+    inline void setGenerateTangents(bool t) { _generateTangents = t; }
+    inline bool generateTangents() const { return _generateTangents; }
+
+    inline const std::vector<std::shared_ptr<PolyList>>& polyLists() const { return _polyLists; }
+
+    // Material name of each poly list
+    inline const std::vector<std::string>& materialNames() const { return _materialNames; }
+
+    // Bounding box of each poly list
+    inline const std::vector<PolyListBounds>& bounds() const { return _bounds; }
+
+    // List of material objects, and joint object of the model. They are nullptr if the file
+    // does not include the chunk
+    inline const std::shared_ptr<tools::JsonNode>& materials() const { return _materials; }
+    inline const std::shared_ptr<tools::JsonNode>& joints() const { return _joints; }
+
+    inline uint8_t majorVersion() const { return _majorVersion; }
+    inline uint8_t minorVersion() const { return _minorVersion; }
+    inline uint8_t revision() const { return _revision; }
+
+protected:
+    std::vector<std::shared_ptr<PolyList>> _polyLists;
+    std::vector<std::string> _materialNames;
+    std::vector<PolyListBounds> _bounds;
+    std::shared_ptr<tools::JsonNode> _materials;
+    std::shared_ptr<tools::JsonNode> _joints;
+
+    uint8_t _majorVersion = 0;
+    uint8_t _minorVersion = 0;
+    uint8_t _revision = 0;
+
+    bool _parallel = true;
+    bool _generateTangents = false;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef bg2e_base_bg2writer_hpp
+#define bg2e_base_bg2writer_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/Json.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Writer for .bg2 models, in the chunked format read by Bg2Reader, or in the cooked format
+// read by Bg2CookedModel
+class BG2E_EXPORT Bg2Writer
+{
+public:
+    Bg2Writer();
+
+    void addPolyList(const std::shared_ptr<PolyList>& polyList, const std::string& materialName);
+
+    // List of material objects, and joint object of the model. The chunks are not written
+    // if they are nullptr
+    inline void setMaterials(const std::shared_ptr<tools::JsonNode>& m) { _materials = m; }
+    inline void setJoints(const std::shared_ptr<tools::JsonNode>& j) { _joints = j; }
+
+    // Byte order of the chunked format. Big endian by default, as the files written by the
+    // other bg2 engine tools. The cooked format always uses the host byte order
+    inline void setBigEndian(bool be) { _bigEndian = be; }
+    inline bool bigEndian() const { return _bigEndian; }
+
+    inline const std::vector<std::shared_ptr<PolyList>>& polyLists() const { return _polyLists; }
+    inline const std::vector<std::string>& materialNames() const { return _materialNames; }
+
+    void clear();
+
+    // Throws std::runtime_error if the file can not be written
+    void save(const std::string& path);
+    void write(std::vector<Byte>& result);
+
+    // Writes the poly lists as interleaved vertex blocks. Tangents are built if they are not
+    // valid, so the poly lists may be modified
+    void saveCooked(const std::string& path);
+    void writeCooked(std::vector<Byte>& result);
+
+protected:
+    std::vector<std::shared_ptr<PolyList>> _polyLists;
+    std::vector<std::string> _materialNames;
+    std::shared_ptr<tools::JsonNode> _materials;
+    std::shared_ptr<tools::JsonNode> _joints;
+    bool _bigEndian = true;
+};
+
+}
+}
+
+#endif
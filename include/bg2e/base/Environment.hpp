@@ -4,6 +4,9 @@
 #include <bg2e/export.hpp>
 
 #include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonReader.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/JsonFields.hpp>
 
 #include <string>
 #include <memory>
@@ -11,6 +14,18 @@
 namespace bg2e {
 namespace base {
 
+// Environment properties that need to be updated in the GPU
+typedef enum {
+    EnvironmentFieldEquirectangularTexture = 1 << 0,
+    EnvironmentFieldIrradianceIntensity = 1 << 1,
+    EnvironmentFieldShowSkybox = 1 << 2,
+    EnvironmentFieldCubemapSize = 1 << 3,
+    EnvironmentFieldIrradianceMapSize = 1 << 4,
+    EnvironmentFieldSpecularMapSize = 1 << 5,
+    EnvironmentFieldSpecularMapL2Size = 1 << 6,
+    EnvironmentFieldAll = (1 << 7) - 1
+} EnvironmentField;
+
 class BG2E_EXPORT Environment {
 public:
     Environment();
@@ -26,13 +41,18 @@ public:
     inline uint32_t specularMapSize() const { return _specularMapSize; }
     inline uint32_t specularMapL2Size() const { return _specularMapL2Size; }
 
-    inline void setEquirectangularTexture(const std::string& p) { _equirectangularTexture = p; _dirty = true; }
-    inline void setIrradianceIntensity(float p) { _irradianceIntensity = p; _dirty = true; }
-    inline void setShowSkybox(bool p) { _showSkybox = p; _dirty = true; }
-    inline void setCubemapSize(uint32_t p) { _cubemapSize = p; _dirty = true; }
-    inline void setIrradianceMapSize(uint32_t p) { _irradianceMapSize = p; _dirty = true; }
-    inline void setSpecularMapSize(uint32_t p) { _specularMapSize = p; _dirty = true; }
-    inline void setSpecularMapL2Size(uint32_t p) { _specularMapL2Size = p; _dirty = true; }
+    inline void setEquirectangularTexture(const std::string& p) { _equirectangularTexture = p; _dirtyFields |= EnvironmentFieldEquirectangularTexture; }
+    inline void setIrradianceIntensity(float p) { _irradianceIntensity = p; _dirtyFields |= EnvironmentFieldIrradianceIntensity; }
+    inline void setShowSkybox(bool p) { _showSkybox = p; _dirtyFields |= EnvironmentFieldShowSkybox; }
+    inline void setCubemapSize(uint32_t p) { _cubemapSize = p; _dirtyFields |= EnvironmentFieldCubemapSize; }
+    inline void setIrradianceMapSize(uint32_t p) { _irradianceMapSize = p; _dirtyFields |= EnvironmentFieldIrradianceMapSize; }
+    inline void setSpecularMapSize(uint32_t p) { _specularMapSize = p; _dirtyFields |= EnvironmentFieldSpecularMapSize; }
+    inline void setSpecularMapL2Size(uint32_t p) { _specularMapL2Size = p; _dirtyFields |= EnvironmentFieldSpecularMapL2Size; }
+
+    // EnvironmentField mask of the properties changed since the last call to setUpdated()
+    inline uint32_t dirtyFields() const { return _dirtyFields; }
+    inline bool dirty() const { return _dirtyFields != 0; }
+    inline void setUpdated() { _dirtyFields = 0; }
 
     std::shared_ptr<Environment> clone()
     {
@@ -55,9 +75,34 @@ public:
     
     void deserialize(const std::shared_ptr<tools::JsonNode>&);
 
+    void deserialize(tools::JsonReader&);
+
     void serialize(tools::JsonObject&);
 
+    void serialize(tools::JsonWriter&);
+
+    // Applies a JSON merge patch with the same keys used by serialize(). Returns the
+    // EnvironmentField mask of the properties whose value has changed, and adds it to
+    // dirtyFields()
+    uint32_t applyPatch(tools::JsonNode& patch);
+
 protected:
+    friend class tools::JsonFieldSet<Environment>;
+
+    // Same order as the EnvironmentField bits
+    static constexpr auto jsonFields()
+    {
+        return std::make_tuple(
+            tools::jsonField("equirectangularTexture", &Environment::_equirectangularTexture),
+            tools::jsonField("irradianceIntensity", &Environment::_irradianceIntensity),
+            tools::jsonField("showSkybox", &Environment::_showSkybox),
+            tools::jsonField("cubemapSize", &Environment::_cubemapSize),
+            tools::jsonField("irradianceMapSize", &Environment::_irradianceMapSize),
+            tools::jsonField("specularMapSize", &Environment::_specularMapSize),
+            tools::jsonField("specularMapL2Size", &Environment::_specularMapL2Size)
+        );
+    }
+
     std::string _equirectangularTexture = "";
     float _irradianceIntensity = 1.0f;
     bool _showSkybox = true;
@@ -66,7 +111,7 @@ protected:
     uint32_t _specularMapSize = 32;
     uint32_t _specularMapL2Size = 32;
     
-    bool _dirty = true;
+    uint32_t _dirtyFields = EnvironmentFieldAll;
 };
 
 }
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <mutex>
 
 namespace bg2e {
 namespace base {
@@ -90,6 +91,7 @@ protected:
     ImageComponentFormat _format = ImageComponentFormat::RGB;
     
     static std::unordered_map<std::string,std::shared_ptr<Image>> g_imageCache;
+    static std::mutex g_imageCacheMutex;
 
 private:
     enum class ImageSource {
@@ -5,6 +5,9 @@
 
 #include <bg2e/export.hpp>
 #include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonReader.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/JsonFields.hpp>
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
@@ -22,6 +25,21 @@ typedef enum {
     LightTypePoint = 5
 } LightType;
 
+// Light properties changed by Light::applyPatch()
+typedef enum {
+    LightFieldPosition = 1 << 0,
+    LightFieldDirection = 1 << 1,
+    LightFieldSpotCutoff = 1 << 2,
+    LightFieldSpotExponent = 1 << 3,
+    LightFieldShadowStrength = 1 << 4,
+    LightFieldProjection = 1 << 5,
+    LightFieldCastShadows = 1 << 6,
+    LightFieldShadowBias = 1 << 7,
+    LightFieldType = 1 << 8,
+    LightFieldColor = 1 << 9,
+    LightFieldIntensity = 1 << 10
+} LightField;
+
 class BG2E_EXPORT Light
 {
 public:
@@ -77,11 +95,55 @@ public:
     }
 
     void deserialize(const std::shared_ptr<tools::JsonNode>&);
+
+    // Decodes the object at the current reader position, without building a JSON tree
+    void deserialize(tools::JsonReader&);
     
     void serialize(tools::JsonObject&);
+
+    // Writes the object directly to the writer output, without building a JsonObject
+    void serialize(tools::JsonWriter&);
+
+    // Applies a JSON merge patch with the same keys used by serialize(). Returns the
+    // LightField mask of the properties whose value has changed
+    uint32_t applyPatch(tools::JsonNode& patch);
     
     
 protected:
+    friend class tools::JsonFieldSet<Light>;
+
+    // Fields with a direct mapping to a member, in the same order as the LightField bits. The
+    // light type, color and intensity keys depend on each other, and they are resolved after
+    // reading the object
+    static constexpr auto jsonFields()
+    {
+        return std::make_tuple(
+            tools::jsonField("position", &Light::_position),
+            tools::jsonField("direction", &Light::_direction),
+            tools::jsonField("spotCutoff", &Light::_spotCutoff),
+            tools::jsonField("spotExponent", &Light::_spotExponent),
+            tools::jsonField("shadowStrength", &Light::_shadowStrength),
+            tools::jsonField("projection", &Light::_projection),
+            tools::jsonField("castShadows", &Light::_castShadows),
+            tools::jsonField("shadowBias", &Light::_shadowBias)
+        );
+    }
+
+    struct ColorData
+    {
+        int32_t type = LightTypeDirectional;
+        bool hasDiffuse = false;
+        bool hasColor = false;
+        bool hasIntensity = false;
+        glm::vec4 diffuse;
+        glm::vec4 color;
+        float intensity = 0.0f;
+    };
+
+    bool readColorData(std::string_view key, tools::JsonNode& value, ColorData&);
+    void resolveType(int32_t type);
+    void resolveColor(const ColorData&);
+
 	bool _enabled;
 
     LightType _type = LightTypeDirectional;
@@ -2,6 +2,12 @@
 #define bg2e_base_material_hpp
 
 #include <bg2e/export.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonReader.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/JsonFields.hpp>
+
+#include <memory>
 
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
@@ -19,11 +25,35 @@ class BG2E_EXPORT Material
 public:
     Material();
     
+    inline const glm::vec4& diffuse() const { return _diffuse; }
+    inline const glm::vec2& diffuseScale() const { return _diffuseScale; }
+    
+    inline void setDiffuse(const glm::vec4& v) { _diffuse = v; }
+    inline void setDiffuseScale(const glm::vec2& v) { _diffuseScale = v; }
+    
+    void deserialize(const std::shared_ptr<tools::JsonNode>&);
+    
+    void deserialize(tools::JsonReader&);
+    
+    void serialize(tools::JsonObject&);
+    
+    void serialize(tools::JsonWriter&);
+    
 protected:
+    friend class tools::JsonFieldSet<Material>;
+    
+    static constexpr auto jsonFields()
+    {
+        return std::make_tuple(
+            tools::jsonField("diffuse", &Material::_diffuse),
+            tools::jsonField("diffuseScale", &Material::_diffuseScale)
+        );
+    }
+    
     MaterialType type = MaterialTypePBR;
     
-    glm::vec4 _diffuse;
-    glm::vec2 _diffuseScale;
+    glm::vec4 _diffuse = glm::vec4{1.0f, 1.0f, 1.0f, 1.0f};
+    glm::vec2 _diffuseScale = glm::vec2{1.0f, 1.0f};
     
 };
 
@@ -0,0 +1,88 @@
+#ifndef bg2e_base_meshoptimizer_hpp
+#define bg2e_base_meshoptimizer_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/base/PolyList.hpp>
+
+#include <vector>
+
+namespace bg2e {
+namespace base {
+
+// Post transform vertex cache efficiency of an index buffer, with a FIFO cache
+struct VertexCacheStats
+{
+    // Average cache miss ratio: transformed vertices per triangle. 0.5 is the best possible
+    // value for large regular meshes, and 3 the worst
+    float acmr = 0.0f;
+
+    // Average transformed to vertex ratio: transformed vertices per referenced vertex. The
+    // best value is 1
+    float atvr = 0.0f;
+
+    size_t transformedVertices = 0;
+};
+
+struct MeshOptimizerResult
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Reorders the triangles and vertices of poly lists for the GPU. The triangle order is
+// optimized for the post transform vertex cache with Tipsify (Sander et al. 2007) and,
+// optionally, the clusters of the result are sorted to draw the outer surfaces first and
+// reduce the overdraw. Then the vertices are sorted by first use, to fetch the vertex data
+// in order. The levels of detail of the poly list are also sorted for the vertex cache. The
+// shape of the mesh does not change. Only DrawModeTriangles poly lists are optimized; the
+// rest are not modified.
+class BG2E_EXPORT MeshOptimizer
+{
+public:
+    MeshOptimizer();
+
+    // Size of the simulated FIFO vertex cache. 16 by default
+    inline void setCacheSize(uint32_t size) { _cacheSize = size; }
+    inline uint32_t cacheSize() const { return _cacheSize; }
+
+    // Sort the triangle clusters to reduce the overdraw. Enabled by default
+    inline void setOptimizeOverdraw(bool o) { _optimizeOverdraw = o; }
+    inline bool optimizeOverdraw() const { return _optimizeOverdraw; }
+
+    // Maximum ACMR increase allowed by the overdraw pass. 1.05 by default: the clusters are
+    // split while the ACMR is less than 5% worse than the vertex cache order
+    inline void setOverdrawThreshold(float t) { _overdrawThreshold = t; }
+    inline float overdrawThreshold() const { return _overdrawThreshold; }
+
+    // Runs all the passes. Throws std::runtime_error if an index is out of range
+    MeshOptimizerResult optimize(PolyList& plist) const;
+
+    void optimizeVertexCache(PolyList& plist) const;
+    void optimizeOverdraw(PolyList& plist) const;
+
+    // Sorts the vertices of all the attribute streams by first use in the index buffer, and
+    // removes the vertices that are not used. The vertices used only by the levels of detail
+    // are kept, after the ones of the index buffer
+    void optimizeVertexFetch(PolyList& plist) const;
+
+    static VertexCacheStats analyzeVertexCache(const PolyList& plist, uint32_t cacheSize = 16);
+
+protected:
+    uint32_t _cacheSize = 16;
+    bool _optimizeOverdraw = true;
+    float _overdrawThreshold = 1.05f;
+
+    // Tipsify order of the triangles. If clusters is not null, it receives the first triangle
+    // of each cluster, that starts where the fanning vertex is not in the cache
+    std::vector<uint32_t> tipsify(const std::vector<uint32_t>& index, size_t vertexCount, std::vector<uint32_t>* clusters) const;
+
+    // Index buffer sorted in the tipsify order
+    std::vector<uint32_t> vertexCacheOrder(const std::vector<uint32_t>& index, size_t vertexCount) const;
+
+    void optimizeLods(PolyList& plist) const;
+};
+
+}
+}
+
+#endif
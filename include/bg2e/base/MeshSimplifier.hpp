@@ -0,0 +1,64 @@
+#ifndef bg2e_base_meshsimplifier_hpp
+#define bg2e_base_meshsimplifier_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/base/PolyList.hpp>
+
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Poly list simplifier based on quadric error metrics (Garland and Heckbert 1997). Edges
+// are collapsed into one of their vertices, so the result is an index buffer that uses the
+// vertices of the poly list. Vertices with the same position and different attributes are
+// seams: they are only collapsed along the seam, and both sides move together. Border
+// vertices are only collapsed along the border, with an additional error term that keeps
+// its shape, and vertices with more complex topology are not moved.
+// The error of a collapse is the root mean square distance from the new position to the
+// planes of the collapsed triangles, weighted by area, including the border terms. It is
+// relative to the largest side of the bounding box, and it is an estimate, not a bound of
+// the maximum distance to the original surface.
+class BG2E_EXPORT MeshSimplifier
+{
+public:
+    MeshSimplifier();
+
+    // Do not move the border vertices. Disabled by default
+    inline void setLockBorder(bool l) { _lockBorder = l; }
+    inline bool lockBorder() const { return _lockBorder; }
+
+    // Simplifies the triangles of index, that must use the vertices of the poly list, until
+    // the triangle count is targetTriangleCount or the next collapse exceeds targetError.
+    // The largest collapse error is stored in resultError if it is not null. Throws
+    // std::runtime_error if an index is out of range
+    std::vector<uint32_t> simplify(
+        const PolyList& plist,
+        const std::vector<uint32_t>& index,
+        size_t targetTriangleCount,
+        float targetError,
+        float* resultError = nullptr) const;
+
+    inline std::vector<uint32_t> simplify(const PolyList& plist, size_t targetTriangleCount, float targetError, float* resultError = nullptr) const
+    {
+        return simplify(plist, plist.index(), targetTriangleCount, targetError, resultError);
+    }
+
+    // Stores a chain of up to maxLevels levels of detail in the poly list. Each level has
+    // about `ratio` times the triangles of the previous one. The error of a level is the sum
+    // of the errors of the previous levels. The chain ends when the error would exceed
+    // maxError, or when the simplification does not make progress
+    void buildLods(PolyList& plist, size_t maxLevels = 4, float ratio = 0.5f, float maxError = 0.05f) const;
+
+    // Builds the levels of detail of each poly list in the shared thread pool
+    void buildLods(const std::vector<std::shared_ptr<PolyList>>& polyLists, size_t maxLevels = 4, float ratio = 0.5f, float maxError = 0.05f) const;
+
+protected:
+    bool _lockBorder = false;
+};
+
+}
+}
+
+#endif
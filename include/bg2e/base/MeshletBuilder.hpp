@@ -0,0 +1,115 @@
+#ifndef bg2e_base_meshletbuilder_hpp
+#define bg2e_base_meshletbuilder_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/base/PolyList.hpp>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Range of a meshlet in the vertex and triangle arrays of PolyListMeshlets. The triangle
+// offset is a byte offset, and it is a multiple of four
+struct Meshlet
+{
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+};
+
+// Bounding sphere and normal cone of a meshlet. All the triangles of the meshlet face away
+// from a camera at position p if dot(normalize(coneApex - p), coneAxis) > coneCutoff. The
+// cutoff is 1 if the normals are too different to be culled. The members are aligned as
+// vec4 pairs, so the array can be copied to a std430 storage buffer
+struct MeshletBounds
+{
+    glm::vec3 center{ 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+    glm::vec3 coneApex{ 0.0f, 0.0f, 0.0f };
+    float coneCutoff = 1.0f;
+    glm::vec3 coneAxis{ 0.0f, 0.0f, 0.0f };
+    float padding = 0.0f;
+};
+
+// Meshlets of a poly list. vertices contains the poly list vertex index of each meshlet
+// vertex, and triangles contains three local vertex indexes for each meshlet triangle
+struct PolyListMeshlets
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+// Planes of a view frustum, pointing inside. The planes are normalized
+struct MeshletFrustum
+{
+    glm::vec4 planes[6];
+
+    // Extracts the planes of a projection matrix with the Vulkan clip space, where the depth
+    // range is [0, 1]. With a model view projection matrix, the planes are in model space
+    static MeshletFrustum fromMatrix(const glm::mat4& viewProjection);
+
+    inline bool sphereVisible(const glm::vec3& center, float radius) const
+    {
+        for (const auto& p : planes)
+        {
+            if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Splits a poly list into meshlets: small clusters of adjacent triangles that can be culled
+// and drawn independently. The triangles are added greedily to the current meshlet, choosing
+// the ones that add the fewest vertices, and the ones closer to the meshlet center. The
+// input triangle order is kept as far as possible, so the poly list should be optimized
+// with MeshOptimizer first.
+class BG2E_EXPORT MeshletBuilder
+{
+public:
+    MeshletBuilder();
+
+    // Maximum vertices of a meshlet, up to 256. 64 by default
+    inline void setMaxVertices(uint32_t v) { _maxVertices = v; }
+    inline uint32_t maxVertices() const { return _maxVertices; }
+
+    // Maximum triangles of a meshlet, up to 512. 124 by default
+    inline void setMaxTriangles(uint32_t t) { _maxTriangles = t; }
+    inline uint32_t maxTriangles() const { return _maxTriangles; }
+
+    // Throws std::runtime_error if the poly list is not a triangle list, if an index is out
+    // of range or if the limits are not valid
+    PolyListMeshlets build(const PolyList& plist) const;
+
+    // Builds the meshlets of each poly list in the shared thread pool
+    std::vector<PolyListMeshlets> build(const std::vector<std::shared_ptr<PolyList>>& polyLists) const;
+
+    // Stores in visible the meshlets that are inside the frustum and that are not facing
+    // away from the camera. The frustum and the camera position must be in the space of the
+    // poly list. Returns the visible meshlet count
+    static size_t cull(
+        const PolyListMeshlets& meshlets,
+        const MeshletFrustum& frustum,
+        const glm::vec3& cameraPosition,
+        std::vector<uint32_t>& visible);
+
+protected:
+    uint32_t _maxVertices = 64;
+    uint32_t _maxTriangles = 124;
+};
+
+}
+}
+
+#endif
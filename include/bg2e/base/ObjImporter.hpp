@@ -0,0 +1,56 @@
+#ifndef bg2e_base_objimporter_hpp
+#define bg2e_base_objimporter_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/Json.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace bg2e {
+namespace base {
+
+// Wavefront OBJ importer. The file is parsed with tinyobjloader, and each shape is split
+// in one PolyList per material. The position, normal and texture coordinate index triples
+// of the face corners are welded into shared vertices, and the poly lists are built in
+// parallel in the shared thread pool.
+class BG2E_EXPORT ObjImporter
+{
+public:
+    ObjImporter();
+
+    // Throws std::runtime_error if the file can not be loaded. The .mtl files are searched
+    // in the directory of the OBJ file
+    void load(const std::string& path);
+
+    void clear();
+
+    // Paths of the .mtl files named in the mtllib lines of an OBJ file, without loading the
+    // geometry. Throws std::runtime_error if the file can not be read
+    static std::vector<std::string> materialLibraries(const std::string& path);
+
+    inline const std::vector<std::shared_ptr<PolyList>>& polyLists() const { return _polyLists; }
+
+    // Material name of each poly list
+    inline const std::vector<std::string>& materialNames() const { return _materialNames; }
+
+    // List of material objects, with the same fields as the materials of .bg2 files, so
+    // the result can be saved with Bg2Writer
+    inline const std::shared_ptr<tools::JsonNode>& materials() const { return _materials; }
+
+    // Warnings reported by tinyobjloader
+    inline const std::string& warnings() const { return _warnings; }
+
+protected:
+    std::vector<std::shared_ptr<PolyList>> _polyLists;
+    std::vector<std::string> _materialNames;
+    std::shared_ptr<tools::JsonNode> _materials;
+    std::string _warnings;
+};
+
+}
+}
+
+#endif
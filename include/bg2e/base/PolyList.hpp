@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <utility>
 
 namespace bg2e {
 namespace base {
@@ -91,6 +92,21 @@ typedef enum {
     CullFaceFrontAndBack
 } PolyListCullFace;
 
+// Axis aligned bounding box of the vertex positions
+struct PolyListBounds {
+    glm::vec3 min{ 0.0f, 0.0f, 0.0f };
+    glm::vec3 max{ 0.0f, 0.0f, 0.0f };
+};
+
+// Simplified level of detail of a poly list. It uses the vertices of the poly list. The error
+// is a quadric estimate of the deviation from the full detail surface, relative to the largest
+// side of the bounding box, so it can be compared with the projected size of the poly list.
+// It is not a bound of the maximum distance: see MeshSimplifier
+struct PolyListLod {
+    std::vector<uint32_t> index;
+    float error = 0.0f;
+};
+
 class PolyList {
 public:
     PolyList();
@@ -135,26 +151,55 @@ public:
         return _tangent;
     }
 
+    // Sign of the bitangent of each vertex: bitangent = cross(normal, tangent) * handedness
+    inline const std::vector<float>& tangentHandedness() const {
+        if (!validTangents())
+        {
+            throw std::runtime_error("PolyList::tangentHandedness(): Invalid tangents. Call assertValidTangents() before get the handedness vector.");
+        }
+        return _tangentHandedness;
+    }
+
     inline void setVertex(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_vertex)); }
-    inline void setVertex(std::vector<float>&& v) { _vertex = v; }
+    inline void setVertex(std::vector<float>&& v) { _vertex = std::move(v); }
     inline void setNormal(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_normal)); }
-    inline void setNormal(std::vector<float>&& v) { _normal = v; }
+    inline void setNormal(std::vector<float>&& v) { _normal = std::move(v); }
     inline void setTexCoord0(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_texCoord0)); }
-    inline void setTexCoord0(std::vector<float>&& v) { _texCoord0 = v; }
+    inline void setTexCoord0(std::vector<float>&& v) { _texCoord0 = std::move(v); }
     inline void setTexCoord1(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_texCoord1)); }
-    inline void setTexCoord1(std::vector<float>&& v) { _texCoord1 = v; }
+    inline void setTexCoord1(std::vector<float>&& v) { _texCoord1 = std::move(v); }
     inline void setTexCoord2(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_texCoord2)); }
-    inline void setTexCoord2(std::vector<float>&& v) { _texCoord2 = v; }
+    inline void setTexCoord2(std::vector<float>&& v) { _texCoord2 = std::move(v); }
     inline void setColor(const std::vector<float>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_color)); }
-    inline void setColor(std::vector<float>&& v) { _color = v; }
+    inline void setColor(std::vector<float>&& v) { _color = std::move(v); }
     inline void setIndex(const std::vector<uint32_t>& v) { std::copy(v.begin(), v.end(), std::back_inserter(_index)); }
-    inline void setIndex(std::vector<uint32_t>&& v) { _index = v; }
+    inline void setIndex(std::vector<uint32_t>&& v) { _index = std::move(v); }
+
+    // Levels of detail, from the most detailed to the simplest. The poly list index is the
+    // level zero, and it is not included
+    inline const std::vector<PolyListLod>& lods() const { return _lods; }
+    inline void setLods(const std::vector<PolyListLod>& lods) { _lods = lods; }
+    inline void setLods(std::vector<PolyListLod>&& lods) { _lods = std::move(lods); }
     
     void assertValidTangents();
     
     bool validTangents() const;
 
-    void rebuildTangents();
+    // Builds the per vertex tangents from the texCoord0 gradients of the triangles, weighted
+    // by the triangle area and orthonormalized against the normals. Large meshes are split in
+    // ranges in the shared thread pool; the result is the same with any thread count.
+    // Throws std::runtime_error if an index is out of range
+    void rebuildTangents(bool parallel = true);
+
+    // Returns an empty box at the origin if there are no vertices
+    PolyListBounds computeBounds() const;
+
+    // Moves the vertex i to remap[i] in all the vertex attributes, including the tangents, and
+    // updates the indices and the levels of detail. The vertices with remap[i] == RemovedVertex
+    // are discarded. Throws std::runtime_error if an index refers to a removed vertex or it is
+    // out of range
+    static constexpr uint32_t RemovedVertex = 0xFFFFFFFF;
+    void remapVertices(const std::vector<uint32_t>& remap, size_t newVertexCount);
     
 protected:
     RenderLayers _renderLayers = RenderLayerAuto;
@@ -178,8 +223,10 @@ protected:
     std::vector<float> _color;
     
     std::vector<uint32_t> _index;
+    std::vector<PolyListLod> _lods;
     
     std::vector<float> _tangent;
+    std::vector<float> _tangentHandedness;
     bool _rebuildTangents = true;
 };
 
@@ -5,6 +5,8 @@
 #include <bg2e/types.hpp>
 
 #include <bg2e/base/Image.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonFields.hpp>
 
 #include <glm/vec4.hpp>
 
@@ -83,6 +85,52 @@ enum class TextureChannel {
     A = 4
 };
 
+// Valid values of the enumerations read from JSON, see tools::jsonEnumValue()
+constexpr bool jsonEnumValid(TextureWrap value)
+{
+    return value >= TextureWrap::Repeat && value <= TextureWrap::MirroredRepeat;
+}
+
+constexpr bool jsonEnumValid(TextureFilter value)
+{
+    return value >= TextureFilter::NearestMipmapNearest && value <= TextureFilter::Linear;
+}
+
+constexpr bool jsonEnumValid(TextureTarget value)
+{
+    return value == TextureTarget::Texture2D || value == TextureTarget::CubeMap;
+}
+
+constexpr bool jsonEnumValid(TextureRenderTargetAttachment value)
+{
+    return (value >= TextureRenderTargetAttachment::ColorAttachment0 && value <= TextureRenderTargetAttachment::ColorAttachment15) ||
+        value == TextureRenderTargetAttachment::DepthAttachment ||
+        value == TextureRenderTargetAttachment::StencilAttachment;
+}
+
+constexpr bool jsonEnumValid(TextureComponentFormat value)
+{
+    return value == TextureComponentFormat::UnsignedByte || value == TextureComponentFormat::Float32;
+}
+
+// Texture properties that need to be updated in the GPU
+enum TextureField
+{
+    TextureFieldWrapModeX = 1 << 0,
+    TextureFieldWrapModeY = 1 << 1,
+    TextureFieldMagFilter = 1 << 2,
+    TextureFieldMinFilter = 1 << 3,
+    TextureFieldTarget = 1 << 4,
+    TextureFieldFileName = 1 << 5,
+    TextureFieldChannels = 1 << 6,
+    TextureFieldRenderTargetAttachment = 1 << 7,
+    TextureFieldComponentFormat = 1 << 8,
+    TextureFieldSize = 1 << 9,
+    TextureFieldDataType = 1 << 10,
+    TextureFieldProceduralFunction = 1 << 11,
+    TextureFieldAll = (1 << 12) - 1
+};
+
 class ProceduralTextureFunction {
 public:
     ProceduralTextureFunction() {}
@@ -101,12 +149,18 @@ public:
     
     bool dirty() const
     {
-        return _dirty;
+        return _dirtyFields != 0;
+    }
+    
+    // TextureField mask of the properties changed since the last call to setUpdated()
+    uint32_t dirtyFields() const
+    {
+        return _dirtyFields;
     }
     
     void setUpdated(bool u)
     {
-        _dirty = !u;
+        _dirtyFields = u ? 0 : TextureFieldAll;
     }
     
     inline void setDataType(TextureDataType t)
@@ -118,7 +172,7 @@ public:
         }
         setMagFilter(TextureFilter::Linear);
         setMinFilter(TextureFilter::Linear);
-        _dirty = true;
+        _dirtyFields |= TextureFieldDataType;
     }
     
     inline TextureDataType dataType() const
@@ -134,13 +188,13 @@ public:
     inline void setWrapModeX(TextureWrap m)
     {
         _wrapModeX = m;
-        _dirty = true;
+        _dirtyFields |= TextureFieldWrapModeX;
     }
     
     inline void setWrapModeY(TextureWrap m)
     {
         _wrapModeY = m;
-        _dirty = true;
+        _dirtyFields |= TextureFieldWrapModeY;
     }
         
     inline TextureWrap wrapModeY() const
@@ -152,13 +206,13 @@ public:
     {
         _wrapModeX = m;
         _wrapModeY = m;
-        _dirty = true;
+        _dirtyFields |= TextureFieldWrapModeX | TextureFieldWrapModeY;
     }
     
     inline void setMagFilter(TextureFilter f)
     {
         _magFilter = f;
-        _dirty = true;
+        _dirtyFields |= TextureFieldMagFilter;
     }
     
     inline TextureFilter magFilter() const
@@ -169,7 +223,7 @@ public:
     inline void setMinFilter(TextureFilter f)
     {
         _minFilter = f;
-        _dirty = true;
+        _dirtyFields |= TextureFieldMinFilter;
     }
     
     inline TextureFilter minFilter() const
@@ -180,7 +234,7 @@ public:
     inline void setTarget(TextureTarget t)
     {
         _target = t;
-        _dirty = true;
+        _dirtyFields |= TextureFieldTarget;
     }
     
     inline TextureTarget target() const
@@ -191,13 +245,13 @@ public:
     inline void setSize(const Size& s)
     {
         _size = s;
-        _dirty = true;
+        _dirtyFields |= TextureFieldSize;
     }
     
     inline void setSize(Size&& s)
     {
         _size = s;
-        _dirty = true;
+        _dirtyFields |= TextureFieldSize;
     }
     
     inline const Size& size() const
@@ -208,7 +262,7 @@ public:
     inline void setFileName(const std::string& fileName)
     {
         _fileName = fileName;
-        _dirty = true;
+        _dirtyFields |= TextureFieldFileName;
     }
     
     inline const std::string& fileName() const
@@ -219,7 +273,7 @@ public:
     inline void setChannels(uint32_t c)
     {
         _channels = c;
-        _dirty = true;
+        _dirtyFields |= TextureFieldChannels;
     }
     
     inline uint32_t channels() const
@@ -230,13 +284,13 @@ public:
     inline void setProceduralTextureFunction(std::shared_ptr<ProceduralTextureFunction> fn)
     {
         _proceduralTextureFunction = fn;
-        _dirty = true;
+        _dirtyFields |= TextureFieldProceduralFunction;
     }
     
     inline void setRenderTargetAttachment(TextureRenderTargetAttachment att)
     {
         _renderTargetAttachment = att;
-        _dirty = true;
+        _dirtyFields |= TextureFieldRenderTargetAttachment;
     }
     
     inline TextureRenderTargetAttachment renderTargetAttachment() const
@@ -247,7 +301,7 @@ public:
     inline void setComponentFormat(TextureComponentFormat fmt)
     {
         _componentFormat = fmt;
-        _dirty = true;
+        _dirtyFields |= TextureFieldComponentFormat;
     }
     
     inline TextureComponentFormat componentFormat() const
@@ -275,8 +329,31 @@ public:
     
     void loadImageData(bool refresh = false);
     
+    // Applies a JSON merge patch with the texture properties. Returns the TextureField mask
+    // of the properties whose value has changed, and adds it to dirtyFields(). Throws
+    // std::logic_error if an enumeration value is out of range
+    uint32_t applyPatch(tools::JsonNode& patch);
+    
 protected:
-    bool _dirty = true;
+    friend class tools::JsonFieldSet<Texture>;
+    
+    // Same order as the TextureField bits. The size is read as a [width, height] list
+    static constexpr auto jsonFields()
+    {
+        return std::make_tuple(
+            tools::jsonField("wrapModeX", &Texture::_wrapModeX),
+            tools::jsonField("wrapModeY", &Texture::_wrapModeY),
+            tools::jsonField("magFilter", &Texture::_magFilter),
+            tools::jsonField("minFilter", &Texture::_minFilter),
+            tools::jsonField("target", &Texture::_target),
+            tools::jsonField("fileName", &Texture::_fileName),
+            tools::jsonField("channels", &Texture::_channels),
+            tools::jsonField("renderTargetAttachment", &Texture::_renderTargetAttachment),
+            tools::jsonField("componentFormat", &Texture::_componentFormat)
+        );
+    }
+    
+    uint32_t _dirtyFields = TextureFieldAll;
     
     TextureDataType _dataType = TextureDataType::None;
     TextureWrap _wrapModeX = TextureWrap::Repeat;
@@ -285,7 +362,7 @@ protected:
     TextureFilter _minFilter = TextureFilter::Linear;
     TextureTarget _target = TextureTarget::Texture2D;
     Size _size;
-    uint32_t _channels;
+    uint32_t _channels = 0;
     std::string _fileName;
     std::shared_ptr<ProceduralTextureFunction> _proceduralTextureFunction;
     std::shared_ptr<Image> _image;
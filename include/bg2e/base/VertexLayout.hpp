@@ -0,0 +1,209 @@
+#ifndef bg2e_base_vertexlayout_hpp
+#define bg2e_base_vertexlayout_hpp
+
+#include <bg2e/types.hpp>
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bg2e {
+namespace base {
+
+// Vertex attributes of a VertexLayout. Each one reads a float stream of PolyList
+struct VertexPosition
+{
+    static constexpr BufferType type = BufferTypeVertex;
+    static constexpr uint32_t components = 3;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.vertex(); }
+};
+
+struct VertexNormal
+{
+    static constexpr BufferType type = BufferTypeNormal;
+    static constexpr uint32_t components = 3;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.normal(); }
+};
+
+struct VertexUV0
+{
+    static constexpr BufferType type = BufferTypeTexCoord0;
+    static constexpr uint32_t components = 2;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.texCoord0(); }
+};
+
+struct VertexUV1
+{
+    static constexpr BufferType type = BufferTypeTexCoord1;
+    static constexpr uint32_t components = 2;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.texCoord1(); }
+};
+
+struct VertexUV2
+{
+    static constexpr BufferType type = BufferTypeTexCoord2;
+    static constexpr uint32_t components = 2;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.texCoord2(); }
+};
+
+struct VertexColor
+{
+    static constexpr BufferType type = BufferTypeColor;
+    static constexpr uint32_t components = 4;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.color(); }
+};
+
+// PolyList::tangent() throws if the tangents are not valid
+struct VertexTangent
+{
+    static constexpr BufferType type = BufferTypeTangent;
+    static constexpr uint32_t components = 3;
+    static inline const std::vector<float>& stream(const PolyList& plist) { return plist.tangent(); }
+};
+
+// Location, offset and size of an attribute in the vertex. The components are 32 bit floats
+struct VertexAttributeFormat
+{
+    uint32_t location;
+    uint32_t offset;
+    uint32_t components;
+    BufferType type;
+};
+
+// Interleaved vertex format, with the attributes in the order of the template arguments,
+// for example VertexLayout<VertexPosition, VertexNormal, VertexUV0, VertexTangent>. The
+// attribute locations are the positions in the argument list. The stride and offsets are
+// compile time constants, so each attribute of a vertex is a fixed size copy, that the
+// compiler emits as vector loads and stores. If the attributes are in BufferType order,
+// the format is the same as the vertex blocks of Bg2CookedModel with those attributes.
+template <typename... Attributes>
+class VertexLayout
+{
+public:
+    static_assert(sizeof...(Attributes) > 0, "VertexLayout: at least one attribute is required");
+
+    static constexpr size_t attributeCount = sizeof...(Attributes);
+    static constexpr uint32_t stride = ((Attributes::components * sizeof(float)) + ...);
+
+    // BufferType flags of the attributes
+    static constexpr uint32_t attributes = (static_cast<uint32_t>(Attributes::type) | ...);
+
+    // Vertices packed by each parallel task
+    static constexpr size_t parallelGrain = 16384;
+
+    static constexpr std::array<VertexAttributeFormat, attributeCount> formats()
+    {
+        std::array<VertexAttributeFormat, attributeCount> result{};
+        uint32_t location = 0;
+        uint32_t offset = 0;
+        ((result[location] = VertexAttributeFormat{ location, offset, Attributes::components, Attributes::type },
+          offset += Attributes::components * sizeof(float),
+          ++location), ...);
+        return result;
+    }
+
+    template <typename Attribute>
+    static constexpr uint32_t offset()
+    {
+        static_assert((std::is_same_v<Attribute, Attributes> || ...), "VertexLayout: the attribute is not in the layout");
+        uint32_t result = 0;
+        bool found = false;
+        ((found = found || std::is_same_v<Attribute, Attributes>,
+          result += found ? 0 : Attributes::components * sizeof(float)), ...);
+        return result;
+    }
+
+    static inline size_t bufferSize(const PolyList& plist)
+    {
+        return plist.vertex().size() / 3 * stride;
+    }
+
+    // Writes the interleaved vertices of the poly list to the buffer, that can be a mapped
+    // staging buffer. The vertices are written in order and the buffer is never read. Empty
+    // streams are written as zeros. Throws std::runtime_error if the buffer is smaller than
+    // bufferSize(), or if a stream does not match the vertex count
+    static void pack(const PolyList& plist, void* buffer, size_t bufferSize, bool parallel = true)
+    {
+        const size_t vertexCount = plist.vertex().size() / 3;
+        if (bufferSize < vertexCount * stride)
+        {
+            throw std::runtime_error("VertexLayout::pack(): the buffer is too small for poly list '" + plist.name() + "'");
+        }
+
+        // Empty streams read the same zero vector for all the vertices
+        Streams streams;
+        size_t s = 0;
+        ((streams.data[s] = checkedStream<Attributes>(plist, vertexCount, streams.step[s]), ++s), ...);
+
+        Byte* dst = static_cast<Byte*>(buffer);
+        if (parallel && vertexCount > parallelGrain)
+        {
+            tools::ThreadPool::shared().parallelFor(vertexCount, parallelGrain, [&](size_t begin, size_t end) {
+                packRange(streams, dst, begin, end);
+            });
+        }
+        else
+        {
+            packRange(streams, dst, 0, vertexCount);
+        }
+    }
+
+    static inline std::vector<Byte> pack(const PolyList& plist, bool parallel = true)
+    {
+        std::vector<Byte> result(bufferSize(plist));
+        pack(plist, result.data(), result.size(), parallel);
+        return result;
+    }
+
+protected:
+    struct Streams
+    {
+        const float* data[attributeCount];
+        size_t step[attributeCount];
+    };
+
+    template <typename Attribute>
+    static const float* checkedStream(const PolyList& plist, size_t vertexCount, size_t& step)
+    {
+        static const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const std::vector<float>& stream = Attribute::stream(plist);
+        if (stream.empty())
+        {
+            step = 0;
+            return zero;
+        }
+        if (stream.size() != vertexCount * Attribute::components)
+        {
+            throw std::runtime_error("VertexLayout::pack(): invalid attribute size in poly list '" + plist.name() + "'");
+        }
+        step = Attribute::components;
+        return stream.data();
+    }
+
+    template <size_t... I>
+    static inline void packVertex(const Streams& streams, Byte* vertex, size_t index, std::index_sequence<I...>)
+    {
+        (std::memcpy(vertex + std::integral_constant<uint32_t, formats()[I].offset>::value, streams.data[I] + index * streams.step[I], Attributes::components * sizeof(float)), ...);
+    }
+
+    static void packRange(const Streams& streams, Byte* dst, size_t begin, size_t end)
+    {
+        Byte* vertex = dst + begin * stride;
+        for (size_t i = begin; i < end; ++i, vertex += stride)
+        {
+            packVertex(streams, vertex, i, std::index_sequence_for<Attributes...>{});
+        }
+    }
+};
+
+}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <bg2e/export.hpp>
 #include <bg2e/render/vulkan/PipelineLayout.hpp>
 #include <bg2e/render/vulkan/VulkanAPI.hpp>
+#include <bg2e/base/VertexLayout.hpp>
 
 #include <memory>
 #include <vector>
@@ -28,12 +29,23 @@ public:
     vk::Pipeline impl() const { return _pipeline;  }
 
     std::vector<vk::DynamicState> dynamicStates;
-    // TODO: pVertexBindingDescriptions
-    // TODO: pVertexAttributeDescriptions
+    std::vector<vk::VertexInputBindingDescription> vertexBindings;
+    std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
     vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
     vk::PipelineRasterizationStateCreateInfo rasterizer;
     // TODO: Multisample
     
+    // Adds the binding of a base::VertexLayout, and one attribute for each element of the
+    // layout, with the layout locations
+    template <typename Layout>
+    inline void addVertexLayout(uint32_t binding = 0, vk::VertexInputRate inputRate = vk::VertexInputRate::eVertex)
+    {
+        vertexBindings.push_back({ binding, Layout::stride, inputRate });
+        for (const auto& format : Layout::formats())
+        {
+            vertexAttributes.push_back({ format.location, binding, vertexFormat(format.components), format.offset });
+        }
+    }
     
     inline void setViewport(float x, float y, float w, float h, float minDepth = 0.0f, float maxDepth = 1.0f)
     {
@@ -96,6 +108,8 @@ public:
 protected:
     std::shared_ptr<PipelineLayout> _pipelineLayout;
 
+    static vk::Format vertexFormat(uint32_t floatComponents);
+
     vk::Viewport _viewport;
     vk::Rect2D _scissor;
     std::vector<vk::PipelineColorBlendAttachmentState> _colorBlendAttachments;
@@ -0,0 +1,23 @@
+#ifndef bg2e_tools_hash_hpp
+#define bg2e_tools_hash_hpp
+
+#include <bg2e/export.hpp>
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace bg2e {
+namespace tools {
+
+// XXH64 hash. The result is the same on every platform, so it can be stored in files
+BG2E_EXPORT uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t xxHash64(std::string_view data, uint64_t seed = 0) {
+    return xxHash64(data.data(), data.size(), seed);
+}
+
+}
+}
+
+#endif
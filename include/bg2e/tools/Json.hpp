@@ -2,13 +2,18 @@
 #define bg2e_tools_json_hpp
 
 #include <bg2e/export.hpp>
+#include <bg2e/tools/JsonToken.hpp>
 
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
+#include <initializer_list>
+#include <utility>
 #include <exception>
 #include <stdexcept>
 #include <memory>
+#include <span>
+#include <cstdint>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -20,7 +25,117 @@ namespace tools {
 
 class JsonNode;
 
-using JsonObject = std::map<std::string, std::shared_ptr<JsonNode>>;
+constexpr uint32_t jsonKeyHash(std::string_view key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : key) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Object key with a precomputed hash. A key created from a string only references it, so
+// the string must be valid while the key is used. Lookup keys can be created once and reused
+// with many objects:
+//
+//     static const JsonKey positionKey("position");
+//     auto position = lightData[positionKey];
+//
+// The keys stored in objects own their name: JsonObject copies the name of the keys that
+// do not own it, and JsonKeyTable shares it between all the keys with the same name.
+class BG2E_EXPORT JsonKey {
+public:
+    JsonKey() :_hash(jsonKeyHash("", 0)) {}
+    JsonKey(std::string_view name) :_name(name), _hash(jsonKeyHash(name, 0)) {}
+    JsonKey(const char* name) :JsonKey(std::string_view(name)) {}
+    JsonKey(const std::string& name) :JsonKey(std::string_view(name)) {}
+
+    // Key that owns a copy of the name
+    static JsonKey copy(std::string_view name);
+
+    inline std::string_view name() const { return _name; }
+    inline uint32_t hash() const { return _hash; }
+    inline bool ownsName() const { return _storage != nullptr; }
+
+    inline operator std::string_view() const { return _name; }
+
+    inline bool operator==(const JsonKey& other) const {
+        return _hash == other._hash &&
+            ((_name.data() == other._name.data() && _name.size() == other._name.size()) || _name == other._name);
+    }
+
+protected:
+    std::string_view _name;
+    uint32_t _hash;
+    std::shared_ptr<const std::string> _storage;
+};
+
+// Key interning table. The parsers use a table for each document, so that all the objects
+// share a single copy of every key name
+class BG2E_EXPORT JsonKeyTable {
+public:
+    JsonKey intern(std::string_view name);
+
+    inline size_t size() const { return _count; }
+
+    void clear();
+
+protected:
+    std::vector<JsonKey> _slots;
+    size_t _count = 0;
+};
+
+// Object members, in insertion order. Objects with more than IndexThreshold members also
+// keep an open addressing hash index, so that lookups only compare the keys that have the
+// same hash
+class BG2E_EXPORT JsonObject {
+public:
+    using value_type = std::pair<JsonKey, std::shared_ptr<JsonNode>>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    static const size_t IndexThreshold = 8;
+
+    JsonObject() {}
+    JsonObject(std::initializer_list<value_type> items);
+
+    inline size_t size() const { return _items.size(); }
+    inline bool empty() const { return _items.empty(); }
+
+    inline iterator begin() { return _items.begin(); }
+    inline iterator end() { return _items.end(); }
+    inline const_iterator begin() const { return _items.begin(); }
+    inline const_iterator end() const { return _items.end(); }
+
+    void clear();
+    void reserve(size_t size);
+
+    inline iterator find(const JsonKey& key) { return _items.begin() + findItem(key); }
+    inline const_iterator find(const JsonKey& key) const { return _items.begin() + findItem(key); }
+    inline size_t count(const JsonKey& key) const { return findItem(key) < _items.size() ? 1 : 0; }
+    inline bool contains(const JsonKey& key) const { return findItem(key) < _items.size(); }
+
+    // Inserts a null value if the key is not found
+    std::shared_ptr<JsonNode>& operator[](const JsonKey& key);
+
+    // Throws std::out_of_range if the key is not found
+    std::shared_ptr<JsonNode>& at(const JsonKey& key);
+    const std::shared_ptr<JsonNode>& at(const JsonKey& key) const;
+
+    // Returns the number of removed items
+    size_t erase(const JsonKey& key);
+
+protected:
+    std::vector<value_type> _items;
+
+    // Item index plus one, or zero for empty slots
+    std::vector<uint32_t> _index;
+
+    // Returns size() if the key is not found
+    size_t findItem(const JsonKey& key) const;
+    void indexItem(size_t item);
+    void rebuildIndex();
+};
 
 using JsonList = std::vector<std::shared_ptr<JsonNode>>;
 
@@ -31,17 +146,27 @@ class BG2E_EXPORT JsonNode {
         String,
         Number,
         Bool,
-        Null
+        Null,
+        FloatArray,
+        IntArray
     };
 
     JsonObject _objectValue = {};
     JsonList _listValue = {};
+    std::vector<float> _floatArray;
+    std::vector<int32_t> _intArray;
     std::string _stringValue = "";
-    float _numberValue = 0.0f;
+    double _numberValue = 0.0;
+    int64_t _integerValue = 0;
+    bool _integerNumber = false;
+    bool _singlePrecision = false;
     bool _boolValue = false;
 
     Type type;
 
+    JsonList packedItems() const;
+    bool readFloats(float* result, size_t count);
+
 public:
     JsonNode();
     JsonNode(Type t);
@@ -49,12 +174,17 @@ public:
     JsonNode(JsonObject&&);
     JsonNode(const JsonList&);
     JsonNode(JsonList&&);
+    JsonNode(const std::vector<float>&);
+    JsonNode(std::vector<float>&&);
+    JsonNode(const std::vector<int32_t>&);
+    JsonNode(std::vector<int32_t>&&);
     JsonNode(const char*);
     JsonNode(std::string&&);
     JsonNode(const std::string &);
     JsonNode(char);
     JsonNode(int32_t);
     JsonNode(uint32_t);
+    JsonNode(int64_t);
     JsonNode(float);
     JsonNode(double);
     JsonNode(bool);
@@ -96,28 +226,40 @@ public:
         }
     }
     
-    std::shared_ptr<JsonNode> operator[](const std::string& key) {
+    std::shared_ptr<JsonNode> operator[](const JsonKey& key) {
         if (type == Type::Object) {
             return _objectValue[key];
         }
         throw std::logic_error("Improper return type: object");
     }
 
+    // Converts a packed array into a list with a node for each item. The spans returned by
+    // floatArrayValue() and intArrayValue() are no longer valid
+    void unpack();
+
+    // Packed arrays are unpacked, so the result can be modified
     JsonList& listValue() {
+        unpack();
         if (type == Type::List) {
             return _listValue;
         }
         throw std::logic_error("Improper return type: object");
     }
 
-    const JsonList& listValue() const {
+    // The node is not modified: packed arrays return a new list with a node for each item,
+    // and lists return a copy of the item pointers
+    JsonList listValue() const {
         if (type == Type::List) {
             return _listValue;
         }
+        if (type == Type::FloatArray || type == Type::IntArray) {
+            return packedItems();
+        }
         throw std::logic_error("Improper return type: object");
     }
     
     JsonList& listValue(JsonList&& defaultValue) {
+        unpack();
         if (type == Type::List) {
             return _listValue;
         }
@@ -126,10 +268,57 @@ public:
         }
     }
 
-    const JsonList& listValue(JsonList&& defaultValue) const {
+    JsonList listValue(JsonList&& defaultValue) const {
         if (type == Type::List) {
             return _listValue;
         }
+        if (type == Type::FloatArray || type == Type::IntArray) {
+            return packedItems();
+        }
+        return std::move(defaultValue);
+    }
+
+    // Number of items of a list or a packed array
+    size_t listSize() const {
+        switch (type) {
+        case Type::List:
+            return _listValue.size();
+        case Type::FloatArray:
+            return _floatArray.size();
+        case Type::IntArray:
+            return _intArray.size();
+        default:
+            return 0;
+        }
+    }
+
+    std::span<const float> floatArrayValue() const {
+        if (type == Type::FloatArray) {
+            return _floatArray;
+        }
+        throw std::logic_error("Improper return type: float array");
+    }
+
+    std::span<const float> floatArrayValue(std::span<const float> defaultValue) const {
+        if (type == Type::FloatArray) {
+            return _floatArray;
+        }
+        else {
+            return defaultValue;
+        }
+    }
+
+    std::span<const int32_t> intArrayValue() const {
+        if (type == Type::IntArray) {
+            return _intArray;
+        }
+        throw std::logic_error("Improper return type: int array");
+    }
+
+    std::span<const int32_t> intArrayValue(std::span<const int32_t> defaultValue) const {
+        if (type == Type::IntArray) {
+            return _intArray;
+        }
         else {
             return defaultValue;
         }
@@ -153,14 +342,14 @@ public:
 
     float numberValue() {
         if (type == Type::Number) {
-            return _numberValue;
+            return static_cast<float>(_numberValue);
         }
         throw std::logic_error("Improper return type: number");
     }
     
     float numberValue(float defaultValue) {
         if (type == Type::Number) {
-            return _numberValue;
+            return static_cast<float>(_numberValue);
         }
         else {
             return defaultValue;
@@ -169,50 +358,50 @@ public:
     
     double doubleValue() {
         if (type == Type::Number) {
-            return static_cast<double>(_numberValue);
+            return _numberValue;
         }
         throw std::logic_error("Improper return type: number");
     }
     
     double numberValue(double defaultValue) {
         if (type == Type::Number) {
-            return static_cast<double>(_numberValue);
+            return _numberValue;
         }
         else {
             return defaultValue;
         }
     }
     
-    int32_t intValue() {
+    int64_t int64Value() {
         if (type == Type::Number) {
-            return static_cast<int32_t>(_numberValue);
+            return _integerNumber ? _integerValue : static_cast<int64_t>(_numberValue);
         }
         throw std::logic_error("Improper return type: number");
     }
     
-    int32_t intValue(int32_t defaultValue) {
+    int64_t int64Value(int64_t defaultValue) {
         if (type == Type::Number) {
-            return static_cast<int32_t>(_numberValue);
+            return _integerNumber ? _integerValue : static_cast<int64_t>(_numberValue);
         }
         else {
             return defaultValue;
         }
     }
     
+    int32_t intValue() {
+        return static_cast<int32_t>(int64Value());
+    }
+    
+    int32_t intValue(int32_t defaultValue) {
+        return static_cast<int32_t>(int64Value(defaultValue));
+    }
+    
     uint32_t uintValue() {
-        if (type == Type::Number) {
-            return static_cast<uint32_t>(_numberValue);
-        }
-        throw std::logic_error("Improper return type: number");
+        return static_cast<uint32_t>(int64Value());
     }
     
     uint32_t uintValue(uint32_t defaultValue) {
-        if (type == Type::Number) {
-            return static_cast<uint32_t>(_numberValue);
-        }
-        else {
-            return defaultValue;
-        }
+        return static_cast<uint32_t>(int64Value(defaultValue));
     }
 
     bool boolValue(bool defaultValue) {
@@ -244,6 +433,26 @@ public:
         type = Type::List;
     }
 
+    void setValue(const std::vector<float>& values) {
+        _floatArray = values;
+        type = Type::FloatArray;
+    }
+
+    void setValue(std::vector<float>&& values) {
+        _floatArray = std::move(values);
+        type = Type::FloatArray;
+    }
+
+    void setValue(const std::vector<int32_t>& values) {
+        _intArray = values;
+        type = Type::IntArray;
+    }
+
+    void setValue(std::vector<int32_t>&& values) {
+        _intArray = std::move(values);
+        type = Type::IntArray;
+    }
+
     void setValue(const char* str) {
         _stringValue = std::string(str);
         type = Type::String;
@@ -265,22 +474,31 @@ public:
     }
     
     void setValue(int32_t n) {
-        _numberValue = static_cast<float>(n);
-        type = Type::Number;
+        setValue(static_cast<int64_t>(n));
     }
     
     void setValue(uint32_t n) {
-        _numberValue = static_cast<float>(n);
+        setValue(static_cast<int64_t>(n));
+    }
+    
+    void setValue(int64_t n) {
+        _integerValue = n;
+        _numberValue = static_cast<double>(n);
+        _integerNumber = true;
+        _singlePrecision = false;
         type = Type::Number;
     }
     
+    // The double value is the decimal value of the float text, see jsonDecimalValue()
     void setValue(float n) {
-        _numberValue = n;
-        type = Type::Number;
+        setValue(jsonDecimalValue(n));
+        _singlePrecision = true;
     }
 
     void setValue(double n) {
-        _numberValue = static_cast<float>(n);
+        _numberValue = n;
+        _integerNumber = false;
+        _singlePrecision = false;
         type = Type::Number;
     }
 
@@ -297,8 +515,17 @@ public:
         return type == Type::Object;
     }
 
+    // Packed arrays are also lists
     bool isList() {
-        return type == Type::List;
+        return type == Type::List || type == Type::FloatArray || type == Type::IntArray;
+    }
+
+    bool isFloatArray() {
+        return type == Type::FloatArray;
+    }
+
+    bool isIntArray() {
+        return type == Type::IntArray;
     }
 
     bool isString() {
@@ -309,6 +536,15 @@ public:
         return type == Type::Number;
     }
 
+    bool isInteger() {
+        return type == Type::Number && _integerNumber;
+    }
+
+    // The number was set from a float value, and it is written with float precision
+    bool isSinglePrecision() {
+        return type == Type::Number && _singlePrecision;
+    }
+
     bool isBool() {
         return type == Type::Bool;
     }
@@ -319,118 +555,122 @@ public:
     
     // glm object functions
     glm::vec2 vec2Value(const glm::vec2& defaultValue = glm::vec2{0.0f, 0.0f}) {
-        if (type == Type::List) {
-            auto val = this->listValue();
-            if (val.size() >= 2) {
-                glm::vec2 result(val[0]->numberValue(), val[1]->numberValue());
-                return result;
-            }
-        }
-        return defaultValue;
+        glm::vec2 result;
+        return readFloats(&result.x, 2) ? result : defaultValue;
     }
     
     glm::vec3 vec3Value(const glm::vec3& defaultValue = glm::vec3{0.0f, 0.0f, 0.0f}) {
-        if (type == Type::List) {
-            auto val = this->listValue();
-            if (val.size() >= 3) {
-                glm::vec3 result(val[0]->numberValue(), val[1]->numberValue(), val[2]->numberValue());
-                return result;
-            }
-        }
-        return defaultValue;
+        glm::vec3 result;
+        return readFloats(&result.x, 3) ? result : defaultValue;
     }
     
     glm::vec4 vec4Value(const glm::vec4& defaultValue = glm::vec4{0.0f, 0.0f, 0.0f, 0.0f}) {
-        if (type == Type::List) {
-            auto val = this->listValue();
-            if (val.size() >= 3) {
-                glm::vec4 result(val[0]->numberValue(), val[1]->numberValue(), val[2]->numberValue(), val[3]->numberValue());
-                return result;
-            }
-        }
-        return defaultValue;
+        glm::vec4 result;
+        return readFloats(&result.x, 4) ? result : defaultValue;
     }
     
     glm::mat4 mat4Value(const glm::mat4& defaultValue = glm::mat4{}) {
-        if (type == Type::List) {
-            auto val = this->listValue();
-            if (val.size() >= 16) {
-                // TODO: glm is column major, maybe this must be transposed?
-                glm::mat4 result(
-                    val[ 0]->numberValue(), val[ 1]->numberValue(), val[ 2]->numberValue(), val[ 3]->numberValue(),
-                    val[ 4]->numberValue(), val[ 5]->numberValue(), val[ 6]->numberValue(), val[ 7]->numberValue(),
-                    val[ 8]->numberValue(), val[ 9]->numberValue(), val[10]->numberValue(), val[11]->numberValue(),
-                    val[12]->numberValue(), val[13]->numberValue(), val[14]->numberValue(), val[15]->numberValue());
-                return result;
-            }
-        }
-        return defaultValue;
+        // TODO: glm is column major, maybe this must be transposed?
+        glm::mat4 result;
+        return readFloats(&result[0][0], 16) ? result : defaultValue;
     }
     
     void setValue(const glm::vec2& value) {
-        setValue(JsonList{
-            std::make_shared<JsonNode>(value.x),
-            std::make_shared<JsonNode>(value.y)
-        });
+        setValue(std::vector<float>{ value.x, value.y });
     }
     
     void setValue(const glm::vec3& value) {
-        setValue(JsonList{
-            std::make_shared<JsonNode>(value.x),
-            std::make_shared<JsonNode>(value.y),
-            std::make_shared<JsonNode>(value.z)
-        });
+        setValue(std::vector<float>{ value.x, value.y, value.z });
     }
     
     void setValue(const glm::vec4& value) {
-        setValue(JsonList{
-            std::make_shared<JsonNode>(value.x),
-            std::make_shared<JsonNode>(value.y),
-            std::make_shared<JsonNode>(value.z),
-            std::make_shared<JsonNode>(value.w)
-        });
+        setValue(std::vector<float>{ value.x, value.y, value.z, value.w });
     }
     
     void setValue(const glm::mat4& value) {
         // TODO: glm is column major, maybe this must be transposed?
-        setValue(JsonList{
-            std::make_shared<JsonNode>(value[0][0]),
-            std::make_shared<JsonNode>(value[0][1]),
-            std::make_shared<JsonNode>(value[0][2]),
-            std::make_shared<JsonNode>(value[0][3]),
-            
-            std::make_shared<JsonNode>(value[1][0]),
-            std::make_shared<JsonNode>(value[1][1]),
-            std::make_shared<JsonNode>(value[1][2]),
-            std::make_shared<JsonNode>(value[1][3]),
-            
-            std::make_shared<JsonNode>(value[2][0]),
-            std::make_shared<JsonNode>(value[2][1]),
-            std::make_shared<JsonNode>(value[2][2]),
-            std::make_shared<JsonNode>(value[2][3]),
-            
-            std::make_shared<JsonNode>(value[3][0]),
-            std::make_shared<JsonNode>(value[3][1]),
-            std::make_shared<JsonNode>(value[3][2]),
-            std::make_shared<JsonNode>(value[3][3])
-        });
+        setValue(std::vector<float>(&value[0][0], &value[0][0] + 16));
     }
 
+    // Deep copy of the node and its items
+    std::shared_ptr<JsonNode> clone() const;
+
+    // Applies a JSON merge patch (RFC 7386): patch objects are merged recursively, null
+    // values remove the member, and any other value replaces the target value. The values
+    // of the patch are copied, and the nested objects are copied before they are patched,
+    // so the nodes shared with the patch or with other documents are not modified
+    void applyMergePatch(JsonNode& patch);
+
     void printNode(int indentationLevel = 0);
 
     std::string toString(int indentationLevel = 0);
 };
 
+// Collects the items of a list that only contains numbers, to store them in a packed
+// array node instead of creating a node for each item
+class BG2E_EXPORT JsonNumberListBuilder {
+public:
+    inline void add(int64_t value) {
+        _items.push_back({ static_cast<double>(value), value, true });
+        _int32 = _int32 && value >= INT32_MIN && value <= INT32_MAX;
+        _largeIntegers = _largeIntegers || value < INT32_MIN || value > INT32_MAX;
+        _decimalFloats = _decimalFloats && value >= -16777216 && value <= 16777216;
+    }
+
+    inline void add(double value) {
+        _items.push_back({ value, 0, false });
+        _int32 = false;
+        _decimalFloats = _decimalFloats && isDecimalFloat(value);
+    }
+
+    inline size_t size() const { return _items.size(); }
+
+    inline void clear() {
+        _items.clear();
+        _int32 = true;
+        _largeIntegers = false;
+        _decimalFloats = true;
+    }
+
+    // IntArray if all the items are 32 bit integers, FloatArray if there are decimal numbers
+    // and each item is the decimal value of its float (so 0.1 is packed, and it reads back
+    // as 0.1), or a list of number nodes to keep the precision of the rest
+    std::shared_ptr<JsonNode> node() const;
+
+    // Appends a number node for each item
+    void appendNodes(JsonList& list) const;
+
+protected:
+    struct Item {
+        double number;
+        int64_t integer;
+        bool isInteger;
+    };
+
+    std::vector<Item> _items;
+    bool _int32 = true;
+    bool _largeIntegers = false;
+    bool _decimalFloats = true;
+
+    // The value is the same as the jsonDecimalValue() of the nearest float
+    static bool isDecimalFloat(double value);
+};
+
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const JsonObject& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(JsonObject&& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const JsonList& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(JsonList&& p);
+extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const std::vector<float>& p);
+extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(std::vector<float>&& p);
+extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const std::vector<int32_t>& p);
+extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(std::vector<int32_t>&& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const char* p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(std::string&& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(const std::string& p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(char p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(int32_t p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(uint32_t p);
+extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(int64_t p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(float p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(double p);
 extern BG2E_EXPORT std::shared_ptr<JsonNode> JSON(bool p);
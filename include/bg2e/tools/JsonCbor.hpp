@@ -0,0 +1,33 @@
+#ifndef bg2e_tools_jsoncbor_hpp
+#define bg2e_tools_jsoncbor_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/tools/Json.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace bg2e {
+namespace tools {
+
+// Binary encoding of JsonNode trees in CBOR (RFC 8949). Numbers keep their integer, float
+// or double precision. FloatArray nodes, and lists of two or more float numbers, are written
+// as little endian float32 typed arrays (RFC 8746, tag 85), and IntArray nodes as sint32
+// typed arrays (tag 78). Typed arrays are decoded into packed array nodes with a memcpy.
+BG2E_EXPORT void encodeJsonCbor(JsonNode& node, std::vector<Byte>& result);
+BG2E_EXPORT std::vector<Byte> encodeJsonCbor(JsonNode& node);
+
+// Decodes the CBOR data items used by encodeJsonCbor(). Byte strings that are not typed
+// arrays and non string map keys are not supported. Throws std::logic_error if the data
+// is not valid
+BG2E_EXPORT std::shared_ptr<JsonNode> decodeJsonCbor(const Byte* data, size_t size);
+
+inline std::shared_ptr<JsonNode> decodeJsonCbor(const std::vector<Byte>& data) {
+    return decodeJsonCbor(data.data(), data.size());
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef bg2e_tools_jsondocument_hpp
+#define bg2e_tools_jsondocument_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonStructuralIndex.hpp>
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <iterator>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace bg2e {
+namespace tools {
+
+class JsonDocument;
+class JsonView;
+
+enum class JsonDocumentNodeType : uint8_t {
+    Null = 0,
+    Object,
+    List,
+    String,
+    Number,
+    Bool
+};
+
+// Compact node stored in the document arena. Containers and strings reference their
+// contents by offset: the first child node index, or the first byte in the string area.
+// Object children are stored as consecutive key/value node pairs.
+struct JsonDocumentNode {
+    static const uint8_t FlagInteger = 1 << 0;
+
+    JsonDocumentNodeType type = JsonDocumentNodeType::Null;
+    uint8_t flags = 0;
+    uint16_t reserved = 0;
+    uint32_t size = 0;
+    union {
+        double number;
+        int64_t integer;
+        uint64_t offset;
+        bool boolean;
+    };
+
+    JsonDocumentNode() :offset(0) {}
+};
+
+static_assert(sizeof(JsonDocumentNode) == 16, "JsonDocumentNode must be 16 bytes long");
+
+class BG2E_EXPORT JsonListView {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = JsonView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = JsonView;
+
+        Iterator(const JsonDocument* doc, const JsonDocumentNode* node) :_document(doc), _node(node) {}
+
+        JsonView operator*() const;
+        inline Iterator& operator++() { ++_node; return *this; }
+        inline Iterator operator++(int) { Iterator result = *this; ++_node; return result; }
+        inline bool operator==(const Iterator& other) const { return _node == other._node; }
+        inline bool operator!=(const Iterator& other) const { return _node != other._node; }
+
+    protected:
+        const JsonDocument* _document;
+        const JsonDocumentNode* _node;
+    };
+
+    JsonListView() {}
+    JsonListView(const JsonDocument* doc, const JsonDocumentNode* first, uint32_t size) :_document(doc), _first(first), _size(size) {}
+
+    inline size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+
+    JsonView operator[](size_t index) const;
+
+    inline Iterator begin() const { return Iterator(_document, _first); }
+    inline Iterator end() const { return Iterator(_document, _first + _size); }
+
+protected:
+    const JsonDocument* _document = nullptr;
+    const JsonDocumentNode* _first = nullptr;
+    uint32_t _size = 0;
+};
+
+class BG2E_EXPORT JsonObjectView {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, JsonView>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const JsonDocument* doc, const JsonDocumentNode* node) :_document(doc), _node(node) {}
+
+        std::pair<std::string_view, JsonView> operator*() const;
+        inline Iterator& operator++() { _node += 2; return *this; }
+        inline Iterator operator++(int) { Iterator result = *this; _node += 2; return result; }
+        inline bool operator==(const Iterator& other) const { return _node == other._node; }
+        inline bool operator!=(const Iterator& other) const { return _node != other._node; }
+
+    protected:
+        const JsonDocument* _document;
+        const JsonDocumentNode* _node;
+    };
+
+    JsonObjectView() {}
+    JsonObjectView(const JsonDocument* doc, const JsonDocumentNode* first, uint32_t size) :_document(doc), _first(first), _size(size) {}
+
+    inline size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+
+    // Returns a null view if the key is not found. The object is never modified
+    JsonView operator[](std::string_view key) const;
+    bool contains(std::string_view key) const;
+
+    inline Iterator begin() const { return Iterator(_document, _first); }
+    inline Iterator end() const { return Iterator(_document, _first + _size * 2); }
+
+protected:
+    const JsonDocument* _document = nullptr;
+    const JsonDocumentNode* _first = nullptr;
+    uint32_t _size = 0;
+};
+
+// Read only view of a JsonDocument node, with the same accessor API as JsonNode.
+// A default constructed view, or the result of looking up a missing key, behaves as null.
+class BG2E_EXPORT JsonView {
+public:
+    JsonView() {}
+    JsonView(const JsonDocument* doc, const JsonDocumentNode* node) :_document(doc), _node(node) {}
+
+    inline bool isValid() const { return _node != nullptr; }
+
+    inline bool isObject() const { return type() == JsonDocumentNodeType::Object; }
+    inline bool isList() const { return type() == JsonDocumentNodeType::List; }
+    inline bool isString() const { return type() == JsonDocumentNodeType::String; }
+    inline bool isNumber() const { return type() == JsonDocumentNodeType::Number; }
+    inline bool isBool() const { return type() == JsonDocumentNodeType::Bool; }
+    inline bool isNull() const { return type() == JsonDocumentNodeType::Null; }
+
+    inline JsonDocumentNodeType type() const { return _node ? _node->type : JsonDocumentNodeType::Null; }
+
+    JsonObjectView objectValue() const;
+    JsonObjectView objectValue(JsonObjectView defaultValue) const;
+    JsonListView listValue() const;
+    JsonListView listValue(JsonListView defaultValue) const;
+
+    JsonView operator[](std::string_view key) const;
+    JsonView operator[](size_t index) const;
+
+    std::string_view stringValue() const;
+    std::string_view stringValue(std::string_view defaultValue) const;
+
+    inline bool isInteger() const { return isNumber() && (_node->flags & JsonDocumentNode::FlagInteger) != 0; }
+
+    inline float numberValue() const { return static_cast<float>(doubleValue()); }
+    inline float numberValue(float defaultValue) const { return isNumber() ? static_cast<float>(numberOf(_node)) : defaultValue; }
+
+    inline double doubleValue() const {
+        if (isNumber()) {
+            return numberOf(_node);
+        }
+        throw std::logic_error("Improper return type: number");
+    }
+
+    inline double numberValue(double defaultValue) const { return isNumber() ? numberOf(_node) : defaultValue; }
+
+    inline int64_t int64Value() const {
+        if (isNumber()) {
+            return integerOf(_node);
+        }
+        throw std::logic_error("Improper return type: number");
+    }
+
+    inline int64_t int64Value(int64_t defaultValue) const { return isNumber() ? integerOf(_node) : defaultValue; }
+
+    inline int32_t intValue() const { return static_cast<int32_t>(int64Value()); }
+    inline int32_t intValue(int32_t defaultValue) const { return static_cast<int32_t>(int64Value(defaultValue)); }
+    inline uint32_t uintValue() const { return static_cast<uint32_t>(int64Value()); }
+    inline uint32_t uintValue(uint32_t defaultValue) const { return static_cast<uint32_t>(int64Value(defaultValue)); }
+
+    static inline double numberOf(const JsonDocumentNode* node) {
+        return (node->flags & JsonDocumentNode::FlagInteger) ? static_cast<double>(node->integer) : node->number;
+    }
+
+    static inline int64_t integerOf(const JsonDocumentNode* node) {
+        return (node->flags & JsonDocumentNode::FlagInteger) ? node->integer : static_cast<int64_t>(node->number);
+    }
+
+    inline bool boolValue(bool defaultValue) const { return isBool() ? _node->boolean : defaultValue; }
+
+    glm::vec2 vec2Value(const glm::vec2& defaultValue = glm::vec2{0.0f, 0.0f}) const;
+    glm::vec3 vec3Value(const glm::vec3& defaultValue = glm::vec3{0.0f, 0.0f, 0.0f}) const;
+    glm::vec4 vec4Value(const glm::vec4& defaultValue = glm::vec4{0.0f, 0.0f, 0.0f, 0.0f}) const;
+    glm::mat4 mat4Value(const glm::mat4& defaultValue = glm::mat4{}) const;
+
+    // Builds a JsonNode tree with the contents of this view
+    std::shared_ptr<JsonNode> toNode() const;
+
+    // The object keys are interned in `keys`
+    std::shared_ptr<JsonNode> toNode(JsonKeyTable& keys) const;
+
+protected:
+    const JsonDocument* _document = nullptr;
+    const JsonDocumentNode* _node = nullptr;
+
+    void readFloats(float* result, uint32_t count) const;
+};
+
+// JSON DOM stored in a single arena allocation, parsed from a contiguous buffer
+class BG2E_EXPORT JsonDocument {
+public:
+    JsonDocument();
+    JsonDocument(std::string_view buffer);
+    ~JsonDocument();
+
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+    JsonDocument(JsonDocument&&) noexcept;
+    JsonDocument& operator=(JsonDocument&&) noexcept;
+
+    // Throws std::logic_error if the input is not valid JSON
+    void parse(std::string_view buffer, JsonParseMode mode = JsonParseMode::Automatic);
+    void parseFile(const std::string& path, JsonParseMode mode = JsonParseMode::Automatic);
+
+    void clear();
+
+    inline JsonView root() const { return _nodeCount > 0 ? JsonView(this, nodes() + _rootIndex) : JsonView(); }
+    inline JsonView operator[](std::string_view key) const { return root()[key]; }
+
+    inline size_t nodeCount() const { return _nodeCount; }
+    inline size_t memorySize() const { return _arenaSize; }
+
+    inline const JsonDocumentNode* nodes() const { return reinterpret_cast<const JsonDocumentNode*>(_arena.get()); }
+    inline const char* strings() const { return reinterpret_cast<const char*>(_arena.get() + _stringsOffset); }
+
+protected:
+    std::unique_ptr<Byte[]> _arena;
+    size_t _arenaSize = 0;
+    size_t _nodeCount = 0;
+    size_t _rootIndex = 0;
+    size_t _stringsOffset = 0;
+
+    template <typename Tokenizer>
+    void build(Tokenizer& tokenizer, size_t nodeCount, size_t stringBytes);
+};
+
+}
+}
+
+#endif
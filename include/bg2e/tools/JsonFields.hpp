@@ -0,0 +1,320 @@
+#ifndef bg2e_tools_jsonfields_hpp
+#define bg2e_tools_jsonfields_hpp
+
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonReader.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+
+#include <array>
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+#include <type_traits>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace bg2e {
+namespace tools {
+
+// Describes a serializable data member. Classes that support reflected serialization
+// return a tuple of fields from a static constexpr function:
+//
+//     static constexpr auto jsonFields() {
+//         return std::make_tuple(
+//             tools::jsonField("position", &Light::_position),
+//             tools::jsonField("castShadows", &Light::_castShadows)
+//         );
+//     }
+//
+// and grant access to it with `friend class tools::JsonFieldSet<Light>`
+template <typename Class, typename Value>
+struct JsonField {
+    std::string_view name;
+    Value Class::* member;
+};
+
+template <typename Class, typename Value>
+constexpr JsonField<Class, Value> jsonField(std::string_view name, Value Class::* member) {
+    return { name, member };
+}
+
+// Collision free hash table for a fixed set of keys, built at compile time
+template <size_t N>
+struct JsonPerfectHash {
+    static_assert(N < 255, "Too many keys for JsonPerfectHash");
+
+    static constexpr size_t tableSize() {
+        size_t size = 4;
+        while (size < N * 4) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    uint32_t seed = 0;
+
+    // Key index plus one, or zero for empty slots
+    std::array<uint8_t, tableSize()> slots{};
+
+    constexpr int find(std::string_view key, const std::array<std::string_view, N>& keys) const {
+        uint8_t slot = slots[jsonKeyHash(key, seed) & (tableSize() - 1)];
+        return slot != 0 && keys[slot - 1] == key ? slot - 1 : -1;
+    }
+
+    static constexpr JsonPerfectHash build(const std::array<std::string_view, N>& keys) {
+        for (uint32_t seed = 0; seed < 100000; ++seed) {
+            JsonPerfectHash result;
+            result.seed = seed;
+            bool collision = false;
+            for (size_t i = 0; i < N && !collision; ++i) {
+                auto& slot = result.slots[jsonKeyHash(keys[i], seed) & (tableSize() - 1)];
+                collision = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collision) {
+                return result;
+            }
+        }
+        // Not a constant expression: reports duplicated keys at compile time
+        throw std::logic_error("JsonPerfectHash: duplicated keys");
+    }
+};
+
+// Value readers and writers for the supported field types
+inline bool readJsonField(JsonReader& reader, float& v) { v = reader.readFloat(v); return reader.event() == JsonEvent::Number; }
+inline bool readJsonField(JsonReader& reader, double& v) { v = reader.readDouble(v); return reader.event() == JsonEvent::Number; }
+inline bool readJsonField(JsonReader& reader, int32_t& v) { v = reader.readInt(v); return reader.event() == JsonEvent::Number; }
+inline bool readJsonField(JsonReader& reader, uint32_t& v) { v = reader.readUInt(v); return reader.event() == JsonEvent::Number; }
+inline bool readJsonField(JsonReader& reader, bool& v) { v = reader.readBool(v); return reader.event() == JsonEvent::Bool; }
+inline bool readJsonField(JsonReader& reader, std::string& v) { v = reader.readString(v); return reader.event() == JsonEvent::String; }
+inline bool readJsonField(JsonReader& reader, glm::vec2& v) { return reader.readFloats(&v.x, 2); }
+inline bool readJsonField(JsonReader& reader, glm::vec3& v) { return reader.readFloats(&v.x, 3); }
+inline bool readJsonField(JsonReader& reader, glm::vec4& v) { return reader.readFloats(&v.x, 4); }
+inline bool readJsonField(JsonReader& reader, glm::mat4& v) { return reader.readFloats(&v[0][0], 16); }
+
+inline void readJsonField(JsonNode& node, float& v) { v = node.numberValue(v); }
+inline void readJsonField(JsonNode& node, double& v) { v = node.numberValue(v); }
+inline void readJsonField(JsonNode& node, int32_t& v) { v = node.intValue(v); }
+inline void readJsonField(JsonNode& node, uint32_t& v) { v = node.uintValue(v); }
+inline void readJsonField(JsonNode& node, bool& v) { v = node.boolValue(v); }
+inline void readJsonField(JsonNode& node, std::string& v) { if (node.isString()) v = node.stringValue(); }
+inline void readJsonField(JsonNode& node, glm::vec2& v) { v = node.vec2Value(v); }
+inline void readJsonField(JsonNode& node, glm::vec3& v) { v = node.vec3Value(v); }
+inline void readJsonField(JsonNode& node, glm::vec4& v) { v = node.vec4Value(v); }
+inline void readJsonField(JsonNode& node, glm::mat4& v) { v = node.mat4Value(v); }
+
+// Enumerations are stored as integers. The valid values are declared with a jsonEnumValid()
+// overload in the namespace of the enumeration, and the values out of range throw
+// std::logic_error:
+//
+//     constexpr bool jsonEnumValid(TextureWrap value) {
+//         return value >= TextureWrap::Repeat && value <= TextureWrap::MirroredRepeat;
+//     }
+template <typename E> requires std::is_enum_v<E>
+inline E jsonEnumValue(int32_t value) {
+    E result = static_cast<E>(value);
+    if (!jsonEnumValid(result)) {
+        throw std::logic_error("Invalid enumeration value: " + std::to_string(value));
+    }
+    return result;
+}
+
+template <typename E> requires std::is_enum_v<E>
+inline bool readJsonField(JsonReader& reader, E& v) {
+    v = jsonEnumValue<E>(reader.readInt(static_cast<int32_t>(v)));
+    return reader.event() == JsonEvent::Number;
+}
+
+template <typename E> requires std::is_enum_v<E>
+inline void readJsonField(JsonNode& node, E& v) { v = jsonEnumValue<E>(node.intValue(static_cast<int32_t>(v))); }
+
+template <typename Value>
+inline decltype(auto) jsonFieldValue(const Value& v) {
+    if constexpr (std::is_enum_v<Value>) {
+        return static_cast<int32_t>(v);
+    }
+    else {
+        return (v);
+    }
+}
+
+// Bit mask of fields, by their index in T::jsonFields()
+using JsonFieldMask = uint64_t;
+
+// Reflected serialization of the fields returned by T::jsonFields(). Deserialization makes a
+// single pass over the object keys, and finds each field with a compile time perfect hash.
+// The key handler passed to the deserialize functions receives the keys that do not match
+// any field, and returns false if the key is not handled.
+template <typename T>
+class JsonFieldSet {
+public:
+    static constexpr auto fields = T::jsonFields();
+    static constexpr size_t count = std::tuple_size_v<decltype(fields)>;
+    static_assert(count <= 64, "JsonFieldMask supports up to 64 fields");
+
+    static constexpr std::array<std::string_view, count> keys() {
+        return std::apply([](auto... field) {
+            return std::array<std::string_view, count>{ field.name... };
+        }, fields);
+    }
+
+    static constexpr std::array<std::string_view, count> keyList = keys();
+    static constexpr JsonPerfectHash<count> hash = JsonPerfectHash<count>::build(keyList);
+
+    static constexpr int find(std::string_view key) { return hash.find(key, keyList); }
+
+    // Mask bit of a field, or zero if there is no field with that name
+    static constexpr JsonFieldMask fieldMask(std::string_view key) {
+        int index = find(key);
+        return index >= 0 ? JsonFieldMask(1) << index : 0;
+    }
+
+    // Reads the value of the field `index`. Returns false if the value has not the field type
+    static bool read(JsonReader& reader, T& object, int index) {
+        return readIndex(reader, object, index, std::make_index_sequence<count>{});
+    }
+
+    static void read(JsonNode& node, T& object, int index) {
+        readIndex(node, object, index, std::make_index_sequence<count>{});
+    }
+
+    // Reads the object at the current reader position. Returns false if the value is not an object
+    template <typename KeyHandler>
+    static bool deserialize(JsonReader& reader, T& object, KeyHandler&& handler) {
+        auto event = reader.next();
+        if (event != JsonEvent::StartObject) {
+            if (event == JsonEvent::StartList) {
+                reader.skipContainer();
+            }
+            return false;
+        }
+        while (reader.next() == JsonEvent::Key) {
+            auto key = reader.key();
+            int index = find(key);
+            if (index >= 0) {
+                read(reader, object, index);
+            }
+            else if (!handler(key)) {
+                reader.skipValue();
+            }
+        }
+        return true;
+    }
+
+    static bool deserialize(JsonReader& reader, T& object) {
+        return deserialize(reader, object, [](std::string_view) { return false; });
+    }
+
+    // Iterates the object keys without inserting missing ones. Returns false if the node is not an object
+    template <typename KeyHandler>
+    static bool deserialize(JsonNode& node, T& object, KeyHandler&& handler) {
+        if (!node.isObject()) {
+            return false;
+        }
+        for (auto & item : node.objectValue()) {
+            if (!item.second) {
+                continue;
+            }
+            int index = find(item.first);
+            if (index >= 0) {
+                read(*item.second, object, index);
+            }
+            else {
+                handler(item.first, *item.second);
+            }
+        }
+        return true;
+    }
+
+    static bool deserialize(JsonNode& node, T& object) {
+        return deserialize(node, object, [](std::string_view, JsonNode&) { return false; });
+    }
+
+    // Applies the members of a merge patch object (RFC 7386) to the fields. Fields can not be
+    // removed, so null values are ignored. The keys that do not match any field are passed to
+    // the handler. Returns the fields whose value has changed. The fields are patched in a
+    // copy, so the object is not modified if a value throws std::logic_error
+    template <typename KeyHandler>
+    static JsonFieldMask patch(JsonNode& patchData, T& object, KeyHandler&& handler) {
+        JsonFieldMask changed = 0;
+        if (!patchData.isObject()) {
+            return changed;
+        }
+        auto values = std::apply([&](const auto&... field) {
+            return std::make_tuple(object.*(field.member)...);
+        }, fields);
+        for (auto & item : patchData.objectValue()) {
+            int index = item.second && !item.second->isNull() ? find(item.first) : -1;
+            if (index >= 0 && patchIndex(*item.second, values, index, std::make_index_sequence<count>{})) {
+                changed |= JsonFieldMask(1) << index;
+            }
+        }
+        assignValues(object, values, std::make_index_sequence<count>{});
+        for (auto & item : patchData.objectValue()) {
+            if (item.second && !item.second->isNull() && find(item.first) < 0) {
+                handler(item.first, *item.second);
+            }
+        }
+        return changed;
+    }
+
+    static JsonFieldMask patch(JsonNode& patchData, T& object) {
+        return patch(patchData, object, [](std::string_view, JsonNode&) { return false; });
+    }
+
+    // Writes the fields as key/value pairs inside the current writer object
+    static void serialize(JsonWriter& writer, const T& object) {
+        std::apply([&](const auto&... field) {
+            (writer.field(field.name, jsonFieldValue(object.*(field.member))), ...);
+        }, fields);
+    }
+
+    static void serialize(JsonObject& result, const T& object) {
+        std::apply([&](const auto&... field) {
+            ((result[field.name] = JSON(jsonFieldValue(object.*(field.member)))), ...);
+        }, fields);
+    }
+
+protected:
+    template <size_t... I>
+    static bool readIndex(JsonReader& reader, T& object, int index, std::index_sequence<I...>) {
+        bool result = false;
+        ((static_cast<int>(I) == index ? (result = readJsonField(reader, object.*(std::get<I>(fields).member)), true) : false) || ...);
+        return result;
+    }
+
+    template <size_t... I>
+    static void readIndex(JsonNode& node, T& object, int index, std::index_sequence<I...>) {
+        ((static_cast<int>(I) == index ? (readJsonField(node, object.*(std::get<I>(fields).member)), true) : false) || ...);
+    }
+
+    template <typename Value>
+    static bool patchValue(JsonNode& node, Value& value) {
+        Value previous = value;
+        readJsonField(node, value);
+        return !(previous == value);
+    }
+
+    template <typename Values, size_t... I>
+    static bool patchIndex(JsonNode& node, Values& values, int index, std::index_sequence<I...>) {
+        bool result = false;
+        ((static_cast<int>(I) == index ? (result = patchValue(node, std::get<I>(values)), true) : false) || ...);
+        return result;
+    }
+
+    template <typename Values, size_t... I>
+    static void assignValues(T& object, Values& values, std::index_sequence<I...>) {
+        ((object.*(std::get<I>(fields).member) = std::move(std::get<I>(values))), ...);
+    }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef bg2e_tools_jsonincrementalparser_hpp
+#define bg2e_tools_jsonincrementalparser_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+#include <bg2e/tools/Json.hpp>
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+
+namespace bg2e {
+namespace tools {
+
+enum class JsonStreamMode {
+    // Every top level value is emitted when it is complete. Values are separated by
+    // whitespace, as in JSON Lines
+    Values,
+    // The input is a single list, and each item is emitted when it is complete
+    ListItems
+};
+
+// Resumable parser for JSON data that arrives in chunks of any size, for example from
+// asynchronous file reads or a pipe. feed() scans the new bytes for the end of the current
+// element, keeping the scanner state between calls, and each completed element is parsed
+// and passed to the handler before feed() returns.
+class BG2E_EXPORT JsonIncrementalParser {
+public:
+    using ElementHandler = std::function<void(std::shared_ptr<JsonNode>)>;
+
+    JsonIncrementalParser(ElementHandler handler, JsonStreamMode mode = JsonStreamMode::Values);
+
+    // Throws std::logic_error if the data is not valid. The parser can not be used after an
+    // error until reset() is called
+    void feed(std::string_view data);
+    inline void feed(const Byte* data, size_t size) { feed(std::string_view(reinterpret_cast<const char*>(data), size)); }
+
+    // Completes the last element, if it is a number or literal that has not been followed
+    // by a separator. Throws std::logic_error if the input ends inside an element
+    void finish();
+
+    void reset();
+
+    inline size_t elementCount() const { return _elementCount; }
+
+    // Bytes of incomplete elements kept between feed() calls
+    inline size_t pendingBytes() const { return _buffer.size(); }
+
+protected:
+    enum class ListState {
+        BeforeList,
+        BeforeFirstItem,
+        BeforeItem,
+        AfterItem,
+        AfterList
+    };
+
+    ElementHandler _handler;
+    JsonStreamMode _mode;
+
+    std::string _buffer;
+    // Stream position of the first byte in _buffer, for error messages
+    size_t _bufferOffset = 0;
+    size_t _scanPos = 0;
+    size_t _elementStart = std::string::npos;
+    size_t _depth = 0;
+    bool _inString = false;
+    bool _escape = false;
+    bool _scalar = false;
+    ListState _listState = ListState::BeforeList;
+    size_t _elementCount = 0;
+
+    inline bool inElement() const { return _elementStart != std::string::npos; }
+
+    void startElement(size_t pos);
+    void completeElement(size_t end);
+    void separator(char c, size_t pos);
+};
+
+}
+}
+
+#endif
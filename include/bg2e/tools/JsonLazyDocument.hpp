@@ -0,0 +1,129 @@
+#ifndef bg2e_tools_jsonlazydocument_hpp
+#define bg2e_tools_jsonlazydocument_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonStructuralIndex.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+namespace bg2e {
+namespace tools {
+
+class JsonLazyDocument;
+
+// Reference to a value in a JsonLazyDocument. Navigating the value does not create any
+// node: object and list children are found by skipping whole subtrees in the structural index.
+// A default constructed value, or the result of looking up a missing key, is not valid.
+class BG2E_EXPORT JsonLazyValue {
+public:
+    JsonLazyValue() {}
+    JsonLazyValue(JsonLazyDocument* doc, uint32_t entry) :_document(doc), _entry(entry) {}
+
+    inline bool isValid() const { return _document != nullptr; }
+
+    bool isObject() const;
+    bool isList() const;
+    bool isString() const;
+    bool isNumber() const;
+    bool isBool() const;
+    bool isNull() const;
+
+    // Number of object members or list items
+    size_t size() const;
+
+    JsonLazyValue operator[](std::string_view key) const;
+    JsonLazyValue operator[](size_t index) const;
+
+    // JSON Pointer (RFC 6901) relative to this value
+    JsonLazyValue find(std::string_view pointer) const;
+
+    // Materializes the value and its children. The tree is cached in the document, and each
+    // call returns a copy that the caller can modify
+    std::shared_ptr<JsonNode> node() const;
+
+    std::string stringValue(const std::string& defaultValue = "") const;
+    float numberValue(float defaultValue) const;
+    double numberValue(double defaultValue) const;
+    int32_t intValue(int32_t defaultValue) const;
+    uint32_t uintValue(uint32_t defaultValue) const;
+    bool boolValue(bool defaultValue) const;
+    glm::vec2 vec2Value(const glm::vec2& defaultValue = glm::vec2{0.0f, 0.0f}) const;
+    glm::vec3 vec3Value(const glm::vec3& defaultValue = glm::vec3{0.0f, 0.0f, 0.0f}) const;
+    glm::vec4 vec4Value(const glm::vec4& defaultValue = glm::vec4{0.0f, 0.0f, 0.0f, 0.0f}) const;
+    glm::mat4 mat4Value(const glm::mat4& defaultValue = glm::mat4{}) const;
+
+    inline uint32_t entry() const { return _entry; }
+
+protected:
+    JsonLazyDocument* _document = nullptr;
+    uint32_t _entry = 0;
+};
+
+// On demand JSON document. Parsing only builds and validates the structural index; nodes
+// are created when a value is accessed, and cached so that repeated access does not parse
+// the same subtree again.
+class BG2E_EXPORT JsonLazyDocument {
+    friend class JsonLazyValue;
+public:
+    JsonLazyDocument();
+    ~JsonLazyDocument();
+
+    JsonLazyDocument(const JsonLazyDocument&) = delete;
+    JsonLazyDocument& operator=(const JsonLazyDocument&) = delete;
+
+    // The buffer is not copied, and it must be valid while the document is used.
+    // Throws std::logic_error if the document structure is not valid
+    void parse(std::string_view buffer);
+
+    // The file stays mapped in memory until the document is cleared
+    void parseFile(const std::string& path);
+
+    void clear();
+
+    inline JsonLazyValue root() { return _index.size() > 0 ? JsonLazyValue(this, 0) : JsonLazyValue(); }
+    inline JsonLazyValue operator[](std::string_view key) { return root()[key]; }
+
+    // Materialized node at a JSON Pointer, for example "/lights/3/position", or nullptr if
+    // the pointer does not exist. The tree is cached, and the result is a copy
+    std::shared_ptr<JsonNode> at(std::string_view pointer);
+
+    inline size_t cachedNodeCount() const { return _nodeCache.size(); }
+
+protected:
+    MappedFile _file;
+    std::string_view _buffer;
+    JsonStructuralIndex _index;
+
+    // Entry of the closing bracket, for each container opening entry
+    std::vector<uint32_t> _closeEntry;
+
+    JsonKeyTable _keys;
+    std::unordered_map<uint32_t, std::shared_ptr<JsonNode>> _nodeCache;
+    std::unordered_map<std::string, std::shared_ptr<JsonNode>> _pointerCache;
+
+    inline char entryChar(uint32_t entry) const { return _buffer[_index.positions()[entry]]; }
+
+    // Entry that follows the value starting at `entry`
+    inline uint32_t skipValue(uint32_t entry) const {
+        char c = entryChar(entry);
+        return (c == '{' || c == '[') ? _closeEntry[entry] + 1 : entry + 1;
+    }
+
+    void validate();
+    JsonTokenView token(uint32_t entry) const;
+    std::shared_ptr<JsonNode> materialize(uint32_t entry);
+
+    // Materialized tree of the entry, shared with the cache: it must not be modified
+    std::shared_ptr<JsonNode> cachedNode(uint32_t entry);
+};
+
+}
+}
+
+#endif
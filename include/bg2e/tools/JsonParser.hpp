@@ -4,10 +4,13 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
+#include <string_view>
 
 #include <bg2e/export.hpp>
 #include <bg2e/tools/Json.hpp>
 #include <bg2e/tools/JsonToken.hpp>
+#include <bg2e/tools/JsonStructuralIndex.hpp>
 
 namespace bg2e {
 namespace tools {
@@ -17,18 +20,39 @@ class BG2E_EXPORT JsonParser {
     std::shared_ptr<JsonNode> root;
     std::unique_ptr<JsonNode> current;
     JsonTokenizer tokenizer;
+    // Nesting level of the stream parser
+    size_t depth = 0;
 
 public:
+    // Minimum buffer size to parse top level lists in parallel in JsonParseMode::Automatic
+    static const size_t ParallelThreshold = 1024 * 1024;
+
+    JsonParser() :stream(nullptr), tokenizer(nullptr) {}
     JsonParser(std::istream * stream) :tokenizer(stream) {}
 
     std::shared_ptr<JsonNode> & parse();
 
+    // Contiguous buffer parser. Throws std::logic_error if the input is not valid JSON
+    std::shared_ptr<JsonNode> parse(std::string_view buffer, JsonParseMode mode = JsonParseMode::Automatic);
+    std::shared_ptr<JsonNode> parseFile(const std::string& path, JsonParseMode mode = JsonParseMode::Automatic);
+
     std::shared_ptr<JsonNode> parseObject();
     std::shared_ptr<JsonNode> parseString();
     std::shared_ptr<JsonNode> parseNumber();
     std::shared_ptr<JsonNode> parseList();
     std::shared_ptr<JsonNode> parseBoolean();
     std::shared_ptr<JsonNode> parseNull();
+
+protected:
+    // Implemented for JsonBufferTokenizer and JsonIndexedTokenizer
+    template <typename Tokenizer> std::shared_ptr<JsonNode> parseBuffer(Tokenizer&);
+    std::shared_ptr<JsonNode> parseParallel(std::string_view, const JsonStructuralIndex&);
+    // Object keys are interned in the key table of the document. The depth is the nesting
+    // level of the value, checked with checkJsonDepth()
+    template <typename Tokenizer> std::shared_ptr<JsonNode> parseValue(Tokenizer&, JsonKeyTable&, size_t depth);
+    template <typename Tokenizer> std::shared_ptr<JsonNode> parseObject(Tokenizer&, JsonKeyTable&, size_t depth);
+    template <typename Tokenizer> std::shared_ptr<JsonNode> parseList(Tokenizer&, JsonKeyTable&, size_t depth);
+    std::shared_ptr<JsonNode> parseNumber(const JsonTokenView&);
 };
 
 }
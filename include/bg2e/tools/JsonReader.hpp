@@ -0,0 +1,117 @@
+#ifndef bg2e_tools_jsonreader_hpp
+#define bg2e_tools_jsonreader_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/tools/JsonToken.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace bg2e {
+namespace tools {
+
+enum class JsonEvent {
+    StartObject,
+    EndObject,
+    StartList,
+    EndList,
+    Key,
+    String,
+    Number,
+    Bool,
+    Null,
+    EndDocument
+};
+
+// Push interface for JsonReader::parse()
+class JsonHandler {
+public:
+    virtual ~JsonHandler() {}
+
+    virtual void startObject() {}
+    virtual void endObject() {}
+    virtual void startList() {}
+    virtual void endList() {}
+    virtual void key(std::string_view) {}
+    virtual void string(std::string_view) {}
+    virtual void number(double) {}
+    virtual void boolean(bool) {}
+    virtual void null() {}
+};
+
+// Pull event reader over a contiguous buffer. It validates the document structure
+// as it goes and does not build any tree: memory usage only depends on the nesting depth.
+class BG2E_EXPORT JsonReader {
+public:
+    JsonReader(std::string_view buffer);
+
+    // Throws std::logic_error if the input is not valid JSON
+    JsonEvent next();
+
+    void parse(JsonHandler& handler);
+
+    // Valid after a Key or String event, until the next call to next()
+    std::string_view stringValue();
+    inline std::string_view key() { return stringValue(); }
+
+    // Valid after a Number or Bool event
+    double numberValue() const;
+    int64_t integerValue() const;
+    bool isInteger() const;
+    inline bool boolValue() const { return _token.value == "true"; }
+
+    inline JsonEvent event() const { return _event; }
+    inline size_t depth() const { return _stack.size(); }
+    inline size_t position() const { return _tokenizer.position(); }
+
+    // Skips the next value, including all its children
+    void skipValue();
+
+    // Skips the rest of the current container, including its closing event
+    void skipContainer();
+
+    // Value helpers for deserializers: read the next value, or skip it and return the default
+    // value if it has not the expected type
+    float readFloat(float defaultValue);
+    double readDouble(double defaultValue);
+    int32_t readInt(int32_t defaultValue);
+    uint32_t readUInt(uint32_t defaultValue);
+    bool readBool(bool defaultValue);
+    std::string readString(const std::string& defaultValue);
+    glm::vec2 readVec2(const glm::vec2& defaultValue);
+    glm::vec3 readVec3(const glm::vec3& defaultValue);
+    glm::vec4 readVec4(const glm::vec4& defaultValue);
+    glm::mat4 readMat4(const glm::mat4& defaultValue);
+
+    // Reads a list of numbers into `result`. Returns false and leaves `result` unmodified if
+    // the value is not a list of at least `count` numbers
+    bool readFloats(float* result, size_t count);
+
+protected:
+    struct Frame {
+        bool object;
+        bool first;
+    };
+
+    JsonBufferTokenizer _tokenizer;
+    JsonTokenView _token;
+    JsonEvent _event = JsonEvent::Null;
+    std::vector<Frame> _stack;
+    std::string _scratch;
+    bool _afterKey = false;
+    bool _rootDone = false;
+
+    JsonEvent valueEvent(const JsonTokenView& token);
+    JsonEvent closeContainer(bool object);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef bg2e_tools_jsonstructuralindex_hpp
+#define bg2e_tools_jsonstructuralindex_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/tools/JsonToken.hpp>
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace bg2e {
+namespace tools {
+
+enum class JsonParseMode {
+    // Uses the structural index for buffers larger than JsonStructuralIndex::AutomaticThreshold,
+    // and JsonParser parses in parallel above JsonParser::ParallelThreshold
+    Automatic,
+    Tokenizer,
+    StructuralIndex,
+    // Structural index, and JsonParser parses the elements of a top level list in parallel
+    Parallel
+};
+
+// First stage of the two stage parser. Classifies the input 64 bytes at a time with
+// SIMD instructions (AVX2, SSE2 or NEON, with a scalar fallback) and stores the position
+// of every structural character, opening quote and scalar value outside strings.
+class BG2E_EXPORT JsonStructuralIndex {
+public:
+    static const size_t AutomaticThreshold = 64 * 1024;
+
+    JsonStructuralIndex() {}
+    JsonStructuralIndex(std::string_view buffer) { build(buffer); }
+
+    // Throws std::logic_error if the buffer ends inside a string
+    void build(std::string_view buffer);
+
+    // The last position is a sentinel with the buffer size
+    inline const std::vector<uint32_t>& positions() const { return _positions; }
+    inline size_t size() const { return _positions.empty() ? 0 : _positions.size() - 1; }
+
+    // Number of values, object keys included
+    inline size_t valueCount() const { return _valueCount; }
+
+    // Upper bound of the decoded size of all the strings
+    inline size_t stringBytes() const { return _stringBytes; }
+
+    // Instruction set used by build()
+    static const char* implementation();
+
+protected:
+    std::vector<uint32_t> _positions;
+    size_t _valueCount = 0;
+    size_t _stringBytes = 0;
+};
+
+// Second stage tokenizer: returns the same tokens as JsonBufferTokenizer, but jumps
+// between the positions stored in the structural index instead of scanning every byte
+class BG2E_EXPORT JsonIndexedTokenizer {
+public:
+    JsonIndexedTokenizer(std::string_view buffer, const JsonStructuralIndex& index);
+
+    // Tokenizes the `count` index entries starting at `first`
+    JsonIndexedTokenizer(std::string_view buffer, const JsonStructuralIndex& index, size_t first, size_t count);
+
+    inline bool hasMoreTokens() const { return _current < _count; }
+    const JsonTokenView& peekToken();
+    JsonTokenView getToken();
+
+    inline size_t position() const { return _current < _count ? _positions[_current] : _buffer.size(); }
+    inline std::string_view buffer() const { return _buffer; }
+
+protected:
+    std::string_view _buffer;
+    const uint32_t* _positions;
+    size_t _count;
+    size_t _current = 0;
+    JsonTokenView _lookahead;
+    bool _hasLookahead = false;
+
+    void scanToken(size_t index, JsonTokenView& token) const;
+};
+
+}
+}
+
+#endif
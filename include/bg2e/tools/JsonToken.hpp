@@ -4,7 +4,10 @@
 #include <bg2e/export.hpp>
 
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <stdexcept>
+#include <cstdint>
 
 namespace bg2e {
 namespace tools {
@@ -42,6 +45,74 @@ public:
     void rollBackToken();
 };
 
+// Token produced by JsonBufferTokenizer. The value references the tokenizer buffer: for
+// strings it contains the raw characters between the quotes, escape sequences included.
+struct JsonTokenView {
+    std::string_view value;
+    JsonTokenType type = JsonTokenType::NullType;
+    bool escaped = false;
+
+    std::string stringValue() const;
+};
+
+struct JsonNumber {
+    double doubleValue = 0.0;
+    int64_t integerValue = 0;
+    bool isInteger = false;
+};
+
+// Locale independent number parser. Integers that fit in 64 bits are returned exactly in
+// integerValue. Throws std::logic_error if the text is not a valid JSON number
+BG2E_EXPORT JsonNumber parseJsonNumber(std::string_view text);
+
+// Maximum nesting depth of objects and lists. The parsers and readers throw std::logic_error
+// for deeper documents instead of running out of stack
+static const size_t JsonMaxDepth = 512;
+
+inline void checkJsonDepth(size_t depth) {
+    if (depth > JsonMaxDepth) {
+        throw std::logic_error("Maximum nesting depth exceeded");
+    }
+}
+
+// Size of the buffers used by formatJsonNumber()
+static const size_t JsonNumberBufferSize = 32;
+
+// Locale independent formatter. Writes the shortest text that reads back as the same value,
+// with '.' as decimal separator, and returns its length. The value must be finite
+BG2E_EXPORT size_t formatJsonNumber(float value, char* buffer);
+BG2E_EXPORT size_t formatJsonNumber(double value, char* buffer);
+
+// Double value of the shortest text of a float, that is, the value read by the parsers from
+// the text written by JsonWriter: 0.1f returns 0.1 instead of 0.10000000149011612
+BG2E_EXPORT double jsonDecimalValue(float value);
+
+// Appends the decoded contents of a raw JSON string (without quotes) to `result`
+BG2E_EXPORT void unescapeJsonString(std::string_view raw, std::string& result);
+
+// Tokenizer over a contiguous buffer, with a single forward cursor and one token of lookahead
+class BG2E_EXPORT JsonBufferTokenizer {
+public:
+    JsonBufferTokenizer(std::string_view buffer);
+
+    bool hasMoreTokens();
+    const JsonTokenView& peekToken();
+    JsonTokenView getToken();
+
+    inline size_t position() const { return _hasLookahead ? _lookaheadPos : _pos; }
+    inline std::string_view buffer() const { return _buffer; }
+
+protected:
+    std::string_view _buffer;
+    size_t _pos = 0;
+    size_t _lookaheadPos = 0;
+    JsonTokenView _lookahead;
+    bool _hasLookahead = false;
+
+    bool scanToken(JsonTokenView& token);
+    void skipWhiteSpace();
+};
+
 }
 }
 
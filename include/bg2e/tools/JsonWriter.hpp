@@ -0,0 +1,97 @@
+#ifndef bg2e_tools_jsonwriter_hpp
+#define bg2e_tools_jsonwriter_hpp
+
+#include <bg2e/export.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace bg2e {
+namespace tools {
+
+class JsonNode;
+class JsonView;
+
+enum class JsonWriterFormat {
+    Compact,
+    Pretty
+};
+
+// Streaming JSON writer. The output is appended to a string, or buffered and written
+// to a stream in blocks. Numbers are written with formatJsonNumber(), so the text is the
+// same in any locale. Non finite numbers are written as null.
+class BG2E_EXPORT JsonWriter {
+public:
+    JsonWriter(std::string& buffer, JsonWriterFormat format = JsonWriterFormat::Compact);
+    JsonWriter(std::ostream& stream, JsonWriterFormat format = JsonWriterFormat::Compact);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    // Initial indentation level, used in pretty format
+    inline void setIndentationLevel(int level) { _indentationLevel = level; }
+
+    JsonWriter& startObject();
+    JsonWriter& endObject();
+    JsonWriter& startList();
+    JsonWriter& endList();
+    JsonWriter& key(std::string_view key);
+
+    JsonWriter& value(std::string_view v);
+    JsonWriter& value(const char* v) { return value(std::string_view(v)); }
+    JsonWriter& value(const std::string& v) { return value(std::string_view(v)); }
+    JsonWriter& value(int32_t v) { return value(static_cast<int64_t>(v)); }
+    JsonWriter& value(uint32_t v) { return value(static_cast<int64_t>(v)); }
+    JsonWriter& value(int64_t v);
+    JsonWriter& value(float v);
+    JsonWriter& value(double v);
+    JsonWriter& value(bool v);
+    JsonWriter& value(const glm::vec2& v);
+    JsonWriter& value(const glm::vec3& v);
+    JsonWriter& value(const glm::vec4& v);
+    JsonWriter& value(const glm::mat4& v);
+    JsonWriter& null();
+
+    template <typename T>
+    inline JsonWriter& field(std::string_view k, const T& v) { key(k); return value(v); }
+
+    JsonWriter& write(JsonNode& node);
+    JsonWriter& write(const JsonView& view);
+
+    void flush();
+
+protected:
+    struct Frame {
+        bool object;
+        bool first;
+    };
+
+    std::string _ownBuffer;
+    std::string& _buffer;
+    std::ostream* _stream = nullptr;
+    JsonWriterFormat _format;
+    std::vector<Frame> _stack;
+    int _indentationLevel = 0;
+    bool _afterKey = false;
+
+    void beginValue();
+    void closeContainer(char c);
+    void newLine(size_t level);
+    void writeFloats(const float* values, size_t count);
+    void appendEscaped(std::string_view str);
+    void checkFlush();
+};
+
+}
+}
+
+#endif
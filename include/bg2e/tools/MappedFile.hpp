@@ -0,0 +1,47 @@
+#ifndef bg2e_tools_mappedfile_hpp
+#define bg2e_tools_mappedfile_hpp
+
+#include <bg2e/export.hpp>
+#include <bg2e/types.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace bg2e {
+namespace tools {
+
+// Read only view of a file mapped in memory
+class BG2E_EXPORT MappedFile {
+public:
+    MappedFile();
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) noexcept;
+    MappedFile& operator=(MappedFile&&) noexcept;
+
+    void open(const std::string& path);
+    void close();
+
+    inline bool isOpen() const { return _data != nullptr || _fileHandle != nullptr; }
+    inline const Byte* data() const { return _data; }
+    inline size_t size() const { return _size; }
+    inline std::string_view view() const { return std::string_view(reinterpret_cast<const char*>(_data), _size); }
+    inline const std::string& path() const { return _path; }
+
+protected:
+    const Byte* _data = nullptr;
+    size_t _size = 0;
+    std::string _path;
+
+    // Platform handles: file descriptor on POSIX, file and mapping handles on Windows
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+};
+
+}
+}
+
+#endif
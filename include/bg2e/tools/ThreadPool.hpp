@@ -0,0 +1,52 @@
+#ifndef bg2e_tools_threadpool_hpp
+#define bg2e_tools_threadpool_hpp
+
+#include <bg2e/export.hpp>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace bg2e {
+namespace tools {
+
+// Fixed size pool of worker threads with a FIFO task queue
+class BG2E_EXPORT ThreadPool {
+public:
+    // Zero threads uses one thread less than the hardware concurrency, because the
+    // calling thread also runs work in parallelFor()
+    ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool shared by the engine subsystems, created on first use
+    static ThreadPool& shared();
+
+    inline size_t threadCount() const { return _workers.size(); }
+
+    void submit(std::function<void()>&& task);
+
+    // Calls fn(begin, end) for consecutive ranges of at most `grain` items, and waits until
+    // all of them have finished. The calling thread also processes ranges, so it is safe to
+    // call it from a worker thread. The first exception thrown by fn is rethrown.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+protected:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop = false;
+
+    void workerLoop();
+};
+
+}
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <bg2e/app/MainLoop.hpp>
 #include <bg2e/app/Window.hpp>
 #include <bg2e/app/AppController.hpp>
+#include <bg2e/base/AssetLoader.hpp>
 
 #include <iostream>
 #include <chrono>
@@ -35,6 +36,7 @@ int MainLoop::run()
     {
         auto startTime = std::chrono::high_resolution_clock::now();
         glfwPollEvents();
+        base::AssetLoader::shared().dispatchCallbacks();
         _window->appController()->frame(delta);
         _window->appController()->display();
         auto endTime = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,523 @@
+
+#include <bg2e/base/AssetCache.hpp>
+#include <bg2e/base/Bg2Reader.hpp>
+#include <bg2e/base/Bg2Writer.hpp>
+#include <bg2e/base/MeshOptimizer.hpp>
+#include <bg2e/base/MeshSimplifier.hpp>
+#include <bg2e/base/ObjImporter.hpp>
+#include <bg2e/tools/Hash.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <functional>
+
+namespace bg2e {
+namespace base {
+
+// Image entries: magic, level count, and a table with the size and data offset of each
+// level. The level data is aligned to 16 bytes
+struct CachedImageHeader
+{
+    char magic[4];
+    uint32_t levelCount;
+};
+
+struct CachedImageLevelHeader
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+static const char CachedImageMagic[4] = { 'b', 'g', 'i', '1' };
+
+static std::string hexString(uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i)
+    {
+        result[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return result;
+}
+
+// Content hash of a file, or an empty string if it can not be read
+static std::string fileHash(const std::string& path)
+{
+    try
+    {
+        tools::MappedFile file(path);
+        return hexString(tools::xxHash64(file.data(), file.size()));
+    }
+    catch (std::runtime_error&)
+    {
+        return "";
+    }
+}
+
+// Box filter of the previous level. Odd sizes repeat the last row or column
+static void buildMipLevel(const Byte* src, uint32_t srcWidth, uint32_t srcHeight, Byte* dst, uint32_t width, uint32_t height)
+{
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint32_t y0 = std::min(y * 2, srcHeight - 1);
+        uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t x0 = std::min(x * 2, srcWidth - 1);
+            uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+            const Byte* p00 = src + (static_cast<size_t>(y0) * srcWidth + x0) * 4;
+            const Byte* p01 = src + (static_cast<size_t>(y0) * srcWidth + x1) * 4;
+            const Byte* p10 = src + (static_cast<size_t>(y1) * srcWidth + x0) * 4;
+            const Byte* p11 = src + (static_cast<size_t>(y1) * srcWidth + x1) * 4;
+            Byte* out = dst + (static_cast<size_t>(y) * width + x) * 4;
+            for (int c = 0; c < 4; ++c)
+            {
+                out[c] = static_cast<Byte>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+    }
+}
+
+std::shared_ptr<Image> CachedImage::image(size_t level) const
+{
+    const CachedImageLevel& source = _levels.at(level);
+    Byte* data = new Byte[source.size];
+    std::memcpy(data, source.data, source.size);
+    auto result = std::make_shared<Image>();
+    result->set(data, Size{ source.width, source.height }, ImageComponentFormat::RGBA);
+    return result;
+}
+
+bool CachedImage::parse()
+{
+    _levels.clear();
+    const Byte* data = _file.data();
+    size_t size = _file.size();
+    CachedImageHeader header;
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, CachedImageMagic, 4) != 0 ||
+        header.levelCount > (size - sizeof(header)) / sizeof(CachedImageLevelHeader))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        CachedImageLevelHeader levelHeader;
+        std::memcpy(&levelHeader, data + sizeof(header) + i * sizeof(levelHeader), sizeof(levelHeader));
+        if (levelHeader.offset > size || levelHeader.size > size - levelHeader.offset ||
+            levelHeader.size != static_cast<uint64_t>(levelHeader.width) * levelHeader.height * 4)
+        {
+            _levels.clear();
+            return false;
+        }
+        _levels.push_back(CachedImageLevel{
+            levelHeader.width,
+            levelHeader.height,
+            data + levelHeader.offset,
+            static_cast<size_t>(levelHeader.size)
+        });
+    }
+    return !_levels.empty();
+}
+
+AssetCache::AssetCache(const std::string& directory, uint64_t maxSize)
+    :_directory(directory), _maxSize(maxSize)
+{
+    std::error_code err;
+    std::filesystem::create_directories(_directory, err);
+    if (!std::filesystem::is_directory(_directory, err))
+    {
+        throw std::runtime_error("AssetCache: could not create the cache directory '" + directory + "'");
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    scan();
+    evict("");
+}
+
+void AssetCache::setMaxSize(uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxSize = size;
+    evict("");
+}
+
+std::string AssetCache::key(const std::string& sourcePath, std::string_view parameters) const
+{
+    tools::MappedFile file(sourcePath);
+    uint64_t contentHash = tools::xxHash64(file.data(), file.size());
+    return hexString(tools::xxHash64(parameters, contentHash));
+}
+
+std::string AssetCache::entryPath(const std::string& key) const
+{
+    return (std::filesystem::path(_directory) / (key + ".bg2cache")).string();
+}
+
+AssetCache::LoadingScope::LoadingScope(AssetCache& cache, const std::string& key)
+    :_cache(cache), _key(key)
+{
+    std::unique_lock<std::mutex> lock(_cache._mutex);
+    _cache._loadingDone.wait(lock, [&]() { return _cache._loading.count(_key) == 0; });
+    _cache._loading.insert(_key);
+}
+
+AssetCache::LoadingScope::~LoadingScope()
+{
+    {
+        std::lock_guard<std::mutex> lock(_cache._mutex);
+        _cache._loading.erase(_key);
+    }
+    _cache._loadingDone.notify_all();
+}
+
+void AssetCache::scan()
+{
+    // The modification time of the entries is their last use time, so the LRU order is
+    // kept between launches
+    std::vector<std::pair<std::filesystem::file_time_type, std::string>> files;
+    std::error_code err;
+    for (const auto& item : std::filesystem::directory_iterator(_directory, err))
+    {
+        if (item.is_regular_file(err) && item.path().extension() == ".bg2cache")
+        {
+            std::string key = item.path().stem().string();
+            Entry entry;
+            entry.size = item.file_size(err);
+            _entries[key] = entry;
+            _size += entry.size;
+            files.emplace_back(item.last_write_time(err), key);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files)
+    {
+        _entries[file.second].lastUse = ++_useCounter;
+    }
+}
+
+void AssetCache::touch(const std::string& key, Entry& entry)
+{
+    entry.lastUse = ++_useCounter;
+    std::error_code err;
+    std::filesystem::last_write_time(entryPath(key), std::filesystem::file_time_type::clock::now(), err);
+}
+
+void AssetCache::evict(const std::string& keep)
+{
+    if (_maxSize == 0)
+    {
+        return;
+    }
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    for (const auto& entry : _entries)
+    {
+        if (entry.first != keep)
+        {
+            candidates.emplace_back(entry.second.lastUse, entry.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto& candidate : candidates)
+    {
+        if (_size <= _maxSize)
+        {
+            break;
+        }
+        // Mapped files can not be removed on Windows. They are kept until the next eviction
+        std::error_code err;
+        if (std::filesystem::remove(entryPath(candidate.second), err) || !std::filesystem::exists(entryPath(candidate.second), err))
+        {
+            _size -= _entries[candidate.second].size;
+            _entries.erase(candidate.second);
+            ++_stats.evictions;
+        }
+    }
+}
+
+bool AssetCache::find(const std::string& key, tools::MappedFile& result)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        try
+        {
+            result.open(entryPath(key));
+            touch(key, it->second);
+            ++_stats.hits;
+            return true;
+        }
+        catch (std::runtime_error&)
+        {
+            // Removed by another process
+            _size -= it->second.size;
+            _entries.erase(it);
+        }
+    }
+    ++_stats.misses;
+    return false;
+}
+
+void AssetCache::store(const std::string& key, const std::vector<Byte>& data, tools::MappedFile& result)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string path = entryPath(key);
+
+    // Write to a temporary file first, so an interrupted write is never used as an entry
+    std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file.good())
+        {
+            file.close();
+            std::error_code err;
+            std::filesystem::remove(tempPath, err);
+            throw std::runtime_error("AssetCache: could not write the cache entry '" + path + "'");
+        }
+    }
+    std::error_code err;
+    std::filesystem::remove(path, err);
+    std::filesystem::rename(tempPath, path, err);
+    if (err)
+    {
+        std::filesystem::remove(tempPath, err);
+        throw std::runtime_error("AssetCache: could not write the cache entry '" + path + "'");
+    }
+
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        _size -= it->second.size;
+    }
+    Entry& entry = _entries[key];
+    entry.size = data.size();
+    entry.lastUse = ++_useCounter;
+    _size += entry.size;
+    ++_stats.stores;
+
+    result.open(path);
+    evict(key);
+}
+
+void AssetCache::remove(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        std::error_code err;
+        std::filesystem::remove(entryPath(key), err);
+        _size -= it->second.size;
+        _entries.erase(it);
+    }
+}
+
+void AssetCache::reject(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stats.hits > 0)
+    {
+        --_stats.hits;
+    }
+    ++_stats.misses;
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        std::error_code err;
+        std::filesystem::remove(entryPath(key), err);
+        _size -= it->second.size;
+        _entries.erase(it);
+    }
+}
+
+void AssetCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& entry : _entries)
+    {
+        std::error_code err;
+        std::filesystem::remove(entryPath(entry.first), err);
+    }
+    _entries.clear();
+    _size = 0;
+}
+
+std::shared_ptr<CachedImage> AssetCache::loadImage(const std::string& path, bool mipmaps)
+{
+    std::string entryKey = key(path, mipmaps ? "image:rgba8:mipmaps" : "image:rgba8");
+    LoadingScope loading(*this, entryKey);
+    auto result = std::make_shared<CachedImage>();
+    if (find(entryKey, result->_file))
+    {
+        if (result->parse())
+        {
+            return result;
+        }
+        // Invalid entry: the mapping is closed before the image is cooked again
+        result->_file.close();
+        reject(entryKey);
+    }
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        throw std::runtime_error("Could not load image from file '" + path + "'");
+    }
+
+    std::vector<CachedImageLevelHeader> levels;
+    uint32_t levelWidth = static_cast<uint32_t>(width);
+    uint32_t levelHeight = static_cast<uint32_t>(height);
+    while (true)
+    {
+        levels.push_back(CachedImageLevelHeader{ levelWidth, levelHeight, 0, static_cast<uint64_t>(levelWidth) * levelHeight * 4 });
+        if (!mipmaps || (levelWidth == 1 && levelHeight == 1))
+        {
+            break;
+        }
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+    }
+
+    uint64_t offset = sizeof(CachedImageHeader) + levels.size() * sizeof(CachedImageLevelHeader);
+    for (auto& level : levels)
+    {
+        offset = (offset + 15) / 16 * 16;
+        level.offset = offset;
+        offset += level.size;
+    }
+
+    std::vector<Byte> data(offset, 0);
+    CachedImageHeader header;
+    std::memcpy(header.magic, CachedImageMagic, 4);
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), levels.data(), levels.size() * sizeof(CachedImageLevelHeader));
+    std::memcpy(data.data() + levels[0].offset, pixels, levels[0].size);
+    stbi_image_free(pixels);
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        buildMipLevel(
+            data.data() + levels[i - 1].offset, levels[i - 1].width, levels[i - 1].height,
+            data.data() + levels[i].offset, levels[i].width, levels[i].height);
+    }
+
+    store(entryKey, data, result->_file);
+    if (!result->parse())
+    {
+        throw std::runtime_error("AssetCache: invalid image cache entry for '" + path + "'");
+    }
+    return result;
+}
+
+std::shared_ptr<Bg2CookedModel> AssetCache::loadModel(const std::string& path, bool optimize)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    std::string parameters = optimize ? "model:bg2cooked:optimized:lod" : "model:bg2cooked";
+    if (extension == ".obj")
+    {
+        // The materials are read from the .mtl files. Missing files are also part of the key
+        for (const auto& library : ObjImporter::materialLibraries(path))
+        {
+            parameters += ":" + library + "=" + fileHash(library);
+        }
+    }
+    std::string entryKey = key(path, parameters);
+    LoadingScope loading(*this, entryKey);
+    auto result = std::make_shared<Bg2CookedModel>();
+    tools::MappedFile file;
+    if (find(entryKey, file))
+    {
+        try
+        {
+            result->load(std::move(file));
+            return result;
+        }
+        catch (std::runtime_error&)
+        {
+            // Invalid entry: the mapping is closed before the model is cooked again
+            file.close();
+            reject(entryKey);
+        }
+    }
+
+    Bg2Writer writer;
+    if (extension == ".obj")
+    {
+        ObjImporter importer;
+        importer.load(path);
+        for (size_t i = 0; i < importer.polyLists().size(); ++i)
+        {
+            writer.addPolyList(importer.polyLists()[i], importer.materialNames()[i]);
+        }
+        writer.setMaterials(importer.materials());
+    }
+    else
+    {
+        Bg2Reader reader;
+        reader.load(path);
+        for (size_t i = 0; i < reader.polyLists().size(); ++i)
+        {
+            writer.addPolyList(reader.polyLists()[i], reader.materialNames()[i]);
+        }
+        writer.setMaterials(reader.materials());
+        writer.setJoints(reader.joints());
+    }
+
+    if (optimize)
+    {
+        // The levels of detail are built first, so the optimizer sorts them too
+        MeshSimplifier simplifier;
+        MeshOptimizer optimizer;
+        const auto& polyLists = writer.polyLists();
+        tools::ThreadPool::shared().parallelFor(polyLists.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                simplifier.buildLods(*polyLists[i]);
+                optimizer.optimize(*polyLists[i]);
+            }
+        });
+    }
+
+    std::vector<Byte> data;
+    writer.writeCooked(data);
+    store(entryKey, data, file);
+    result->load(std::move(file));
+    return result;
+}
+
+AssetCacheStats AssetCache::stats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    AssetCacheStats result = _stats;
+    result.size = _size;
+    result.entryCount = _entries.size();
+    return result;
+}
+
+void AssetCache::resetStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats = AssetCacheStats();
+}
+
+}
+}
@@ -0,0 +1,274 @@
+
+#include <bg2e/base/AssetLoader.hpp>
+
+#include <algorithm>
+
+namespace bg2e {
+namespace base {
+
+AssetLoader::AssetLoader(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        _workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        for (auto& entry : _queue)
+        {
+            finishCancelled(entry.request);
+        }
+        _queue.clear();
+    }
+    _condition.notify_all();
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+AssetLoader& AssetLoader::shared()
+{
+    static AssetLoader loader;
+    return loader;
+}
+
+AssetHandle<Image> AssetLoader::loadImage(const std::string& path, AssetPriority priority, const Callback<Image>& callback)
+{
+    return load<Image>(path, [](const std::string& p) { return Image::LoadFromFile(p); }, priority, callback);
+}
+
+AssetHandle<Bg2Reader> AssetLoader::loadBg2Model(const std::string& path, AssetPriority priority, const Callback<Bg2Reader>& callback)
+{
+    return load<Bg2Reader>(path, [](const std::string& p) {
+        auto reader = std::make_shared<Bg2Reader>();
+        reader->load(p);
+        return reader;
+    }, priority, callback);
+}
+
+std::shared_ptr<AssetRequest> AssetLoader::enqueue(
+    const std::string& path,
+    const std::string& key,
+    std::function<std::shared_ptr<void>()>&& decode,
+    AssetPriority priority,
+    const std::shared_ptr<AssetSubscription>& subscription)
+{
+    std::shared_ptr<AssetRequest> request;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _activeRequests.find(key);
+        if (it != _activeRequests.end())
+        {
+            // Concurrent request for the same asset: share the decode, and raise its priority
+            request = it->second;
+            request->_subscriptions.push_back(subscription);
+            if (request->status() == AssetStatus::Pending && priority > request->_priority)
+            {
+                _queue.erase(QueueEntry{ request->_priority, request->_sequence, request });
+                request->_priority = priority;
+                _queue.insert(QueueEntry{ request->_priority, request->_sequence, request });
+            }
+            return request;
+        }
+
+        request = std::make_shared<AssetRequest>();
+        request->_path = path;
+        request->_key = key;
+        request->_priority = priority;
+        request->_sequence = _nextSequence++;
+        request->_decode = std::move(decode);
+        request->_subscriptions.push_back(subscription);
+
+        if (_stop)
+        {
+            finishCancelled(request);
+            return request;
+        }
+        _activeRequests[key] = request;
+        _queue.insert(QueueEntry{ priority, request->_sequence, request });
+    }
+    _condition.notify_one();
+    return request;
+}
+
+void AssetLoader::setPriority(const std::shared_ptr<AssetRequest>& request, AssetPriority priority)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (request && request->status() == AssetStatus::Pending && request->_priority != priority)
+    {
+        _queue.erase(QueueEntry{ request->_priority, request->_sequence, request });
+        request->_priority = priority;
+        _queue.insert(QueueEntry{ request->_priority, request->_sequence, request });
+    }
+}
+
+bool AssetLoader::cancel(const std::shared_ptr<AssetRequest>& request)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return request ? cancelRequest(request) : false;
+}
+
+bool AssetLoader::cancel(const std::shared_ptr<AssetRequest>& request, const std::shared_ptr<AssetSubscription>& subscription)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!request || request->isDone() || subscription->cancelled)
+    {
+        return false;
+    }
+
+    // The last subscription cancels the request, and its callback receives the cancelled
+    // request. The rest are detached
+    auto& subscriptions = request->_subscriptions;
+    auto it = std::find(subscriptions.begin(), subscriptions.end(), subscription);
+    if (it != subscriptions.end() && subscriptions.size() == 1)
+    {
+        return cancelRequest(request);
+    }
+    subscription->cancelled = true;
+    if (it != subscriptions.end())
+    {
+        subscriptions.erase(it);
+    }
+    return true;
+}
+
+bool AssetLoader::cancelRequest(const std::shared_ptr<AssetRequest>& request)
+{
+    switch (request->status())
+    {
+    case AssetStatus::Pending:
+        _queue.erase(QueueEntry{ request->_priority, request->_sequence, request });
+        finishCancelled(request);
+        return true;
+    case AssetStatus::Loading:
+        {
+            // New requests for the same asset must not share the cancelled decode
+            request->_cancelRequested = true;
+            auto it = _activeRequests.find(request->_key);
+            if (it != _activeRequests.end() && it->second == request)
+            {
+                _activeRequests.erase(it);
+            }
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+void AssetLoader::finishCancelled(const std::shared_ptr<AssetRequest>& request)
+{
+    auto it = _activeRequests.find(request->_key);
+    if (it != _activeRequests.end() && it->second == request)
+    {
+        _activeRequests.erase(it);
+    }
+    request->_decode = nullptr;
+    request->_status = AssetStatus::Cancelled;
+    request->_promise.set_exception(std::make_exception_ptr(AssetCancelledError(request->_path)));
+    _completed.push_back(request);
+}
+
+void AssetLoader::workerLoop()
+{
+    while (true)
+    {
+        std::shared_ptr<AssetRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+            if (_queue.empty())
+            {
+                return;
+            }
+            request = _queue.begin()->request;
+            _queue.erase(_queue.begin());
+            request->_status = AssetStatus::Loading;
+        }
+
+        std::shared_ptr<void> result;
+        std::exception_ptr error;
+        try
+        {
+            result = request->_decode();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (request->_cancelRequested)
+        {
+            finishCancelled(request);
+            continue;
+        }
+        auto it = _activeRequests.find(request->_key);
+        if (it != _activeRequests.end() && it->second == request)
+        {
+            _activeRequests.erase(it);
+        }
+        request->_decode = nullptr;
+        if (error)
+        {
+            request->_status = AssetStatus::Failed;
+            request->_promise.set_exception(error);
+        }
+        else
+        {
+            request->_status = AssetStatus::Loaded;
+            request->_promise.set_value(result);
+        }
+        _completed.push_back(request);
+    }
+}
+
+size_t AssetLoader::dispatchCallbacks(size_t maxRequests)
+{
+    size_t count = 0;
+    while (count < maxRequests)
+    {
+        std::shared_ptr<AssetRequest> request;
+        std::vector<std::shared_ptr<AssetSubscription>> subscriptions;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_completed.empty())
+            {
+                break;
+            }
+            request = _completed.front();
+            _completed.pop_front();
+            subscriptions.swap(request->_subscriptions);
+        }
+
+        for (auto& subscription : subscriptions)
+        {
+            if (subscription->callback)
+            {
+                subscription->callback(*request);
+            }
+        }
+        ++count;
+    }
+    return count;
+}
+
+size_t AssetLoader::activeRequestCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _activeRequests.size();
+}
+
+}
+}
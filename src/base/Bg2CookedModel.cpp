@@ -0,0 +1,307 @@
+
+#include <bg2e/base/Bg2CookedModel.hpp>
+#include <bg2e/tools/JsonParser.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace bg2e {
+namespace base {
+
+uint32_t bg2CookedAttributeSize(BufferType attribute)
+{
+    switch (attribute)
+    {
+    case BufferTypeVertex:
+    case BufferTypeNormal:
+    case BufferTypeTangent:
+        return 3 * sizeof(float);
+    case BufferTypeTexCoord0:
+    case BufferTypeTexCoord1:
+    case BufferTypeTexCoord2:
+        return 2 * sizeof(float);
+    case BufferTypeColor:
+        return 4 * sizeof(float);
+    default:
+        return 0;
+    }
+}
+
+uint32_t Bg2CookedPolyList::attributeOffset(BufferType attribute) const
+{
+    uint32_t offset = 0;
+    for (uint32_t flag = BufferTypeVertex; flag < static_cast<uint32_t>(attribute); flag <<= 1)
+    {
+        if (attributes & flag)
+        {
+            offset += bg2CookedAttributeSize(static_cast<BufferType>(flag));
+        }
+    }
+    return offset;
+}
+
+// Sequential reader of the chunk data, in the host byte order
+class Bg2CookedChunkReader
+{
+public:
+    Bg2CookedChunkReader(const Byte* data, size_t size, size_t pos)
+        :_data(data), _size(size), _pos(pos)
+    {
+    }
+
+    std::string_view readTag()
+    {
+        return std::string_view(reinterpret_cast<const char*>(read(4)), 4);
+    }
+
+    uint32_t readInt()
+    {
+        uint32_t value;
+        std::memcpy(&value, read(4), 4);
+        return value;
+    }
+
+    std::string_view readString()
+    {
+        size_t length = readInt();
+        return std::string_view(reinterpret_cast<const char*>(read(length)), length);
+    }
+
+    float readFloat()
+    {
+        float value;
+        std::memcpy(&value, read(sizeof(float)), sizeof(float));
+        return value;
+    }
+
+    glm::vec3 readVec3()
+    {
+        glm::vec3 result;
+        std::memcpy(&result, read(sizeof(float) * 3), sizeof(float) * 3);
+        return result;
+    }
+
+    // Skips the padding that aligns the next block, and returns the block data
+    const Byte* readBlock(size_t itemCount, size_t itemSize)
+    {
+        read((Bg2CookedBlockAlignment - _pos % Bg2CookedBlockAlignment) % Bg2CookedBlockAlignment);
+        if (itemSize > 0 && itemCount > (_size - _pos) / itemSize)
+        {
+            throw std::runtime_error("Bg2CookedModel: unexpected end of file");
+        }
+        return read(itemCount * itemSize);
+    }
+
+protected:
+    const Byte* _data;
+    size_t _size;
+    size_t _pos;
+
+    const Byte* read(size_t bytes)
+    {
+        if (bytes > _size - _pos)
+        {
+            throw std::runtime_error("Bg2CookedModel: unexpected end of file");
+        }
+        const Byte* result = _data + _pos;
+        _pos += bytes;
+        return result;
+    }
+};
+
+static std::shared_ptr<tools::JsonNode> parseCookedJsonChunk(std::string_view data)
+{
+    try
+    {
+        tools::JsonParser parser;
+        return data.empty() ? nullptr : parser.parse(data);
+    }
+    catch (std::logic_error& err)
+    {
+        throw std::runtime_error(std::string("Bg2CookedModel: invalid JSON chunk: ") + err.what());
+    }
+}
+
+Bg2CookedModel::Bg2CookedModel()
+{
+
+}
+
+void Bg2CookedModel::load(const std::string& path)
+{
+    load(tools::MappedFile(path));
+}
+
+void Bg2CookedModel::load(tools::MappedFile&& file)
+{
+    clear();
+    load(file.data(), file.size());
+    _file = std::move(file);
+}
+
+void Bg2CookedModel::load(const Byte* data, size_t size)
+{
+    clear();
+
+    Byte hostEndian = std::endian::native == std::endian::big ? 0 : 1;
+    if (size < 4 || data[0] != hostEndian)
+    {
+        throw std::runtime_error("Bg2CookedModel: invalid file header");
+    }
+    if (reinterpret_cast<uintptr_t>(data) % Bg2CookedBlockAlignment != 0)
+    {
+        throw std::runtime_error("Bg2CookedModel: the file data is not aligned");
+    }
+
+    Bg2CookedChunkReader reader(data, size, 4);
+    if (reader.readTag() != "cook")
+    {
+        throw std::runtime_error("Bg2CookedModel: invalid file header");
+    }
+    uint32_t polyListCount = reader.readInt();
+    _polyLists.reserve(std::min<size_t>(polyListCount, size / 4));
+
+    auto current = [&]() -> Bg2CookedPolyList&
+    {
+        if (_polyLists.empty())
+        {
+            throw std::runtime_error("Bg2CookedModel: poly list data found outside a plst chunk");
+        }
+        return _polyLists.back();
+    };
+
+    try
+    {
+        while (true)
+        {
+            std::string_view tag = reader.readTag();
+            if (tag == "endf")
+            {
+                break;
+            }
+            else if (tag == "mtrl")
+            {
+                _materials = parseCookedJsonChunk(reader.readString());
+            }
+            else if (tag == "join")
+            {
+                _joints = parseCookedJsonChunk(reader.readString());
+            }
+            else if (tag == "plst")
+            {
+                _polyLists.push_back(Bg2CookedPolyList());
+            }
+            else if (tag == "pnam")
+            {
+                current().name = reader.readString();
+            }
+            else if (tag == "mnam")
+            {
+                current().materialName = reader.readString();
+            }
+            else if (tag == "vfmt")
+            {
+                Bg2CookedPolyList& plist = current();
+                plist.attributes = reader.readInt();
+                plist.stride = reader.readInt();
+                uint32_t stride = 0;
+                for (uint32_t flag = BufferTypeVertex; flag <= BufferTypeTangent; flag <<= 1)
+                {
+                    stride += (plist.attributes & flag) ? bg2CookedAttributeSize(static_cast<BufferType>(flag)) : 0;
+                }
+                if (stride != plist.stride || (plist.attributes & ~0x7Fu) != 0)
+                {
+                    throw std::runtime_error("Bg2CookedModel: invalid vertex format");
+                }
+            }
+            else if (tag == "bnds")
+            {
+                Bg2CookedPolyList& plist = current();
+                plist.bounds.min = reader.readVec3();
+                plist.bounds.max = reader.readVec3();
+            }
+            else if (tag == "vblk")
+            {
+                Bg2CookedPolyList& plist = current();
+                plist.vertexCount = reader.readInt();
+                plist.vertexData = reader.readBlock(plist.vertexCount, plist.stride);
+            }
+            else if (tag == "iblk")
+            {
+                Bg2CookedPolyList& plist = current();
+                plist.indexCount = reader.readInt();
+                plist.indexData = reinterpret_cast<const uint32_t*>(reader.readBlock(plist.indexCount, sizeof(uint32_t)));
+            }
+            else if (tag == "lodi")
+            {
+                Bg2CookedLod lod;
+                lod.error = reader.readFloat();
+                lod.indexCount = reader.readInt();
+                lod.indexData = reinterpret_cast<const uint32_t*>(reader.readBlock(lod.indexCount, sizeof(uint32_t)));
+                current().lods.push_back(lod);
+            }
+            else
+            {
+                throw std::runtime_error("Bg2CookedModel: unknown chunk '" + std::string(tag) + "'");
+            }
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+}
+
+void Bg2CookedModel::clear()
+{
+    _polyLists.clear();
+    _materials = nullptr;
+    _joints = nullptr;
+    _file.close();
+}
+
+std::shared_ptr<PolyList> Bg2CookedModel::polyList(size_t index) const
+{
+    const Bg2CookedPolyList& cooked = _polyLists.at(index);
+    auto result = std::make_shared<PolyList>();
+    result->setName(std::string(cooked.name));
+
+    auto extract = [&](BufferType attribute) {
+        std::vector<float> stream;
+        if (cooked.attributes & attribute)
+        {
+            uint32_t size = bg2CookedAttributeSize(attribute);
+            uint32_t offset = cooked.attributeOffset(attribute);
+            stream.resize(cooked.vertexCount * size / sizeof(float));
+            Byte* dst = reinterpret_cast<Byte*>(stream.data());
+            for (size_t v = 0; v < cooked.vertexCount; ++v)
+            {
+                std::memcpy(dst + v * size, cooked.vertexData + v * cooked.stride + offset, size);
+            }
+        }
+        return stream;
+    };
+    result->setVertex(extract(BufferTypeVertex));
+    result->setNormal(extract(BufferTypeNormal));
+    result->setTexCoord0(extract(BufferTypeTexCoord0));
+    result->setTexCoord1(extract(BufferTypeTexCoord1));
+    result->setTexCoord2(extract(BufferTypeTexCoord2));
+    result->setColor(extract(BufferTypeColor));
+    result->setIndex(std::vector<uint32_t>(cooked.indexData, cooked.indexData + cooked.indexCount));
+
+    std::vector<PolyListLod> lods;
+    lods.reserve(cooked.lods.size());
+    for (const auto& lod : cooked.lods)
+    {
+        lods.push_back({ std::vector<uint32_t>(lod.indexData, lod.indexData + lod.indexCount), lod.error });
+    }
+    result->setLods(std::move(lods));
+    return result;
+}
+
+}
+}
@@ -0,0 +1,339 @@
+
+#include <bg2e/base/Bg2Reader.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+#include <bg2e/tools/JsonParser.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace bg2e {
+namespace base {
+
+static inline uint32_t swapBytes(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0x0000FF00) | ((v << 8) & 0x00FF0000) | (v << 24);
+}
+
+// Location of a 32 bit array in the file data
+struct Bg2ArrayChunk
+{
+    const Byte* data = nullptr;
+    size_t count = 0;
+};
+
+struct Bg2PolyListChunks
+{
+    std::string_view name;
+    std::string_view materialName;
+    Bg2ArrayChunk vertex;
+    Bg2ArrayChunk normal;
+    Bg2ArrayChunk texCoord0;
+    Bg2ArrayChunk texCoord1;
+    Bg2ArrayChunk texCoord2;
+    Bg2ArrayChunk color;
+    Bg2ArrayChunk index;
+};
+
+// Sequential reader of the chunk data. Every read checks the remaining size
+class Bg2ChunkReader
+{
+public:
+    Bg2ChunkReader(const Byte* data, size_t size, bool swap)
+        :_data(data), _size(size), _swap(swap)
+    {
+    }
+
+    inline size_t remaining() const { return _size - _pos; }
+
+    std::string_view readTag()
+    {
+        return std::string_view(reinterpret_cast<const char*>(read(4)), 4);
+    }
+
+    int32_t readInt()
+    {
+        uint32_t value;
+        std::memcpy(&value, read(4), 4);
+        return static_cast<int32_t>(_swap ? swapBytes(value) : value);
+    }
+
+    size_t readCount(size_t itemSize)
+    {
+        int32_t count = readInt();
+        if (count < 0 || static_cast<size_t>(count) > remaining() / itemSize)
+        {
+            throw std::runtime_error("Bg2Reader: invalid chunk size");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    std::string_view readString()
+    {
+        size_t length = readCount(1);
+        return std::string_view(reinterpret_cast<const char*>(read(length)), length);
+    }
+
+    Bg2ArrayChunk readArray()
+    {
+        Bg2ArrayChunk result;
+        result.count = readCount(4);
+        result.data = read(result.count * 4);
+        return result;
+    }
+
+protected:
+    const Byte* _data;
+    size_t _size;
+    size_t _pos = 0;
+    bool _swap;
+
+    const Byte* read(size_t bytes)
+    {
+        if (bytes > remaining())
+        {
+            throw std::runtime_error("Bg2Reader: unexpected end of file");
+        }
+        const Byte* result = _data + _pos;
+        _pos += bytes;
+        return result;
+    }
+};
+
+// Arrays are copied with a single memcpy, or with a single byte swap pass. The data may not
+// be aligned inside the file, so it is never accessed in place
+template <typename T>
+static std::vector<T> decodeArray(const Bg2ArrayChunk& chunk, bool swap)
+{
+    static_assert(sizeof(T) == 4);
+    std::vector<T> result(chunk.count);
+    if (swap)
+    {
+        uint32_t* dst = reinterpret_cast<uint32_t*>(result.data());
+        for (size_t i = 0; i < chunk.count; ++i)
+        {
+            uint32_t value;
+            std::memcpy(&value, chunk.data + i * 4, 4);
+            dst[i] = swapBytes(value);
+        }
+    }
+    else if (chunk.count > 0)
+    {
+        std::memcpy(result.data(), chunk.data, chunk.count * 4);
+    }
+    return result;
+}
+
+static std::shared_ptr<PolyList> decodePolyList(const Bg2PolyListChunks& chunks, bool swap, bool generateTangents)
+{
+    auto result = std::make_shared<PolyList>();
+    result->setName(std::string(chunks.name));
+    result->setVertex(decodeArray<float>(chunks.vertex, swap));
+    result->setNormal(decodeArray<float>(chunks.normal, swap));
+    result->setTexCoord0(decodeArray<float>(chunks.texCoord0, swap));
+    result->setTexCoord1(decodeArray<float>(chunks.texCoord1, swap));
+    result->setTexCoord2(decodeArray<float>(chunks.texCoord2, swap));
+    result->setColor(decodeArray<float>(chunks.color, swap));
+    result->setIndex(decodeArray<uint32_t>(chunks.index, swap));
+    if (generateTangents)
+    {
+        result->assertValidTangents();
+    }
+    return result;
+}
+
+static std::shared_ptr<tools::JsonNode> parseJsonChunk(std::string_view data)
+{
+    if (data.empty())
+    {
+        return nullptr;
+    }
+    try
+    {
+        tools::JsonParser parser;
+        return parser.parse(data);
+    }
+    catch (std::logic_error& err)
+    {
+        throw std::runtime_error(std::string("Bg2Reader: invalid JSON chunk: ") + err.what());
+    }
+}
+
+Bg2Reader::Bg2Reader()
+{
+
+}
+
+void Bg2Reader::load(const std::string& path)
+{
+    tools::MappedFile file(path);
+    load(file.data(), file.size());
+}
+
+void Bg2Reader::load(const Byte* data, size_t size)
+{
+    clear();
+
+    if (size < 4)
+    {
+        throw std::runtime_error("Bg2Reader: invalid file header");
+    }
+
+    // Header: endianness (0: big endian, 1: little endian) and version
+    bool bigEndian = data[0] == 0;
+    bool swap = bigEndian != (std::endian::native == std::endian::big);
+    _majorVersion = data[1];
+    _minorVersion = data[2];
+    _revision = data[3];
+
+    Bg2ChunkReader reader(data + 4, size - 4, swap);
+
+    if (reader.readTag() != "hedr")
+    {
+        throw std::runtime_error("Bg2Reader: invalid file header");
+    }
+
+    // First pass: find the chunks without copying any data
+    std::string_view materialsData;
+    std::string_view jointsData;
+    std::vector<Bg2PolyListChunks> polyListChunks;
+    int32_t polyListCount = reader.readInt();
+    if (polyListCount > 0)
+    {
+        polyListChunks.reserve(std::min(static_cast<size_t>(polyListCount), reader.remaining() / 4));
+    }
+
+    auto current = [&]() -> Bg2PolyListChunks&
+    {
+        if (polyListChunks.empty())
+        {
+            throw std::runtime_error("Bg2Reader: poly list data found outside a plst chunk");
+        }
+        return polyListChunks.back();
+    };
+
+    while (true)
+    {
+        std::string_view tag = reader.readTag();
+        if (tag == "endf")
+        {
+            break;
+        }
+        else if (tag == "mtrl")
+        {
+            materialsData = reader.readString();
+        }
+        else if (tag == "join")
+        {
+            jointsData = reader.readString();
+        }
+        else if (tag == "plst")
+        {
+            polyListChunks.push_back(Bg2PolyListChunks());
+        }
+        else if (tag == "pnam")
+        {
+            current().name = reader.readString();
+        }
+        else if (tag == "mnam")
+        {
+            current().materialName = reader.readString();
+        }
+        else if (tag == "varr")
+        {
+            current().vertex = reader.readArray();
+        }
+        else if (tag == "narr")
+        {
+            current().normal = reader.readArray();
+        }
+        else if (tag == "t0ar")
+        {
+            current().texCoord0 = reader.readArray();
+        }
+        else if (tag == "t1ar")
+        {
+            current().texCoord1 = reader.readArray();
+        }
+        else if (tag == "t2ar")
+        {
+            current().texCoord2 = reader.readArray();
+        }
+        else if (tag == "carr")
+        {
+            current().color = reader.readArray();
+        }
+        else if (tag == "tarr")
+        {
+            // Tangents are generated by PolyList::rebuildTangents()
+            current();
+            reader.readArray();
+        }
+        else if (tag == "indx")
+        {
+            current().index = reader.readArray();
+        }
+        else
+        {
+            throw std::runtime_error("Bg2Reader: unknown chunk '" + std::string(tag) + "'");
+        }
+    }
+
+    // Second pass: each poly list is decoded in its own task, and the first task parses the
+    // JSON chunks. The results are stored by index, so they keep the file order
+    size_t count = polyListChunks.size();
+    _polyLists.resize(count);
+    _materialNames.resize(count);
+    _bounds.resize(count);
+    auto decode = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (i == 0)
+            {
+                _materials = parseJsonChunk(materialsData);
+                _joints = parseJsonChunk(jointsData);
+                continue;
+            }
+            const Bg2PolyListChunks& chunks = polyListChunks[i - 1];
+            _polyLists[i - 1] = decodePolyList(chunks, swap, _generateTangents);
+            _materialNames[i - 1] = std::string(chunks.materialName);
+            _bounds[i - 1] = _polyLists[i - 1]->computeBounds();
+        }
+    };
+
+    try
+    {
+        if (_parallel)
+        {
+            tools::ThreadPool::shared().parallelFor(count + 1, 1, decode);
+        }
+        else
+        {
+            decode(0, count + 1);
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+}
+
+void Bg2Reader::clear()
+{
+    _polyLists.clear();
+    _materialNames.clear();
+    _bounds.clear();
+    _materials = nullptr;
+    _joints = nullptr;
+    _majorVersion = 0;
+    _minorVersion = 0;
+    _revision = 0;
+}
+
+}
+}
@@ -0,0 +1,306 @@
+
+#include <bg2e/base/Bg2Writer.hpp>
+#include <bg2e/base/Bg2CookedModel.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace bg2e {
+namespace base {
+
+// Appends chunk data to a byte vector, in the byte order of the file
+class Bg2ByteWriter
+{
+public:
+    Bg2ByteWriter(std::vector<Byte>& data, bool bigEndian)
+        :_data(data), _start(data.size()), _swap(bigEndian != (std::endian::native == std::endian::big))
+    {
+    }
+
+    void tag(std::string_view t)
+    {
+        _data.insert(_data.end(), t.begin(), t.end());
+    }
+
+    void int32(uint32_t value)
+    {
+        if (_swap)
+        {
+            value = swapBytes(value);
+        }
+        append(&value, 4);
+    }
+
+    void string(std::string_view s)
+    {
+        int32(static_cast<uint32_t>(s.size()));
+        _data.insert(_data.end(), s.begin(), s.end());
+    }
+
+    template <typename T>
+    void array(const std::vector<T>& values)
+    {
+        static_assert(sizeof(T) == 4);
+        int32(static_cast<uint32_t>(values.size()));
+        if (_swap)
+        {
+            size_t offset = _data.size();
+            _data.resize(offset + values.size() * 4);
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                uint32_t value = swapBytes(std::bit_cast<uint32_t>(values[i]));
+                std::memcpy(_data.data() + offset + i * 4, &value, 4);
+            }
+        }
+        else
+        {
+            append(values.data(), values.size() * 4);
+        }
+    }
+
+    void append(const void* data, size_t size)
+    {
+        if (size > 0)
+        {
+            const Byte* bytes = static_cast<const Byte*>(data);
+            _data.insert(_data.end(), bytes, bytes + size);
+        }
+    }
+
+    // Alignment is relative to the start of the file
+    void align(size_t alignment)
+    {
+        size_t size = _data.size() - _start;
+        _data.resize(_start + (size + alignment - 1) / alignment * alignment, 0);
+    }
+
+protected:
+    std::vector<Byte>& _data;
+    size_t _start;
+    bool _swap;
+
+    static inline uint32_t swapBytes(uint32_t v)
+    {
+        return (v >> 24) | ((v >> 8) & 0x0000FF00) | ((v << 8) & 0x00FF0000) | (v << 24);
+    }
+};
+
+static void writeHeader(Bg2ByteWriter& writer, bool bigEndian, Byte major, Byte minor, Byte revision)
+{
+    Byte header[] = { static_cast<Byte>(bigEndian ? 0 : 1), major, minor, revision };
+    writer.append(header, 4);
+}
+
+static void writeJsonChunk(Bg2ByteWriter& writer, std::string_view tag, const std::shared_ptr<tools::JsonNode>& node)
+{
+    if (node)
+    {
+        std::string json;
+        {
+            tools::JsonWriter jsonWriter(json);
+            jsonWriter.write(*node);
+        }
+        writer.tag(tag);
+        writer.string(json);
+    }
+}
+
+static void saveFile(const std::string& path, const std::vector<Byte>& data)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open file '" + path + "' for writing");
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file.good())
+    {
+        throw std::runtime_error("Could not write file '" + path + "'");
+    }
+}
+
+Bg2Writer::Bg2Writer()
+{
+
+}
+
+void Bg2Writer::addPolyList(const std::shared_ptr<PolyList>& polyList, const std::string& materialName)
+{
+    _polyLists.push_back(polyList);
+    _materialNames.push_back(materialName);
+}
+
+void Bg2Writer::clear()
+{
+    _polyLists.clear();
+    _materialNames.clear();
+    _materials = nullptr;
+    _joints = nullptr;
+}
+
+void Bg2Writer::save(const std::string& path)
+{
+    std::vector<Byte> data;
+    write(data);
+    saveFile(path, data);
+}
+
+void Bg2Writer::write(std::vector<Byte>& result)
+{
+    Bg2ByteWriter writer(result, _bigEndian);
+    writeHeader(writer, _bigEndian, 1, 2, 0);
+    writer.tag("hedr");
+    writer.int32(static_cast<uint32_t>(_polyLists.size()));
+    writeJsonChunk(writer, "mtrl", _materials);
+    writeJsonChunk(writer, "join", _joints);
+
+    for (size_t i = 0; i < _polyLists.size(); ++i)
+    {
+        const PolyList& plist = *_polyLists[i];
+        writer.tag("plst");
+        writer.tag("pnam");
+        writer.string(plist.name());
+        writer.tag("mnam");
+        writer.string(_materialNames[i]);
+        writer.tag("varr");
+        writer.array(plist.vertex());
+        if (plist.normal().size() > 0)
+        {
+            writer.tag("narr");
+            writer.array(plist.normal());
+        }
+        if (plist.texCoord0().size() > 0)
+        {
+            writer.tag("t0ar");
+            writer.array(plist.texCoord0());
+        }
+        if (plist.texCoord1().size() > 0)
+        {
+            writer.tag("t1ar");
+            writer.array(plist.texCoord1());
+        }
+        if (plist.texCoord2().size() > 0)
+        {
+            writer.tag("t2ar");
+            writer.array(plist.texCoord2());
+        }
+        if (plist.color().size() > 0)
+        {
+            writer.tag("carr");
+            writer.array(plist.color());
+        }
+        writer.tag("indx");
+        writer.array(plist.index());
+    }
+
+    writer.tag("endf");
+}
+
+void Bg2Writer::saveCooked(const std::string& path)
+{
+    std::vector<Byte> data;
+    writeCooked(data);
+    saveFile(path, data);
+}
+
+void Bg2Writer::writeCooked(std::vector<Byte>& result)
+{
+    const bool bigEndian = std::endian::native == std::endian::big;
+    Bg2ByteWriter writer(result, bigEndian);
+    writeHeader(writer, bigEndian, 1, 0, 0);
+    writer.tag("cook");
+    writer.int32(static_cast<uint32_t>(_polyLists.size()));
+    writeJsonChunk(writer, "mtrl", _materials);
+    writeJsonChunk(writer, "join", _joints);
+
+    for (size_t i = 0; i < _polyLists.size(); ++i)
+    {
+        PolyList& plist = *_polyLists[i];
+        plist.assertValidTangents();
+
+        // Attribute streams that have one item per vertex
+        const size_t vertexCount = plist.vertex().size() / 3;
+        const std::vector<float>* streams[] = {
+            &plist.vertex(), &plist.normal(), &plist.texCoord0(), &plist.texCoord1(),
+            &plist.texCoord2(), &plist.color(), plist.validTangents() ? &plist.tangent() : nullptr
+        };
+        const BufferType types[] = {
+            BufferTypeVertex, BufferTypeNormal, BufferTypeTexCoord0, BufferTypeTexCoord1,
+            BufferTypeTexCoord2, BufferTypeColor, BufferTypeTangent
+        };
+        uint32_t attributes = 0;
+        uint32_t stride = 0;
+        for (size_t s = 0; s < 7; ++s)
+        {
+            uint32_t components = bg2CookedAttributeSize(types[s]) / sizeof(float);
+            if (streams[s] && vertexCount > 0 && streams[s]->size() == vertexCount * components)
+            {
+                attributes |= types[s];
+                stride += components * sizeof(float);
+            }
+        }
+
+        writer.tag("plst");
+        writer.tag("pnam");
+        writer.string(plist.name());
+        writer.tag("mnam");
+        writer.string(_materialNames[i]);
+
+        writer.tag("vfmt");
+        writer.int32(attributes);
+        writer.int32(stride);
+
+        PolyListBounds bounds = plist.computeBounds();
+        writer.tag("bnds");
+        writer.append(&bounds.min, sizeof(float) * 3);
+        writer.append(&bounds.max, sizeof(float) * 3);
+
+        writer.tag("vblk");
+        writer.int32(static_cast<uint32_t>(attributes != 0 ? vertexCount : 0));
+        writer.align(Bg2CookedBlockAlignment);
+        if (attributes != 0)
+        {
+            size_t offset = result.size();
+            result.resize(offset + vertexCount * stride);
+            uint32_t attributeOffset = 0;
+            for (size_t s = 0; s < 7; ++s)
+            {
+                if (!(attributes & types[s]))
+                {
+                    continue;
+                }
+                uint32_t size = bg2CookedAttributeSize(types[s]);
+                const Byte* src = reinterpret_cast<const Byte*>(streams[s]->data());
+                Byte* dst = result.data() + offset + attributeOffset;
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    std::memcpy(dst + v * stride, src + v * size, size);
+                }
+                attributeOffset += size;
+            }
+        }
+
+        writer.tag("iblk");
+        writer.int32(static_cast<uint32_t>(plist.index().size()));
+        writer.align(Bg2CookedBlockAlignment);
+        writer.append(plist.index().data(), plist.index().size() * sizeof(uint32_t));
+
+        for (const auto& lod : plist.lods())
+        {
+            writer.tag("lodi");
+            writer.append(&lod.error, sizeof(float));
+            writer.int32(static_cast<uint32_t>(lod.index.size()));
+            writer.align(Bg2CookedBlockAlignment);
+            writer.append(lod.index.data(), lod.index.size() * sizeof(uint32_t));
+        }
+    }
+
+    writer.tag("endf");
+}
+
+}
+}
@@ -4,35 +4,47 @@
 namespace bg2e {
 namespace base {
 
+static_assert(tools::JsonFieldSet<Environment>::fieldMask("equirectangularTexture") == EnvironmentFieldEquirectangularTexture &&
+              tools::JsonFieldSet<Environment>::fieldMask("specularMapL2Size") == EnvironmentFieldSpecularMapL2Size,
+              "EnvironmentField bits must match the order of Environment::jsonFields()");
+
 Environment::Environment()
 {
 }
 
 void Environment::deserialize(const std::shared_ptr<tools::JsonNode>& sceneData)
 {
-    if (sceneData->isObject())
+    if (sceneData && tools::JsonFieldSet<Environment>::deserialize(*sceneData, *this))
+    {
+        _dirtyFields = EnvironmentFieldAll;
+    }
+}
+
+void Environment::deserialize(tools::JsonReader& reader)
+{
+    if (tools::JsonFieldSet<Environment>::deserialize(reader, *this))
     {
-        setEquirectangularTexture((*sceneData)["equirectangularTexture"]->stringValue(
-            std::string(equirectangularTexture())
-        ));
-        setIrradianceIntensity((*sceneData)["irradianceIntensity"]->numberValue(irradianceIntensity()));
-        setShowSkybox((*sceneData)["showSkybox"]->boolValue(showSkybox()));
-        setCubemapSize((*sceneData)["cubemapSize"]->intValue(cubemapSize()));
-        setIrradianceMapSize((*sceneData)["irradianceMapSize"]->intValue(irradianceMapSize()));
-        setSpecularMapSize((*sceneData)["specularMapSize"]->intValue(specularMapSize()));
-        setSpecularMapL2Size((*sceneData)["specularMapL2Size"]->intValue(specularMapL2Size()));
+        _dirtyFields = EnvironmentFieldAll;
     }
 }
 
 void Environment::serialize(tools::JsonObject& sceneData)
 {
-    sceneData["equirectangularTexture"] = tools::JSON(equirectangularTexture());
-    sceneData["irradianceIntensity"] = tools::JSON(irradianceIntensity());
-    sceneData["showSkybox"] = tools::JSON(showSkybox());
-    sceneData["cubemapSize"] = tools::JSON(cubemapSize());
-    sceneData["irradianceMapSize"] = tools::JSON(irradianceMapSize());
-    sceneData["specularMapSize"] = tools::JSON(specularMapSize());
-    sceneData["specularMapL2Size"] = tools::JSON(specularMapL2Size());
+    tools::JsonFieldSet<Environment>::serialize(sceneData, *this);
+}
+
+void Environment::serialize(tools::JsonWriter& writer)
+{
+    writer.startObject();
+    tools::JsonFieldSet<Environment>::serialize(writer, *this);
+    writer.endObject();
+}
+
+uint32_t Environment::applyPatch(tools::JsonNode& patch)
+{
+    auto changed = static_cast<uint32_t>(tools::JsonFieldSet<Environment>::patch(patch, *this));
+    _dirtyFields |= changed;
+    return changed;
 }
 
 }
@@ -11,14 +11,17 @@ namespace bg2e {
 namespace base {
 
 std::unordered_map<std::string, std::shared_ptr<Image>> Image::g_imageCache;
+std::mutex Image::g_imageCacheMutex;
 
 void Image::ClearCache()
 {
+    std::lock_guard<std::mutex> lock(g_imageCacheMutex);
     g_imageCache.clear();
 }
 
 void Image::ClearCacheFile(const std::string& file)
 {
+    std::lock_guard<std::mutex> lock(g_imageCacheMutex);
     auto it = g_imageCache.find(file);
     if (it != g_imageCache.end())
     {
@@ -28,13 +31,18 @@ void Image::ClearCacheFile(const std::string& file)
 
 std::shared_ptr<Image> Image::LoadFromFile(const std::string& fileName)
 {
-    if (g_imageCache.find(fileName) != g_imageCache.end())
+    // The cache is not locked while the image is decoded, so that images can be loaded
+    // from several threads
+    std::unique_lock<std::mutex> lock(g_imageCacheMutex);
+    auto cached = g_imageCache.find(fileName);
+    if (cached != g_imageCache.end())
     {
         std::cout << "Image found in cache: '" << fileName << "'. Skip load" << std::endl;
-        return g_imageCache[fileName];
+        return cached->second;
     }
     else
     {
+        lock.unlock();
         std::cout << "Image not found in cache: '" << fileName << "'. Loading from file" << std::endl;
         int w, h, c;
         stbi_uc* data = stbi_load(fileName.c_str(), &w, &h, &c, STBI_rgb_alpha);
@@ -57,8 +65,9 @@ std::shared_ptr<Image> Image::LoadFromFile(const std::string& fileName)
         }
         result->_imageSource = ImageSource::LoadFromFile;
         
-        g_imageCache[fileName] = result;
-        return result;
+        lock.lock();
+        // Keep the image loaded by another thread, if any
+        return g_imageCache.emplace(fileName, result).first->second;
     }
 }
 
@@ -4,6 +4,10 @@
 namespace bg2e {
 namespace base {
 
+static_assert(tools::JsonFieldSet<Light>::fieldMask("position") == LightFieldPosition &&
+              tools::JsonFieldSet<Light>::fieldMask("shadowBias") == LightFieldShadowBias,
+              "LightField bits must match the order of Light::jsonFields()");
+
 Light::Light()
 {
 
@@ -11,57 +15,175 @@ Light::Light()
  
 void Light::deserialize(const std::shared_ptr<tools::JsonNode>& sceneData)
 {
-    if (sceneData->isObject())
+    if (!sceneData || !sceneData->isObject())
+    {
+        return;
+    }
+    
+    ColorData colorData;
+    colorData.diffuse = color();
+    colorData.color = color();
+    tools::JsonFieldSet<Light>::deserialize(*sceneData, *this, [&](std::string_view key, tools::JsonNode& value)
+    {
+        return readColorData(key, value, colorData);
+    });
+    
+    resolveColor(colorData);
+}
+
+void Light::deserialize(tools::JsonReader& reader)
+{
+    ColorData colorData;
+    colorData.diffuse = color();
+    colorData.color = color();
+    bool isObject = tools::JsonFieldSet<Light>::deserialize(reader, *this, [&](std::string_view key)
     {
-        auto type = (*sceneData)["lightType"]->intValue(LightTypeDirectional);
-        if (type == LightTypeDirectional ||
-            type == LightTypeSpot ||
-            type == LightTypePoint ||
-            type == LightTypeDisabled)
+        if (key == "lightType")
         {
-            setType(static_cast<LightType>(type));
+            colorData.type = reader.readInt(LightTypeDirectional);
         }
-        
-        auto defaultIntensity = _type == LightTypeDirectional ? 1.0f : 300.0f;
-        
-        setPosition((*sceneData)["position"]->vec3Value(position()));
-        setDirection((*sceneData)["direction"]->vec3Value(direction()));
-        
-        if ((*sceneData)["diffuse"]->isList()) {
-            setColor((*sceneData)["diffuse"]->vec4Value(color()));
-            setIntensity((*sceneData)["intensity"]->numberValue(1.0f) * defaultIntensity);
+        else if (key == "diffuse")
+        {
+            colorData.hasDiffuse = reader.readFloats(&colorData.diffuse.x, 4);
+        }
+        else if (key == "color")
+        {
+            colorData.hasColor = reader.readFloats(&colorData.color.x, 4);
+        }
+        else if (key == "intensity")
+        {
+            colorData.intensity = reader.readFloat(0.0f);
+            colorData.hasIntensity = reader.event() == tools::JsonEvent::Number;
         }
-        else if ((*sceneData)["color"]->isList()) {
-            setColor((*sceneData)["color"]->vec4Value(color()));
-            setIntensity((*sceneData)["intensity"]->numberValue(defaultIntensity));
+        else
+        {
+            return false;
         }
-        
-        setSpotCutoff((*sceneData)["spotCutoff"]->numberValue(spotCutoff()));
-        setSpotExponent((*sceneData)["spotExponent"]->numberValue(spotExponent()));
-        setShadowStrength((*sceneData)["shadowStrength"]->numberValue(shadowStrength()));
-        
-        setProjection((*sceneData)["projection"]->mat4Value());
-        
-        setCastShadows((*sceneData)["castShadows"]->boolValue(castShadows()));
-        
-        setShadowBias((*sceneData)["shadowBias"]->numberValue(shadowBias()));
+        return true;
+    });
+    
+    if (isObject)
+    {
+        resolveColor(colorData);
+    }
+}
+
+uint32_t Light::applyPatch(tools::JsonNode& patch)
+{
+    auto previousType = _type;
+    auto previousColor = _color;
+    auto previousIntensity = _intensity;
+    
+    ColorData colorData;
+    colorData.type = _type;
+    colorData.diffuse = color();
+    colorData.color = color();
+    uint32_t changed = static_cast<uint32_t>(tools::JsonFieldSet<Light>::patch(patch, *this, [&](std::string_view key, tools::JsonNode& value)
+    {
+        return readColorData(key, value, colorData);
+    }));
+    
+    if (colorData.hasDiffuse && !colorData.hasColor)
+    {
+        // Legacy diffuse color: the intensity is relative to the light type
+        resolveColor(colorData);
+    }
+    else
+    {
+        resolveType(colorData.type);
+        if (colorData.hasColor)
+        {
+            setColor(colorData.color);
+        }
+        if (colorData.hasIntensity)
+        {
+            setIntensity(colorData.intensity);
+        }
+    }
+    
+    if (_type != previousType)
+    {
+        changed |= LightFieldType;
+    }
+    if (_color != previousColor)
+    {
+        changed |= LightFieldColor;
+    }
+    if (_intensity != previousIntensity)
+    {
+        changed |= LightFieldIntensity;
+    }
+    return changed;
+}
+
+bool Light::readColorData(std::string_view key, tools::JsonNode& value, ColorData& colorData)
+{
+    if (key == "lightType")
+    {
+        colorData.type = value.intValue(LightTypeDirectional);
+    }
+    else if (key == "diffuse" && value.isList())
+    {
+        colorData.diffuse = value.vec4Value(colorData.diffuse);
+        colorData.hasDiffuse = true;
+    }
+    else if (key == "color" && value.isList())
+    {
+        colorData.color = value.vec4Value(colorData.color);
+        colorData.hasColor = true;
+    }
+    else if (key == "intensity" && value.isNumber())
+    {
+        colorData.intensity = value.numberValue();
+        colorData.hasIntensity = true;
+    }
+    return true;
+}
+
+void Light::resolveType(int32_t type)
+{
+    if (type == LightTypeDirectional ||
+        type == LightTypeSpot ||
+        type == LightTypePoint ||
+        type == LightTypeDisabled)
+    {
+        setType(static_cast<LightType>(type));
+    }
+}
+
+void Light::resolveColor(const ColorData& colorData)
+{
+    resolveType(colorData.type);
+    
+    auto defaultIntensity = _type == LightTypeDirectional ? 1.0f : 300.0f;
+    if (colorData.hasDiffuse)
+    {
+        setColor(colorData.diffuse);
+        setIntensity((colorData.hasIntensity ? colorData.intensity : 1.0f) * defaultIntensity);
+    }
+    else if (colorData.hasColor)
+    {
+        setColor(colorData.color);
+        setIntensity(colorData.hasIntensity ? colorData.intensity : defaultIntensity);
     }
 }
 
 void Light::serialize(tools::JsonObject& sceneData)
 {
     sceneData["lightType"] = tools::JSON(static_cast<uint32_t>(type()));
-    sceneData["position"] = tools::JSON(position());
-    sceneData["direction"] = tools::JSON(direction());
     sceneData["color"] = tools::JSON(color());
     sceneData["intensity"] = tools::JSON(intensity());
-    sceneData["spotCutoff"] = tools::JSON(spotCutoff());
-    sceneData["spotExponent"] = tools::JSON(spotExponent());
-    sceneData["shadowStrength"] = tools::JSON(shadowStrength());
-    sceneData["projection"] = tools::JSON(projection());
-    sceneData["castShadows"] = tools::JSON(castShadows());
-    sceneData["shadowBias"] = tools::JSON(shadowBias());
-    
+    tools::JsonFieldSet<Light>::serialize(sceneData, *this);
+}
+
+void Light::serialize(tools::JsonWriter& writer)
+{
+    writer.startObject()
+        .field("lightType", static_cast<uint32_t>(type()))
+        .field("color", color())
+        .field("intensity", intensity());
+    tools::JsonFieldSet<Light>::serialize(writer, *this);
+    writer.endObject();
 }
 
 }
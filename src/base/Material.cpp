@@ -4,7 +4,34 @@
 namespace bg2e {
 namespace base {
 
+Material::Material()
+{
+}
+
+void Material::deserialize(const std::shared_ptr<tools::JsonNode>& materialData)
+{
+    if (materialData)
+    {
+        tools::JsonFieldSet<Material>::deserialize(*materialData, *this);
+    }
+}
+
+void Material::deserialize(tools::JsonReader& reader)
+{
+    tools::JsonFieldSet<Material>::deserialize(reader, *this);
+}
+
+void Material::serialize(tools::JsonObject& materialData)
+{
+    tools::JsonFieldSet<Material>::serialize(materialData, *this);
+}
 
+void Material::serialize(tools::JsonWriter& writer)
+{
+    writer.startObject();
+    tools::JsonFieldSet<Material>::serialize(writer, *this);
+    writer.endObject();
+}
 
 }
 }
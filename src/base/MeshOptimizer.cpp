@@ -0,0 +1,438 @@
+
+#include <bg2e/base/MeshOptimizer.hpp>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace bg2e {
+namespace base {
+
+static const uint32_t InvalidVertex = 0xFFFFFFFF;
+
+// Returns false if the poly list can not be reordered
+static bool optimizable(const PolyList& plist)
+{
+    const size_t vertexCount = plist.vertex().size() / 3;
+    const auto& index = plist.index();
+    if (plist.drawMode() != DrawModeTriangles || index.empty() || index.size() % 3 != 0)
+    {
+        return false;
+    }
+    for (auto i : index)
+    {
+        if (i >= vertexCount)
+        {
+            throw std::runtime_error("MeshOptimizer: vertex index out of range in poly list '" + plist.name() + "'");
+        }
+    }
+    return true;
+}
+
+// FIFO cache with time stamps: a vertex is in the cache if less than `size` vertices have
+// been added after it. reset() empties the cache without clearing the stamps
+class VertexCacheSimulator
+{
+public:
+    VertexCacheSimulator(size_t vertexCount, uint32_t size)
+        :_stamps(vertexCount, 0), _size(size), _time(size + 1)
+    {
+    }
+
+    inline uint32_t triangleMisses(const uint32_t* triangle)
+    {
+        uint32_t misses = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t& stamp = _stamps[triangle[c]];
+            if (_time - stamp > _size)
+            {
+                stamp = _time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+    inline void reset() { _time += _size + 1; }
+
+protected:
+    std::vector<uint32_t> _stamps;
+    uint32_t _size;
+    uint32_t _time;
+};
+
+MeshOptimizer::MeshOptimizer()
+{
+
+}
+
+MeshOptimizerResult MeshOptimizer::optimize(PolyList& plist) const
+{
+    MeshOptimizerResult result;
+    result.before = analyzeVertexCache(plist, _cacheSize);
+    if (!optimizable(plist))
+    {
+        result.after = result.before;
+        return result;
+    }
+
+    if (_optimizeOverdraw)
+    {
+        optimizeOverdraw(plist);
+    }
+    else
+    {
+        optimizeVertexCache(plist);
+    }
+    optimizeVertexFetch(plist);
+    result.after = analyzeVertexCache(plist, _cacheSize);
+    return result;
+}
+
+void MeshOptimizer::optimizeVertexCache(PolyList& plist) const
+{
+    if (!optimizable(plist))
+    {
+        return;
+    }
+
+    plist.setIndex(vertexCacheOrder(plist.index(), plist.vertex().size() / 3));
+    optimizeLods(plist);
+}
+
+void MeshOptimizer::optimizeOverdraw(PolyList& plist) const
+{
+    if (!optimizable(plist))
+    {
+        return;
+    }
+
+    const auto& index = plist.index();
+    const auto& vertex = plist.vertex();
+    const size_t vertexCount = vertex.size() / 3;
+    const size_t triangleCount = index.size() / 3;
+    const uint32_t cacheSize = std::max(_cacheSize, 3u);
+
+    std::vector<uint32_t> hardClusters;
+    std::vector<uint32_t> order = tipsify(index, vertexCount, &hardClusters);
+    std::vector<uint32_t> sorted(index.size());
+    for (size_t t = 0; t < order.size(); ++t)
+    {
+        std::copy_n(&index[order[t] * 3], 3, &sorted[t * 3]);
+    }
+
+    // The Tipsify clusters are split again where their ACMR, with an empty cache at the start
+    // of the cluster, is below the threshold. Smaller clusters sort better, and the cache
+    // misses at the new boundaries keep the ACMR under the threshold
+    VertexCacheSimulator cache(vertexCount, cacheSize);
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h < hardClusters.size(); ++h)
+    {
+        const size_t begin = hardClusters[h];
+        const size_t end = h + 1 < hardClusters.size() ? hardClusters[h + 1] : triangleCount;
+
+        cache.reset();
+        uint32_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t)
+        {
+            clusterMisses += cache.triangleMisses(&sorted[t * 3]);
+        }
+        const float threshold = _overdrawThreshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        clusters.push_back(static_cast<uint32_t>(begin));
+        cache.reset();
+        uint32_t misses = 0;
+        uint32_t triangles = 0;
+        for (size_t t = begin; t < end; ++t)
+        {
+            misses += cache.triangleMisses(&sorted[t * 3]);
+            ++triangles;
+            if (t + 1 < end && static_cast<float>(misses) / static_cast<float>(triangles) <= threshold)
+            {
+                clusters.push_back(static_cast<uint32_t>(t + 1));
+                cache.reset();
+                misses = 0;
+                triangles = 0;
+            }
+        }
+    }
+
+    // The clusters that face away from the center of the mesh are drawn first, because they
+    // are usually in front of the rest
+    auto position = [&](uint32_t v) {
+        return glm::vec3{ vertex[v * 3], vertex[v * 3 + 1], vertex[v * 3 + 2] };
+    };
+    glm::vec3 meshCenter{ 0.0f };
+    for (auto v : sorted)
+    {
+        meshCenter += position(v);
+    }
+    meshCenter /= static_cast<float>(sorted.size());
+
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const size_t begin = clusters[c];
+        const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        glm::vec3 center{ 0.0f };
+        glm::vec3 normal{ 0.0f };
+        for (size_t t = begin; t < end; ++t)
+        {
+            glm::vec3 p0 = position(sorted[t * 3]);
+            glm::vec3 p1 = position(sorted[t * 3 + 1]);
+            glm::vec3 p2 = position(sorted[t * 3 + 2]);
+            center += p0 + p1 + p2;
+            normal += glm::cross(p1 - p0, p2 - p0);
+        }
+        center /= static_cast<float>((end - begin) * 3);
+        float length = glm::length(normal);
+        sortKeys[c] = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+    }
+
+    std::vector<uint32_t> clusterOrder(clusters.size());
+    for (uint32_t c = 0; c < clusterOrder.size(); ++c)
+    {
+        clusterOrder[c] = c;
+    }
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(sorted.size());
+    for (auto c : clusterOrder)
+    {
+        const size_t begin = clusters[c];
+        const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        result.insert(result.end(), sorted.begin() + begin * 3, sorted.begin() + end * 3);
+    }
+    plist.setIndex(std::move(result));
+    optimizeLods(plist);
+}
+
+void MeshOptimizer::optimizeVertexFetch(PolyList& plist) const
+{
+    if (!optimizable(plist))
+    {
+        return;
+    }
+
+    std::vector<uint32_t> remap(plist.vertex().size() / 3, PolyList::RemovedVertex);
+    uint32_t vertexCount = 0;
+    auto addVertices = [&](const std::vector<uint32_t>& indices) {
+        for (auto i : indices)
+        {
+            if (i < remap.size() && remap[i] == PolyList::RemovedVertex)
+            {
+                remap[i] = vertexCount++;
+            }
+        }
+    };
+    addVertices(plist.index());
+    for (const auto& lod : plist.lods())
+    {
+        addVertices(lod.index);
+    }
+    plist.remapVertices(remap, vertexCount);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const PolyList& plist, uint32_t cacheSize)
+{
+    VertexCacheStats result;
+    const auto& index = plist.index();
+    const size_t vertexCount = plist.vertex().size() / 3;
+    const size_t triangleCount = index.size() / 3;
+    if (triangleCount == 0)
+    {
+        return result;
+    }
+
+    VertexCacheSimulator cache(vertexCount, std::max(cacheSize, 3u));
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t* triangle = &index[t * 3];
+        for (int c = 0; c < 3; ++c)
+        {
+            if (triangle[c] >= vertexCount)
+            {
+                throw std::runtime_error("MeshOptimizer: vertex index out of range in poly list '" + plist.name() + "'");
+            }
+            if (!used[triangle[c]])
+            {
+                used[triangle[c]] = true;
+                ++usedCount;
+            }
+        }
+        result.transformedVertices += cache.triangleMisses(triangle);
+    }
+    result.acmr = static_cast<float>(result.transformedVertices) / static_cast<float>(triangleCount);
+    result.atvr = static_cast<float>(result.transformedVertices) / static_cast<float>(usedCount);
+    return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::vertexCacheOrder(const std::vector<uint32_t>& index, size_t vertexCount) const
+{
+    std::vector<uint32_t> order = tipsify(index, vertexCount, nullptr);
+    std::vector<uint32_t> result(index.size());
+    for (size_t t = 0; t < order.size(); ++t)
+    {
+        std::copy_n(&index[order[t] * 3], 3, &result[t * 3]);
+    }
+    return result;
+}
+
+void MeshOptimizer::optimizeLods(PolyList& plist) const
+{
+    if (plist.lods().empty())
+    {
+        return;
+    }
+
+    // The levels of detail are drawn from far away, so they are only sorted for the cache
+    const size_t vertexCount = plist.vertex().size() / 3;
+    std::vector<PolyListLod> lods = plist.lods();
+    for (auto& lod : lods)
+    {
+        for (auto i : lod.index)
+        {
+            if (i >= vertexCount)
+            {
+                throw std::runtime_error("MeshOptimizer: vertex index out of range in a level of detail of poly list '" + plist.name() + "'");
+            }
+        }
+        if (lod.index.size() % 3 == 0)
+        {
+            lod.index = vertexCacheOrder(lod.index, vertexCount);
+        }
+    }
+    plist.setLods(std::move(lods));
+}
+
+std::vector<uint32_t> MeshOptimizer::tipsify(const std::vector<uint32_t>& index, size_t vertexCount, std::vector<uint32_t>* clusters) const
+{
+    const size_t triangleCount = index.size() / 3;
+    const uint32_t cacheSize = std::max(_cacheSize, 3u);
+
+    // Triangles of each vertex. The live triangle count is the number of triangles that are
+    // not emitted yet
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (auto i : index)
+    {
+        ++liveTriangles[i];
+    }
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        firstTriangle[v + 1] = firstTriangle[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> vertexTriangles(index.size());
+    {
+        std::vector<uint32_t> next(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < index.size(); ++i)
+        {
+            vertexTriangles[next[index[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    deadEnd.reserve(index.size());
+    result.reserve(triangleCount);
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    // Next fanning vertex when the candidates have no live triangles: the last vertices that
+    // were used, or the next vertex in the input order
+    auto nextDeadEnd = [&]() {
+        while (!deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0)
+            {
+                return v;
+            }
+        }
+        while (cursor < vertexCount)
+        {
+            if (liveTriangles[cursor] > 0)
+            {
+                return static_cast<uint32_t>(cursor);
+            }
+            ++cursor;
+        }
+        return InvalidVertex;
+    };
+
+    uint32_t fanning = nextDeadEnd();
+    bool newCluster = true;
+    while (fanning != InvalidVertex)
+    {
+        candidates.clear();
+        for (uint32_t i = firstTriangle[fanning]; i < firstTriangle[fanning + 1]; ++i)
+        {
+            uint32_t t = vertexTriangles[i];
+            if (emitted[t])
+            {
+                continue;
+            }
+            if (newCluster && clusters)
+            {
+                clusters->push_back(static_cast<uint32_t>(result.size()));
+            }
+            newCluster = false;
+            emitted[t] = 1;
+            result.push_back(t);
+            for (int c = 0; c < 3; ++c)
+            {
+                uint32_t v = index[t * 3 + c];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+
+        // The candidate that will be the oldest in the cache and still be in it after fanning
+        // its triangles, or any candidate with live triangles
+        uint32_t next = InvalidVertex;
+        int64_t bestPriority = -1;
+        for (auto v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+            {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+            {
+                priority = time - cacheTime[v];
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        if (next == InvalidVertex)
+        {
+            next = nextDeadEnd();
+            newCluster = true;
+        }
+        fanning = next;
+    }
+    return result;
+}
+
+}
+}
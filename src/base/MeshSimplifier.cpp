@@ -0,0 +1,668 @@
+
+#include <bg2e/base/MeshSimplifier.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace bg2e {
+namespace base {
+
+static const uint32_t InvalidVertex = 0xFFFFFFFF;
+
+// Symmetric 4x4 quadric of the squared distances to a set of planes, weighted by area
+struct SimplifierQuadric
+{
+    float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f;
+    float a10 = 0.0f, a20 = 0.0f, a21 = 0.0f;
+    float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+    float c = 0.0f;
+    float w = 0.0f;
+
+    static SimplifierQuadric plane(const glm::vec3& n, float d, float weight)
+    {
+        SimplifierQuadric q;
+        q.a00 = n.x * n.x * weight;
+        q.a11 = n.y * n.y * weight;
+        q.a22 = n.z * n.z * weight;
+        q.a10 = n.y * n.x * weight;
+        q.a20 = n.z * n.x * weight;
+        q.a21 = n.z * n.y * weight;
+        q.b0 = n.x * d * weight;
+        q.b1 = n.y * d * weight;
+        q.b2 = n.z * d * weight;
+        q.c = d * d * weight;
+        q.w = weight;
+        return q;
+    }
+
+    inline void add(const SimplifierQuadric& q)
+    {
+        a00 += q.a00; a11 += q.a11; a22 += q.a22;
+        a10 += q.a10; a20 += q.a20; a21 += q.a21;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        w += q.w;
+    }
+
+    // Weighted mean of the squared distances from p to the planes
+    inline float error(const glm::vec3& p) const
+    {
+        float rx = a00 * p.x + a10 * p.y + a20 * p.z + b0 * 2.0f;
+        float ry = a10 * p.x + a11 * p.y + a21 * p.z + b1 * 2.0f;
+        float rz = a20 * p.x + a21 * p.y + a22 * p.z + b2 * 2.0f;
+        float r = rx * p.x + ry * p.y + rz * p.z + c;
+        return w > 0.0f ? std::abs(r) / w : 0.0f;
+    }
+};
+
+typedef enum {
+    SimplifierVertexManifold = 0,
+    SimplifierVertexBorder,
+    SimplifierVertexSeam,
+    SimplifierVertexLocked
+} SimplifierVertexKind;
+
+// Outgoing half edges of each vertex, in compressed rows
+class SimplifierEdges
+{
+public:
+    SimplifierEdges(const std::vector<uint32_t>& index, const std::vector<uint32_t>& vertexMap, size_t vertexCount)
+        :_first(vertexCount + 1, 0), _targets(index.size())
+    {
+        for (size_t i = 0; i < index.size(); ++i)
+        {
+            ++_first[vertexMap[index[i]] + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            _first[v + 1] += _first[v];
+        }
+        std::vector<uint32_t> next(_first.begin(), _first.end() - 1);
+        for (size_t t = 0; t < index.size(); t += 3)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                uint32_t from = vertexMap[index[t + c]];
+                uint32_t to = vertexMap[index[t + (c + 1) % 3]];
+                _targets[next[from]++] = to;
+            }
+        }
+    }
+
+    inline bool hasEdge(uint32_t from, uint32_t to) const
+    {
+        for (uint32_t i = _first[from]; i < _first[from + 1]; ++i)
+        {
+            if (_targets[i] == to)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint32_t begin(uint32_t v) const { return _first[v]; }
+    inline uint32_t end(uint32_t v) const { return _first[v + 1]; }
+    inline uint32_t target(uint32_t i) const { return _targets[i]; }
+
+protected:
+    std::vector<uint32_t> _first;
+    std::vector<uint32_t> _targets;
+};
+
+struct SimplifierCollapse
+{
+    uint32_t from;
+    uint32_t to;
+    float error;
+};
+
+// Stable radix sort by error. The errors are not negative, so the order of their bits is the
+// order of the values
+static void sortCollapses(std::vector<SimplifierCollapse>& collapses, std::vector<SimplifierCollapse>& scratch)
+{
+    scratch.resize(collapses.size());
+    for (uint32_t shift = 0; shift < 32; shift += 11)
+    {
+        uint32_t histogram[2048] = {};
+        for (const auto& collapse : collapses)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &collapse.error, sizeof(float));
+            ++histogram[(bits >> shift) & 2047];
+        }
+        uint32_t sum = 0;
+        for (auto& count : histogram)
+        {
+            uint32_t offset = sum;
+            sum += count;
+            count = offset;
+        }
+        for (const auto& collapse : collapses)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &collapse.error, sizeof(float));
+            scratch[histogram[(bits >> shift) & 2047]++] = collapse;
+        }
+        collapses.swap(scratch);
+    }
+}
+
+// State of one simplification: positions normalized to the unit cube, position classes,
+// vertex kinds and quadrics
+class SimplifierMesh
+{
+public:
+    SimplifierMesh(const PolyList& plist, const std::vector<uint32_t>& index, bool lockBorder)
+        :_vertexCount(plist.vertex().size() / 3)
+    {
+        const auto& vertex = plist.vertex();
+        for (auto i : index)
+        {
+            if (i >= _vertexCount)
+            {
+                throw std::runtime_error("MeshSimplifier: vertex index out of range in poly list '" + plist.name() + "'");
+            }
+        }
+
+        PolyListBounds bounds = plist.computeBounds();
+        glm::vec3 size = bounds.max - bounds.min;
+        _scale = std::max(std::max(size.x, size.y), size.z);
+        float invScale = _scale > 0.0f ? 1.0f / _scale : 0.0f;
+        _position.resize(_vertexCount);
+        for (size_t v = 0; v < _vertexCount; ++v)
+        {
+            _position[v] = (glm::vec3{ vertex[v * 3], vertex[v * 3 + 1], vertex[v * 3 + 2] } - bounds.min) * invScale;
+        }
+
+        buildPositionClasses(vertex);
+        classifyVertices(index, lockBorder);
+        buildQuadrics(index);
+    }
+
+    inline const glm::vec3& position(uint32_t v) const { return _position[v]; }
+    inline uint32_t positionClass(uint32_t v) const { return _positionClass[v]; }
+    inline SimplifierVertexKind kind(uint32_t v) const { return _kind[v]; }
+    inline uint32_t wedge(uint32_t v) const { return _wedge[v]; }
+    inline uint32_t loop(uint32_t v) const { return _loop[v]; }
+    inline uint32_t loopBack(uint32_t v) const { return _loopBack[v]; }
+    inline SimplifierQuadric& quadric(uint32_t v) { return _quadric[_positionClass[v]]; }
+
+    // Error of moving `from` to the position of `to`, or infinity if the collapse is not
+    // allowed by the vertex kinds
+    float collapseError(uint32_t from, uint32_t to)
+    {
+        SimplifierVertexKind kindFrom = _kind[from];
+        SimplifierVertexKind kindTo = _kind[to];
+        if (kindFrom == SimplifierVertexLocked)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+        if (kindFrom != SimplifierVertexManifold)
+        {
+            // Borders and seams only move along themselves
+            if (kindTo != kindFrom && kindTo != SimplifierVertexLocked)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+            if (to != _loop[from] && to != _loopBack[from])
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+        }
+        SimplifierQuadric q = quadric(from);
+        q.add(quadric(to));
+        return q.error(_position[to]);
+    }
+
+protected:
+    size_t _vertexCount;
+    float _scale;
+    std::vector<glm::vec3> _position;
+    std::vector<uint32_t> _positionClass;
+    std::vector<uint32_t> _wedge;
+    std::vector<SimplifierVertexKind> _kind;
+    std::vector<uint32_t> _loop;
+    std::vector<uint32_t> _loopBack;
+    std::vector<SimplifierQuadric> _quadric;
+
+    // The position class is the first vertex with the same position. The wedges of a position
+    // are linked in a circular list
+    void buildPositionClasses(const std::vector<float>& vertex)
+    {
+        size_t tableSize = 16;
+        while (tableSize < _vertexCount * 2)
+        {
+            tableSize <<= 1;
+        }
+        std::vector<uint32_t> table(tableSize, InvalidVertex);
+        auto hash = [&](uint32_t v) {
+            uint32_t bits[3];
+            std::memcpy(bits, &vertex[v * 3], sizeof(bits));
+            uint64_t h = bits[0];
+            h = h * 0x9E3779B97F4A7C15ull ^ bits[1];
+            h = h * 0x9E3779B97F4A7C15ull ^ bits[2];
+            h *= 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(h ^ (h >> 32));
+        };
+
+        _positionClass.resize(_vertexCount);
+        _wedge.resize(_vertexCount);
+        for (uint32_t v = 0; v < _vertexCount; ++v)
+        {
+            size_t slot = hash(v) & (tableSize - 1);
+            while (table[slot] != InvalidVertex && std::memcmp(&vertex[table[slot] * 3], &vertex[v * 3], sizeof(float) * 3) != 0)
+            {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            if (table[slot] == InvalidVertex)
+            {
+                table[slot] = v;
+                _positionClass[v] = v;
+                _wedge[v] = v;
+            }
+            else
+            {
+                uint32_t first = table[slot];
+                _positionClass[v] = first;
+                _wedge[v] = _wedge[first];
+                _wedge[first] = v;
+            }
+        }
+    }
+
+    void classifyVertices(const std::vector<uint32_t>& index, bool lockBorder)
+    {
+        std::vector<uint32_t> identity(_vertexCount);
+        for (uint32_t v = 0; v < _vertexCount; ++v)
+        {
+            identity[v] = v;
+        }
+        SimplifierEdges edges(index, identity, _vertexCount);
+
+        // Open half edges: the vertex at the other side of the only open edge, InvalidVertex
+        // if there are none, or the vertex itself if there are more than one
+        std::vector<uint32_t> openIn(_vertexCount, InvalidVertex);
+        std::vector<uint32_t> openOut(_vertexCount, InvalidVertex);
+        _kind.assign(_vertexCount, SimplifierVertexManifold);
+        for (uint32_t v = 0; v < _vertexCount; ++v)
+        {
+            for (uint32_t i = edges.begin(v); i < edges.end(v); ++i)
+            {
+                uint32_t target = edges.target(i);
+                if (target == v)
+                {
+                    _kind[v] = SimplifierVertexLocked;
+                }
+                else if (!edges.hasEdge(target, v))
+                {
+                    openIn[target] = openIn[target] == InvalidVertex ? v : target;
+                    openOut[v] = openOut[v] == InvalidVertex ? target : v;
+                }
+            }
+        }
+
+        for (uint32_t v = 0; v < _vertexCount; ++v)
+        {
+            if (_kind[v] == SimplifierVertexLocked)
+            {
+                continue;
+            }
+            if (_wedge[v] == v)
+            {
+                if (openIn[v] == InvalidVertex && openOut[v] == InvalidVertex)
+                {
+                    _kind[v] = SimplifierVertexManifold;
+                }
+                else if (openIn[v] != v && openOut[v] != v && !lockBorder)
+                {
+                    _kind[v] = SimplifierVertexBorder;
+                }
+                else
+                {
+                    _kind[v] = SimplifierVertexLocked;
+                }
+            }
+            else if (_wedge[_wedge[v]] == v)
+            {
+                // Two wedges: the open edges of both sides must connect the same positions
+                uint32_t w = _wedge[v];
+                uint32_t inV = openIn[v], outV = openOut[v];
+                uint32_t inW = openIn[w], outW = openOut[w];
+                bool seam = inV != InvalidVertex && inV != v && outV != InvalidVertex && outV != v &&
+                    inW != InvalidVertex && inW != w && outW != InvalidVertex && outW != w &&
+                    _positionClass[inV] == _positionClass[outW] && _positionClass[outV] == _positionClass[inW] &&
+                    _positionClass[inV] != _positionClass[outV];
+                _kind[v] = seam ? SimplifierVertexSeam : SimplifierVertexLocked;
+            }
+            else
+            {
+                _kind[v] = SimplifierVertexLocked;
+            }
+        }
+
+        _loop.swap(openOut);
+        _loopBack.swap(openIn);
+    }
+
+    void buildQuadrics(const std::vector<uint32_t>& index)
+    {
+        // Border edges add a plane perpendicular to the triangle with a larger weight, that
+        // keeps the border vertices on the border line
+        const float borderWeight = 10.0f;
+
+        SimplifierEdges positionEdges(index, _positionClass, _vertexCount);
+        _quadric.assign(_vertexCount, SimplifierQuadric());
+        for (size_t t = 0; t < index.size(); t += 3)
+        {
+            const glm::vec3& p0 = _position[index[t]];
+            const glm::vec3& p1 = _position[index[t + 1]];
+            const glm::vec3& p2 = _position[index[t + 2]];
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            if (area > 0.0f)
+            {
+                normal /= area;
+            }
+            SimplifierQuadric q = SimplifierQuadric::plane(normal, -glm::dot(normal, p0), area);
+            for (size_t c = 0; c < 3; ++c)
+            {
+                _quadric[_positionClass[index[t + c]]].add(q);
+            }
+
+            for (size_t c = 0; c < 3; ++c)
+            {
+                uint32_t a = _positionClass[index[t + c]];
+                uint32_t b = _positionClass[index[t + (c + 1) % 3]];
+                if (positionEdges.hasEdge(b, a))
+                {
+                    continue;
+                }
+                glm::vec3 edge = _position[b] - _position[a];
+                float length = glm::length(edge);
+                glm::vec3 edgeNormal = glm::cross(edge, normal);
+                float edgeNormalLength = glm::length(edgeNormal);
+                if (edgeNormalLength > 0.0f)
+                {
+                    edgeNormal /= edgeNormalLength;
+                }
+                SimplifierQuadric edgeQuadric = SimplifierQuadric::plane(edgeNormal, -glm::dot(edgeNormal, _position[a]), length * borderWeight);
+                _quadric[a].add(edgeQuadric);
+                _quadric[b].add(edgeQuadric);
+            }
+        }
+    }
+};
+
+// Returns true if moving `from` to `to` turns a triangle of `from` more than 75 degrees, or
+// more than 90 degrees from the original normal of the triangle, so a sequence of collapses
+// can not fold the surface
+static bool collapseFlipsTriangle(
+    SimplifierMesh& mesh,
+    const std::vector<uint32_t>& index,
+    const std::vector<glm::vec3>& originalNormals,
+    const std::vector<uint32_t>& triangleFirst,
+    const std::vector<uint32_t>& triangles,
+    const std::vector<uint32_t>& collapseTarget,
+    uint32_t from,
+    uint32_t to)
+{
+    const uint32_t fromClass = mesh.positionClass(from);
+    const uint32_t toClass = mesh.positionClass(to);
+    const glm::vec3& target = mesh.position(to);
+    for (uint32_t i = triangleFirst[fromClass]; i < triangleFirst[fromClass + 1]; ++i)
+    {
+        // The previous collapses of the pass are applied to the triangle
+        const uint32_t* tri = &index[triangles[i] * 3];
+        uint32_t v0 = collapseTarget[tri[0]];
+        uint32_t v1 = collapseTarget[tri[1]];
+        uint32_t v2 = collapseTarget[tri[2]];
+        uint32_t c0 = mesh.positionClass(v0);
+        uint32_t c1 = mesh.positionClass(v1);
+        uint32_t c2 = mesh.positionClass(v2);
+        if (c0 == toClass || c1 == toClass || c2 == toClass || c0 == c1 || c1 == c2 || c0 == c2)
+        {
+            continue;
+        }
+        glm::vec3 p0 = mesh.position(v0);
+        glm::vec3 p1 = mesh.position(v1);
+        glm::vec3 p2 = mesh.position(v2);
+        glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+        (c0 == fromClass ? p0 : c1 == fromClass ? p1 : p2) = target;
+        glm::vec3 after = glm::cross(p1 - p0, p2 - p0);
+        if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after) ||
+            glm::dot(originalNormals[triangles[i]], after) <= 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+MeshSimplifier::MeshSimplifier()
+{
+
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(
+    const PolyList& plist,
+    const std::vector<uint32_t>& index,
+    size_t targetTriangleCount,
+    float targetError,
+    float* resultError) const
+{
+    if (index.size() % 3 != 0)
+    {
+        throw std::runtime_error("MeshSimplifier: the index count of poly list '" + plist.name() + "' is not a multiple of three");
+    }
+
+    SimplifierMesh mesh(plist, index, _lockBorder);
+    const size_t vertexCount = plist.vertex().size() / 3;
+    const float errorLimit = targetError * targetError;
+
+    std::vector<uint32_t> result = index;
+    std::vector<glm::vec3> originalNormals(index.size() / 3);
+    for (size_t t = 0; t < originalNormals.size(); ++t)
+    {
+        const glm::vec3& p0 = mesh.position(index[t * 3]);
+        originalNormals[t] = glm::cross(mesh.position(index[t * 3 + 1]) - p0, mesh.position(index[t * 3 + 2]) - p0);
+    }
+    std::vector<uint32_t> collapseTarget(vertexCount);
+    std::vector<uint8_t> collapseLocked(vertexCount);
+    std::vector<uint32_t> triangleFirst(vertexCount + 1);
+    std::vector<uint32_t> triangles;
+    std::vector<SimplifierCollapse> collapses;
+    std::vector<SimplifierCollapse> sortScratch;
+    float maxError = 0.0f;
+
+    while (result.size() / 3 > targetTriangleCount)
+    {
+        // Triangles of each position class
+        std::fill(triangleFirst.begin(), triangleFirst.end(), 0);
+        for (auto i : result)
+        {
+            ++triangleFirst[mesh.positionClass(i) + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            triangleFirst[v + 1] += triangleFirst[v];
+        }
+        triangles.resize(result.size());
+        {
+            std::vector<uint32_t> next(triangleFirst.begin(), triangleFirst.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i)
+            {
+                triangles[next[mesh.positionClass(result[i])]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // The best direction of each edge. The inner edges of manifold vertices are shared by
+        // two triangles, so they are added from one side. The rest may be added twice, and the
+        // second collapse is discarded because its vertices are locked
+        collapses.clear();
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                uint32_t a = result[t + c];
+                uint32_t b = result[t + (c + 1) % 3];
+                uint32_t classA = mesh.positionClass(a);
+                uint32_t classB = mesh.positionClass(b);
+                if (classA == classB ||
+                    (classA > classB && mesh.kind(a) == SimplifierVertexManifold && mesh.kind(b) == SimplifierVertexManifold))
+                {
+                    continue;
+                }
+                float errorAB = mesh.collapseError(a, b);
+                float errorBA = mesh.collapseError(b, a);
+                if (errorAB <= errorBA && errorAB <= errorLimit)
+                {
+                    collapses.push_back({ a, b, errorAB });
+                }
+                else if (errorBA < errorAB && errorBA <= errorLimit)
+                {
+                    collapses.push_back({ b, a, errorBA });
+                }
+            }
+        }
+        if (collapses.empty())
+        {
+            break;
+        }
+        sortCollapses(collapses, sortScratch);
+
+        // Each collapse removes up to two triangles. The error of a pass is limited, so the
+        // collapses of the pass are not much worse than the ones needed to reach the target.
+        // Many collapses are discarded because they share vertices with a previous one, so
+        // the limit is only applied after a part of the goal is done
+        const size_t triangleGoal = result.size() / 3 - targetTriangleCount;
+        const size_t collapseGoal = std::min(collapses.size(), std::max<size_t>(triangleGoal / 2, 1));
+        const float passLimit = collapses[collapseGoal - 1].error * 1.5f;
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            collapseTarget[v] = v;
+        }
+        std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+        size_t removedTriangles = 0;
+        size_t collapseCount = 0;
+        for (const auto& collapse : collapses)
+        {
+            if ((collapse.error > passLimit && removedTriangles > triangleGoal / 6) || removedTriangles >= triangleGoal)
+            {
+                break;
+            }
+            uint32_t fromClass = mesh.positionClass(collapse.from);
+            uint32_t toClass = mesh.positionClass(collapse.to);
+            if (collapseLocked[fromClass] || collapseLocked[toClass])
+            {
+                continue;
+            }
+            if (collapseFlipsTriangle(mesh, result, originalNormals, triangleFirst, triangles, collapseTarget, collapse.from, collapse.to))
+            {
+                continue;
+            }
+
+            if (mesh.kind(collapse.from) == SimplifierVertexSeam)
+            {
+                // The other side of the seam moves to the matching wedge of the target
+                uint32_t otherFrom = mesh.wedge(collapse.from);
+                uint32_t otherTo = mesh.loop(collapse.from) == collapse.to ? mesh.loopBack(otherFrom) : mesh.loop(otherFrom);
+                if (otherTo == InvalidVertex || mesh.positionClass(otherTo) != toClass)
+                {
+                    continue;
+                }
+                collapseTarget[otherFrom] = otherTo;
+            }
+            collapseTarget[collapse.from] = collapse.to;
+
+            mesh.quadric(collapse.to).add(mesh.quadric(collapse.from));
+            collapseLocked[fromClass] = 1;
+            collapseLocked[toClass] = 1;
+            maxError = std::max(maxError, collapse.error);
+            removedTriangles += mesh.kind(collapse.from) == SimplifierVertexBorder ? 1 : 2;
+            ++collapseCount;
+        }
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        // Apply the collapses, and remove the degenerated triangles
+        size_t writePos = 0;
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            uint32_t i0 = collapseTarget[result[t]];
+            uint32_t i1 = collapseTarget[result[t + 1]];
+            uint32_t i2 = collapseTarget[result[t + 2]];
+            uint32_t c0 = mesh.positionClass(i0);
+            uint32_t c1 = mesh.positionClass(i1);
+            uint32_t c2 = mesh.positionClass(i2);
+            if (c0 != c1 && c1 != c2 && c0 != c2)
+            {
+                originalNormals[writePos / 3] = originalNormals[t / 3];
+                result[writePos++] = i0;
+                result[writePos++] = i1;
+                result[writePos++] = i2;
+            }
+        }
+        result.resize(writePos);
+        originalNormals.resize(writePos / 3);
+    }
+
+    if (resultError)
+    {
+        *resultError = std::sqrt(maxError);
+    }
+    return result;
+}
+
+void MeshSimplifier::buildLods(PolyList& plist, size_t maxLevels, float ratio, float maxError) const
+{
+    std::vector<PolyListLod> lods;
+    lods.reserve(maxLevels);
+    const std::vector<uint32_t>* current = &plist.index();
+    float error = 0.0f;
+    if (plist.drawMode() == DrawModeTriangles)
+    {
+        for (size_t level = 0; level < maxLevels; ++level)
+        {
+            // The error of each level is relative to the previous one, so the error relative
+            // to the full detail is estimated as the sum
+            size_t target = static_cast<size_t>(static_cast<float>(current->size() / 3) * ratio);
+            if (error >= maxError)
+            {
+                break;
+            }
+            float levelError = 0.0f;
+            auto next = simplify(plist, *current, target, maxError - error, &levelError);
+            if (next.empty() || next.size() > current->size() * 9 / 10)
+            {
+                break;
+            }
+            error += levelError;
+            lods.push_back({ std::move(next), error });
+            current = &lods.back().index;
+        }
+    }
+    plist.setLods(std::move(lods));
+}
+
+void MeshSimplifier::buildLods(const std::vector<std::shared_ptr<PolyList>>& polyLists, size_t maxLevels, float ratio, float maxError) const
+{
+    tools::ThreadPool::shared().parallelFor(polyLists.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            buildLods(*polyLists[i], maxLevels, ratio, maxError);
+        }
+    });
+}
+
+}
+}
@@ -0,0 +1,366 @@
+
+#include <bg2e/base/MeshletBuilder.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace bg2e {
+namespace base {
+
+static const uint32_t InvalidTriangle = 0xFFFFFFFF;
+static const uint32_t InvalidLocalVertex = 0xFFFFFFFF;
+
+// The normals of a meshlet are too different to cull it if the minimum dot product with the
+// cone axis is lower than this value
+static const float MeshletConeMinDot = 0.1f;
+
+// Ritter's bounding sphere: the sphere of the two farthest extreme points on the axes, grown
+// to contain the rest of the points
+static void meshletBoundingSphere(const std::vector<glm::vec3>& points, glm::vec3& center, float& radius)
+{
+    size_t minPoint[3] = { 0, 0, 0 };
+    size_t maxPoint[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minPoint[axis] = points[i][axis] < points[minPoint[axis]][axis] ? i : minPoint[axis];
+            maxPoint[axis] = points[i][axis] > points[maxPoint[axis]][axis] ? i : maxPoint[axis];
+        }
+    }
+
+    int bestAxis = 0;
+    float bestDistance = -1.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::vec3 d = points[maxPoint[axis]] - points[minPoint[axis]];
+        float distance = glm::dot(d, d);
+        if (distance > bestDistance)
+        {
+            bestDistance = distance;
+            bestAxis = axis;
+        }
+    }
+
+    center = (points[minPoint[bestAxis]] + points[maxPoint[bestAxis]]) * 0.5f;
+    radius = std::sqrt(bestDistance) * 0.5f;
+    for (const auto& p : points)
+    {
+        float distance = glm::length(p - center);
+        if (distance > radius)
+        {
+            float shift = (distance - radius) * 0.5f;
+            center += (p - center) * (shift / distance);
+            radius += shift;
+        }
+    }
+}
+
+MeshletFrustum MeshletFrustum::fromMatrix(const glm::mat4& viewProjection)
+{
+    // Rows of the matrix, that is stored by columns
+    glm::vec4 row[4];
+    for (int r = 0; r < 4; ++r)
+    {
+        row[r] = glm::vec4{ viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r] };
+    }
+
+    MeshletFrustum result;
+    result.planes[0] = row[3] + row[0];
+    result.planes[1] = row[3] - row[0];
+    result.planes[2] = row[3] + row[1];
+    result.planes[3] = row[3] - row[1];
+    result.planes[4] = row[2];
+    result.planes[5] = row[3] - row[2];
+    for (auto& p : result.planes)
+    {
+        float length = glm::length(glm::vec3(p));
+        p = length > 0.0f ? p / length : p;
+    }
+    return result;
+}
+
+MeshletBuilder::MeshletBuilder()
+{
+
+}
+
+PolyListMeshlets MeshletBuilder::build(const PolyList& plist) const
+{
+    if (_maxVertices < 3 || _maxVertices > 256 || _maxTriangles < 1 || _maxTriangles > 512)
+    {
+        throw std::runtime_error("MeshletBuilder: invalid meshlet limits");
+    }
+    const auto& index = plist.index();
+    const auto& vertex = plist.vertex();
+    const size_t vertexCount = vertex.size() / 3;
+    const size_t triangleCount = index.size() / 3;
+    if (plist.drawMode() != DrawModeTriangles || index.size() % 3 != 0)
+    {
+        throw std::runtime_error("MeshletBuilder: poly list '" + plist.name() + "' is not a triangle list");
+    }
+    for (auto i : index)
+    {
+        if (i >= vertexCount)
+        {
+            throw std::runtime_error("MeshletBuilder: vertex index out of range in poly list '" + plist.name() + "'");
+        }
+    }
+
+    auto position = [&](uint32_t v) {
+        return glm::vec3{ vertex[v * 3], vertex[v * 3 + 1], vertex[v * 3 + 2] };
+    };
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        centroids[t] = (position(index[t * 3]) + position(index[t * 3 + 1]) + position(index[t * 3 + 2])) / 3.0f;
+    }
+
+    // Live triangles of each vertex, in compressed rows. The emitted triangles are moved to
+    // the end of the row, so the live ones are the first liveTriangles[v]
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (auto i : index)
+    {
+        ++liveTriangles[i];
+    }
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        firstTriangle[v + 1] = firstTriangle[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> vertexTriangles(index.size());
+    {
+        std::vector<uint32_t> next(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < index.size(); ++i)
+        {
+            vertexTriangles[next[index[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    PolyListMeshlets result;
+    result.meshlets.reserve(triangleCount / _maxTriangles + 1);
+    result.vertices.reserve(index.size() / 2);
+    result.triangles.reserve(index.size() + index.size() / 3);
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> localVertex(vertexCount, InvalidLocalVertex);
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> normals;
+    Meshlet meshlet;
+    glm::vec3 centroidSum{ 0.0f };
+    size_t cursor = 0;
+    uint32_t seed = InvalidTriangle;
+
+    auto newVertices = [&](uint32_t t) {
+        return (localVertex[index[t * 3]] == InvalidLocalVertex ? 1u : 0u) +
+            (localVertex[index[t * 3 + 1]] == InvalidLocalVertex ? 1u : 0u) +
+            (localVertex[index[t * 3 + 2]] == InvalidLocalVertex ? 1u : 0u);
+    };
+
+    auto emit = [&](uint32_t t) {
+        emitted[t] = 1;
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t v = index[t * 3 + c];
+            if (localVertex[v] == InvalidLocalVertex)
+            {
+                localVertex[v] = meshlet.vertexCount++;
+                result.vertices.push_back(v);
+            }
+            result.triangles.push_back(static_cast<uint8_t>(localVertex[v]));
+
+            uint32_t* row = &vertexTriangles[firstTriangle[v]];
+            uint32_t* live = std::find(row, row + liveTriangles[v], t);
+            std::swap(*live, row[--liveTriangles[v]]);
+        }
+        centroidSum += centroids[t];
+        ++meshlet.triangleCount;
+    };
+
+    auto finish = [&]() {
+        // The triangles of each meshlet start at a four byte boundary
+        while (result.triangles.size() % 4 != 0)
+        {
+            result.triangles.push_back(0);
+        }
+
+        const uint32_t* meshletVertices = &result.vertices[meshlet.vertexOffset];
+        const uint8_t* meshletTriangles = &result.triangles[meshlet.triangleOffset];
+        MeshletBounds bounds;
+        points.clear();
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+        {
+            points.push_back(position(meshletVertices[i]));
+            localVertex[meshletVertices[i]] = InvalidLocalVertex;
+        }
+        meshletBoundingSphere(points, bounds.center, bounds.radius);
+
+        // The cone axis is the mean of the triangle normals, and the apex is moved back
+        // along the axis until it is behind all the triangle planes. The degenerated
+        // triangles have a zero normal, and they are ignored
+        normals.resize(meshlet.triangleCount);
+        glm::vec3 axis{ 0.0f };
+        for (uint32_t i = 0; i < meshlet.triangleCount; ++i)
+        {
+            const glm::vec3& p0 = points[meshletTriangles[i * 3]];
+            glm::vec3 normal = glm::cross(points[meshletTriangles[i * 3 + 1]] - p0, points[meshletTriangles[i * 3 + 2]] - p0);
+            float length = glm::length(normal);
+            normals[i] = length > 0.0f ? normal / length : glm::vec3{ 0.0f };
+            axis += normals[i];
+        }
+        float axisLength = glm::length(axis);
+        float minDot = 1.0f;
+        if (axisLength > 0.0f)
+        {
+            axis /= axisLength;
+            for (const auto& n : normals)
+            {
+                if (n != glm::vec3{ 0.0f })
+                {
+                    minDot = std::min(minDot, glm::dot(axis, n));
+                }
+            }
+        }
+        bounds.coneApex = bounds.center;
+        if (axisLength > 0.0f && minDot >= MeshletConeMinDot)
+        {
+            float maxT = 0.0f;
+            for (uint32_t i = 0; i < meshlet.triangleCount; ++i)
+            {
+                if (normals[i] != glm::vec3{ 0.0f })
+                {
+                    const glm::vec3& p0 = points[meshletTriangles[i * 3]];
+                    maxT = std::max(maxT, glm::dot(bounds.center - p0, normals[i]) / glm::dot(axis, normals[i]));
+                }
+            }
+            bounds.coneApex = bounds.center - axis * maxT;
+            bounds.coneAxis = axis;
+            bounds.coneCutoff = std::sqrt(std::max(0.0f, 1.0f - minDot * minDot));
+        }
+
+        result.meshlets.push_back(meshlet);
+        result.bounds.push_back(bounds);
+        meshlet = Meshlet();
+        meshlet.vertexOffset = static_cast<uint32_t>(result.vertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(result.triangles.size());
+        centroidSum = glm::vec3{ 0.0f };
+    };
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; )
+    {
+        // Start the meshlet next to the previous one, or at the next triangle in order
+        uint32_t t = seed;
+        if (t == InvalidTriangle)
+        {
+            while (emitted[cursor])
+            {
+                ++cursor;
+            }
+            t = static_cast<uint32_t>(cursor);
+        }
+        seed = InvalidTriangle;
+
+        while (t != InvalidTriangle)
+        {
+            emit(t);
+            ++emittedCount;
+
+            // Live triangles that share a vertex with the meshlet. The ones that add less
+            // vertices are preferred, and the triangles that complete the last triangle of a
+            // vertex are taken first, so they do not start a new meshlet later
+            uint32_t best = InvalidTriangle;
+            uint32_t bestNew = 0;
+            float bestDistance = 0.0f;
+            uint32_t closest = InvalidTriangle;
+            float closestDistance = 0.0f;
+            const glm::vec3 center = centroidSum / static_cast<float>(meshlet.triangleCount);
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+            {
+                uint32_t v = result.vertices[meshlet.vertexOffset + i];
+                for (uint32_t j = 0; j < liveTriangles[v]; ++j)
+                {
+                    uint32_t candidate = vertexTriangles[firstTriangle[v] + j];
+                    glm::vec3 d = centroids[candidate] - center;
+                    float distance = glm::dot(d, d);
+                    if (closest == InvalidTriangle || distance < closestDistance)
+                    {
+                        closest = candidate;
+                        closestDistance = distance;
+                    }
+                    uint32_t added = newVertices(candidate);
+                    if (meshlet.vertexCount + added > _maxVertices)
+                    {
+                        continue;
+                    }
+                    const uint32_t* corners = &index[candidate * 3];
+                    if (liveTriangles[corners[0]] == 1 || liveTriangles[corners[1]] == 1 || liveTriangles[corners[2]] == 1)
+                    {
+                        added = 0;
+                    }
+                    if (best == InvalidTriangle || added < bestNew || (added == bestNew && distance < bestDistance))
+                    {
+                        best = candidate;
+                        bestNew = added;
+                        bestDistance = distance;
+                    }
+                }
+            }
+
+            if (meshlet.triangleCount == _maxTriangles || best == InvalidTriangle)
+            {
+                seed = closest;
+                break;
+            }
+            t = best;
+        }
+        finish();
+    }
+
+    return result;
+}
+
+std::vector<PolyListMeshlets> MeshletBuilder::build(const std::vector<std::shared_ptr<PolyList>>& polyLists) const
+{
+    std::vector<PolyListMeshlets> result(polyLists.size());
+    tools::ThreadPool::shared().parallelFor(polyLists.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            result[i] = build(*polyLists[i]);
+        }
+    });
+    return result;
+}
+
+size_t MeshletBuilder::cull(
+    const PolyListMeshlets& meshlets,
+    const MeshletFrustum& frustum,
+    const glm::vec3& cameraPosition,
+    std::vector<uint32_t>& visible)
+{
+    visible.clear();
+    for (size_t i = 0; i < meshlets.bounds.size(); ++i)
+    {
+        const MeshletBounds& bounds = meshlets.bounds[i];
+        if (!frustum.sphereVisible(bounds.center, bounds.radius))
+        {
+            continue;
+        }
+
+        // Same as the cone test with a normalized direction, without the division
+        glm::vec3 direction = bounds.coneApex - cameraPosition;
+        if (glm::dot(direction, bounds.coneAxis) > bounds.coneCutoff * glm::length(direction))
+        {
+            continue;
+        }
+        visible.push_back(static_cast<uint32_t>(i));
+    }
+    return visible.size();
+}
+
+}
+}
@@ -0,0 +1,391 @@
+
+#include <bg2e/base/ObjImporter.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+
+namespace bg2e {
+namespace base {
+
+// Open addressing table from the index triple of a face corner to its welded vertex index
+class ObjVertexTable
+{
+public:
+    // Closed meshes have about one vertex for each six corners, so the table starts smaller
+    // than the corner count and grows when it is half full
+    ObjVertexTable(size_t cornerCount)
+    {
+        size_t size = 16;
+        while (size < cornerCount / 2)
+        {
+            size <<= 1;
+        }
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    // Returns the vertex index of the triple, or `next` if the triple is new
+    uint32_t insert(const tinyobj::index_t& key, uint32_t next)
+    {
+        if ((_count + 1) * 2 > _slots.size())
+        {
+            grow();
+        }
+        size_t i = hash(key) & _mask;
+        while (true)
+        {
+            Slot& slot = _slots[i];
+            if (slot.index == Empty)
+            {
+                slot.vertex = key.vertex_index;
+                slot.normal = key.normal_index;
+                slot.texCoord = key.texcoord_index;
+                slot.index = next;
+                ++_count;
+                return next;
+            }
+            if (slot.vertex == key.vertex_index && slot.normal == key.normal_index && slot.texCoord == key.texcoord_index)
+            {
+                return slot.index;
+            }
+            i = (i + 1) & _mask;
+        }
+    }
+
+protected:
+    static const uint32_t Empty = std::numeric_limits<uint32_t>::max();
+
+    struct Slot
+    {
+        int32_t vertex = 0;
+        int32_t normal = 0;
+        int32_t texCoord = 0;
+        uint32_t index = Empty;
+    };
+
+    std::vector<Slot> _slots;
+    size_t _mask;
+    size_t _count = 0;
+
+    void grow()
+    {
+        std::vector<Slot> slots(_slots.size() * 2);
+        _mask = slots.size() - 1;
+        for (const Slot& slot : _slots)
+        {
+            if (slot.index != Empty)
+            {
+                size_t i = hash(slot.vertex, slot.normal, slot.texCoord) & _mask;
+                while (slots[i].index != Empty)
+                {
+                    i = (i + 1) & _mask;
+                }
+                slots[i] = slot;
+            }
+        }
+        _slots.swap(slots);
+    }
+
+    static inline size_t hash(const tinyobj::index_t& key)
+    {
+        return hash(key.vertex_index, key.normal_index, key.texcoord_index);
+    }
+
+    static inline size_t hash(int32_t vertex, int32_t normal, int32_t texCoord)
+    {
+        uint64_t h = static_cast<uint32_t>(vertex);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(normal);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(texCoord);
+        h *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+// Faces of a shape that use the same material
+struct ObjFaceGroup
+{
+    size_t shape;
+    int material;
+    // Offset of the first corner of each face in the shape indices
+    std::vector<size_t> faces;
+};
+
+static std::shared_ptr<PolyList> buildPolyList(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape, const ObjFaceGroup& group)
+{
+    const auto& indices = shape.mesh.indices;
+    const size_t cornerCount = group.faces.size() * 3;
+    const size_t vertexCount = attrib.vertices.size() / 3;
+    const size_t normalCount = attrib.normals.size() / 3;
+    const size_t texCoordCount = attrib.texcoords.size() / 2;
+    const bool hasColors = attrib.colors.size() == attrib.vertices.size();
+
+    bool hasNormals = false;
+    bool hasTexCoords = false;
+    for (size_t face : group.faces)
+    {
+        for (size_t c = face; c < face + 3; ++c)
+        {
+            const tinyobj::index_t& index = indices[c];
+            if (index.vertex_index < 0 || static_cast<size_t>(index.vertex_index) >= vertexCount ||
+                index.normal_index >= static_cast<int>(normalCount) ||
+                index.texcoord_index >= static_cast<int>(texCoordCount))
+            {
+                throw std::runtime_error("ObjImporter: vertex index out of range in shape '" + shape.name + "'");
+            }
+            hasNormals = hasNormals || index.normal_index >= 0;
+            hasTexCoords = hasTexCoords || index.texcoord_index >= 0;
+        }
+    }
+
+    std::vector<float> vertex;
+    std::vector<float> normal;
+    std::vector<float> texCoord;
+    std::vector<float> color;
+    std::vector<uint32_t> index;
+    vertex.reserve(cornerCount * 3);
+    index.reserve(cornerCount);
+
+    ObjVertexTable table(cornerCount);
+    uint32_t nextIndex = 0;
+    for (size_t face : group.faces)
+    {
+        for (size_t c = face; c < face + 3; ++c)
+        {
+            const tinyobj::index_t& corner = indices[c];
+            uint32_t welded = table.insert(corner, nextIndex);
+            index.push_back(welded);
+            if (welded != nextIndex)
+            {
+                continue;
+            }
+            ++nextIndex;
+
+            const float* v = &attrib.vertices[static_cast<size_t>(corner.vertex_index) * 3];
+            vertex.insert(vertex.end(), v, v + 3);
+            if (hasNormals)
+            {
+                if (corner.normal_index >= 0)
+                {
+                    const float* n = &attrib.normals[static_cast<size_t>(corner.normal_index) * 3];
+                    normal.insert(normal.end(), n, n + 3);
+                }
+                else
+                {
+                    normal.insert(normal.end(), { 0.0f, 0.0f, 0.0f });
+                }
+            }
+            if (hasTexCoords)
+            {
+                if (corner.texcoord_index >= 0)
+                {
+                    const float* t = &attrib.texcoords[static_cast<size_t>(corner.texcoord_index) * 2];
+                    texCoord.insert(texCoord.end(), t, t + 2);
+                }
+                else
+                {
+                    texCoord.insert(texCoord.end(), { 0.0f, 0.0f });
+                }
+            }
+            if (hasColors)
+            {
+                const float* col = &attrib.colors[static_cast<size_t>(corner.vertex_index) * 3];
+                color.insert(color.end(), { col[0], col[1], col[2], 1.0f });
+            }
+        }
+    }
+
+    auto result = std::make_shared<PolyList>();
+    result->setVertex(std::move(vertex));
+    result->setNormal(std::move(normal));
+    result->setTexCoord0(std::move(texCoord));
+    result->setColor(std::move(color));
+    result->setIndex(std::move(index));
+    return result;
+}
+
+static std::shared_ptr<tools::JsonNode> materialData(const tinyobj::material_t& material)
+{
+    tools::JsonObject result;
+    result["name"] = tools::JSON(material.name);
+    result["class"] = tools::JSON("GenericMaterial");
+    result["diffuseR"] = tools::JSON(material.diffuse[0]);
+    result["diffuseG"] = tools::JSON(material.diffuse[1]);
+    result["diffuseB"] = tools::JSON(material.diffuse[2]);
+    result["diffuseA"] = tools::JSON(material.dissolve);
+    result["specularR"] = tools::JSON(material.specular[0]);
+    result["specularG"] = tools::JSON(material.specular[1]);
+    result["specularB"] = tools::JSON(material.specular[2]);
+    result["specularA"] = tools::JSON(1.0f);
+    result["shininess"] = tools::JSON(material.shininess);
+    result["texture"] = tools::JSON(material.diffuse_texname);
+    result["normalMap"] = tools::JSON(material.bump_texname);
+    return tools::JSON(std::move(result));
+}
+
+ObjImporter::ObjImporter()
+{
+
+}
+
+std::vector<std::string> ObjImporter::materialLibraries(const std::string& path)
+{
+    tools::MappedFile file(path);
+    std::string_view text = file.view();
+    auto separator = path.find_last_of("/\\");
+    std::string baseDir = separator != std::string::npos ? path.substr(0, separator + 1) : "";
+
+    std::vector<std::string> result;
+    const std::string_view keyword = "mtllib";
+    for (size_t pos = text.find(keyword); pos != std::string_view::npos; pos = text.find(keyword, pos + keyword.size()))
+    {
+        // The keyword is the first token of the line, and it is followed by a space
+        size_t lineStart = pos;
+        while (lineStart > 0 && (text[lineStart - 1] == ' ' || text[lineStart - 1] == '\t'))
+        {
+            --lineStart;
+        }
+        size_t namesStart = pos + keyword.size();
+        if ((lineStart > 0 && text[lineStart - 1] != '\n') || namesStart >= text.size() ||
+            (text[namesStart] != ' ' && text[namesStart] != '\t'))
+        {
+            continue;
+        }
+        size_t lineEnd = std::min(text.find('\n', namesStart), text.size());
+
+        // File names are separated by spaces, and '\\' escapes the next character, as in
+        // tinyobjloader
+        std::string name;
+        bool escaping = false;
+        for (size_t i = namesStart + 1; i <= lineEnd; ++i)
+        {
+            char c = i < lineEnd ? text[i] : ' ';
+            if (c == '\r' && !escaping)
+            {
+                continue;
+            }
+            if (!escaping && c == '\\')
+            {
+                escaping = true;
+                continue;
+            }
+            if (!escaping && c == ' ')
+            {
+                if (!name.empty())
+                {
+                    result.push_back(baseDir + name);
+                }
+                name.clear();
+                continue;
+            }
+            escaping = false;
+            name += c;
+        }
+    }
+    return result;
+}
+
+void ObjImporter::load(const std::string& path)
+{
+    clear();
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string error;
+
+    auto separator = path.find_last_of("/\\");
+    std::string baseDir = separator != std::string::npos ? path.substr(0, separator + 1) : "";
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &_warnings, &error, path.c_str(), baseDir.c_str(), true, false))
+    {
+        throw std::runtime_error("ObjImporter: could not load file '" + path + "': " + error);
+    }
+
+    // Split the shapes by material, keeping the order of first use
+    std::vector<ObjFaceGroup> groups;
+    for (size_t s = 0; s < shapes.size(); ++s)
+    {
+        const tinyobj::mesh_t& mesh = shapes[s].mesh;
+        size_t firstGroup = groups.size();
+        size_t offset = 0;
+        for (size_t f = 0; f < mesh.num_face_vertices.size(); ++f)
+        {
+            size_t faceVertices = mesh.num_face_vertices[f];
+            if (faceVertices == 3)
+            {
+                int material = f < mesh.material_ids.size() ? mesh.material_ids[f] : -1;
+                if (material >= static_cast<int>(materials.size()))
+                {
+                    material = -1;
+                }
+                size_t g = firstGroup;
+                while (g < groups.size() && groups[g].material != material)
+                {
+                    ++g;
+                }
+                if (g == groups.size())
+                {
+                    groups.push_back(ObjFaceGroup{ s, material, {} });
+                }
+                groups[g].faces.push_back(offset);
+            }
+            offset += faceVertices;
+        }
+    }
+
+    // The groups are built by index, so the result does not depend on the thread count
+    _polyLists.resize(groups.size());
+    _materialNames.resize(groups.size());
+    auto build = [&](size_t begin, size_t end) {
+        for (size_t g = begin; g < end; ++g)
+        {
+            const ObjFaceGroup& group = groups[g];
+            const tinyobj::shape_t& shape = shapes[group.shape];
+            auto plist = buildPolyList(attrib, shape, group);
+
+            std::string name = shape.name.empty() ? "PolyList_" + std::to_string(group.shape) : shape.name;
+            bool singleGroup = (g == 0 || groups[g - 1].shape != group.shape) &&
+                (g + 1 == groups.size() || groups[g + 1].shape != group.shape);
+            if (!singleGroup && group.material >= 0)
+            {
+                name += "_" + materials[group.material].name;
+            }
+            plist->setName(name);
+            _polyLists[g] = plist;
+            _materialNames[g] = group.material >= 0 ? materials[group.material].name : "";
+        }
+    };
+
+    try
+    {
+        tools::ThreadPool::shared().parallelFor(groups.size(), 1, build);
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+
+    tools::JsonList materialList;
+    for (const auto& material : materials)
+    {
+        materialList.push_back(materialData(material));
+    }
+    _materials = tools::JSON(std::move(materialList));
+}
+
+void ObjImporter::clear()
+{
+    _polyLists.clear();
+    _materialNames.clear();
+    _materials = nullptr;
+    _warnings.clear();
+}
+
+}
+}
@@ -1,8 +1,14 @@
 
 #include <bg2e/base/PolyList.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
 
-#include <unordered_map>
 #include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 
 namespace bg2e {
 namespace base {
@@ -37,6 +43,7 @@ PolyList& PolyList::operator=(const PolyList& other)
     setTexCoord2(other.texCoord2());
     setColor(other.color());
     setIndex(other.index());
+    setLods(other.lods());
     
     assertValidTangents();
     
@@ -54,108 +61,201 @@ void PolyList::assertValidTangents()
 bool PolyList::validTangents() const
 {
     return  _tangent.size() == _vertex.size() &&
-            _tangent.size() / 3 == _texCoord0.size() / 2;
+            _tangent.size() / 3 == _texCoord0.size() / 2 &&
+            _tangentHandedness.size() * 3 == _tangent.size();
+}
+
+// Unit vector perpendicular to n, used when a vertex has no valid texture coordinate gradient
+static glm::vec3 perpendicular(const glm::vec3& n)
+{
+    glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3{ 1.0f, 0.0f, 0.0f } : glm::vec3{ 0.0f, 1.0f, 0.0f };
+    glm::vec3 result = glm::cross(n, axis);
+    float length = glm::length(result);
+    return length > 0.0f ? result / length : glm::vec3{ 0.0f, 0.0f, 1.0f };
 }
 
-void PolyList::rebuildTangents()
+void PolyList::rebuildTangents(bool parallel)
 {
+    // Triangles and vertices processed by each parallel task
+    const size_t grain = 32768;
+
     _tangent.clear();
+    _tangentHandedness.clear();
 
-    if (_texCoord0.size() == 0 || _vertex.size() == 0)
+    const size_t vertexCount = _vertex.size() / 3;
+    if (vertexCount == 0 || _texCoord0.size() != vertexCount * 2)
     {
         return;
     }
-    
+
+    const bool hasNormals = _normal.size() == _vertex.size();
+    const size_t triangleCount = _index.size() % 3 == 0 ? _index.size() / 3 : 0;
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        if (_index[i] >= vertexCount)
+        {
+            throw std::runtime_error("PolyList::rebuildTangents(): vertex index out of range in poly list '" + name() + "'");
+        }
+    }
+
+    auto& pool = tools::ThreadPool::shared();
+    parallel = parallel && pool.threadCount() > 0 && triangleCount > grain;
+
+    // Tangent and bitangent of a triangle. They are scaled by the texture coordinate area, so
+    // the sum of the adjacent triangles is weighted by area, and the division by the area,
+    // that fails with degenerated coordinates, is not needed
+    auto faceTangent = [&](size_t t, glm::vec3& tangent, glm::vec3& bitangent) {
+        const uint32_t* tri = &_index[t * 3];
+        const float* p0 = &_vertex[tri[0] * 3];
+        const float* p1 = &_vertex[tri[1] * 3];
+        const float* p2 = &_vertex[tri[2] * 3];
+        const float* t0 = &_texCoord0[tri[0] * 2];
+        const float* t1 = &_texCoord0[tri[1] * 2];
+        const float* t2 = &_texCoord0[tri[2] * 2];
+
+        glm::vec3 edge1{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        glm::vec3 edge2{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float deltaU1 = t1[0] - t0[0];
+        float deltaV1 = t1[1] - t0[1];
+        float deltaU2 = t2[0] - t0[0];
+        float deltaV2 = t2[1] - t0[1];
+
+        float den = deltaU1 * deltaV2 - deltaU2 * deltaV1;
+        float sign = den < 0.0f ? -1.0f : 1.0f;
+        tangent = (edge1 * deltaV2 - edge2 * deltaV1) * sign;
+        bitangent = (edge2 * deltaU1 - edge1 * deltaU2) * sign;
+        return den != 0.0f;
+    };
+
+    // Sums of the adjacent triangles of each vertex, added in triangle order in both paths, so
+    // the result is the same with any thread count
+    std::vector<glm::vec3> vertexTangents(vertexCount * 2, glm::vec3{ 0.0f });
     bool invalidUV = false;
-    if (_index.size() % 3 == 0)
+    if (!parallel)
     {
-        std::unordered_map<uint32_t, bool> generatedIndexes;
-        for (uint32_t i = 0; i < _index.size(); i += 3)
+        for (size_t t = 0; t < triangleCount; ++t)
         {
-            auto v0i = _index[i] * 3;
-            auto v1i = _index[i + 1] * 3;
-            auto v2i = _index[i + 2] * 3;
-            
-            auto t0i = _index[i] * 2;
-            auto t1i = _index[i + 1] * 2;
-            auto t2i = _index[i + 2] * 2;
-            
-            glm::vec3 v0{ _vertex[v0i], _vertex[v0i + 1], _vertex[v0i + 2] };
-            glm::vec3 v1{ _vertex[v1i], _vertex[v1i + 1], _vertex[v1i + 2] };
-            glm::vec3 v2{ _vertex[v2i], _vertex[v2i + 1], _vertex[v2i + 2] };
-            
-            glm::vec2 t0{ _texCoord0[t0i], _texCoord0[t0i + 1] };
-            glm::vec2 t1{ _texCoord0[t1i], _texCoord0[t1i + 1] };
-            glm::vec2 t2{ _texCoord0[t2i], _texCoord0[t2i + 1] };
-            
-            auto edge1 = v1 - v0;
-            auto edge2 = v2 - v0;
-            
-            auto deltaU1 = t1.x - t0.x;
-            auto deltaV1 = t1.y - t0.y;
-            auto deltaU2 = t2.x - t0.x;
-            auto deltaV2 = t2.y - t0.y;
-            
-            auto den = (deltaU1 * deltaV2 - deltaU2 * deltaV1);
-            glm::vec3 tangent;
-            if (den == 0)
+            glm::vec3 tangent, bitangent;
+            invalidUV = !faceTangent(t, tangent, bitangent) || invalidUV;
+            for (size_t c = t * 3; c < t * 3 + 3; ++c)
             {
-                if (_normal.size() == _vertex.size())
-                {
-                    tangent = glm::vec3{_normal[v0i + 1], _normal[v0i + 2], _normal[v0i]};
-                }
-                else
+                vertexTangents[_index[c] * 2] += tangent;
+                vertexTangents[_index[c] * 2 + 1] += bitangent;
+            }
+        }
+    }
+    else
+    {
+        std::vector<glm::vec3> faceTangents(triangleCount * 2);
+        std::atomic<bool> invalidFaces = false;
+        pool.parallelFor(triangleCount, grain, [&](size_t begin, size_t end) {
+            bool invalid = false;
+            for (size_t t = begin; t < end; ++t)
+            {
+                invalid = !faceTangent(t, faceTangents[t * 2], faceTangents[t * 2 + 1]) || invalid;
+            }
+            if (invalid)
+            {
+                invalidFaces = true;
+            }
+        });
+        invalidUV = invalidFaces;
+
+        // Triangles of each vertex, in triangle order. It is a counting sort over a few ranges of
+        // triangles: each range counts its corners in its own buffer, and the buffers are merged
+        // in range order, so the table is the same as the one built by a single thread
+        const size_t ranges = std::min<size_t>(std::min<size_t>(pool.threadCount() + 1, 8), (triangleCount + grain - 1) / grain);
+        const size_t rangeTriangles = (triangleCount + ranges - 1) / ranges;
+        std::vector<uint32_t> rangeCorners(ranges * vertexCount, 0);
+        pool.parallelFor(ranges, 1, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
+            {
+                uint32_t* counts = &rangeCorners[r * vertexCount];
+                const size_t lastCorner = std::min((r + 1) * rangeTriangles, triangleCount) * 3;
+                for (size_t i = r * rangeTriangles * 3; i < lastCorner; ++i)
                 {
-                    tangent = glm::vec3{ 0.0f, 0.0f, 1.0f };
+                    ++counts[_index[i]];
                 }
-                
-                invalidUV = true;
             }
-            else
+        });
+        std::vector<uint32_t> firstCorner(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            uint32_t corner = firstCorner[v];
+            for (size_t r = 0; r < ranges; ++r)
             {
-                auto f = 1.0f / den;
-                tangent = glm::normalize(glm::vec3{
-                    f * (deltaV2 * edge1.x - deltaV1 * edge2.x),
-                    f * (deltaV2 * edge1.y - deltaV1 * edge2.y),
-                    f * (deltaV2 * edge1.z - deltaV1 * edge2.z)
-                });
+                uint32_t count = rangeCorners[r * vertexCount + v];
+                rangeCorners[r * vertexCount + v] = corner;
+                corner += count;
             }
-            
-            if (!generatedIndexes[v0i])
+            firstCorner[v + 1] = corner;
+        }
+        std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+        pool.parallelFor(ranges, 1, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
             {
-                _tangent.push_back(tangent.x);
-                _tangent.push_back(tangent.y);
-                _tangent.push_back(tangent.z);
-                generatedIndexes[v0i] = true;
+                uint32_t* next = &rangeCorners[r * vertexCount];
+                const size_t lastCorner = std::min((r + 1) * rangeTriangles, triangleCount) * 3;
+                for (size_t i = r * rangeTriangles * 3; i < lastCorner; ++i)
+                {
+                    vertexTriangles[next[_index[i]]++] = static_cast<uint32_t>(i / 3);
+                }
             }
-            
-            if (!generatedIndexes[v1i])
+        });
+
+        pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
             {
-                _tangent.push_back(tangent.x);
-                _tangent.push_back(tangent.y);
-                _tangent.push_back(tangent.z);
-                generatedIndexes[v1i] = true;
+                glm::vec3 tangent{ 0.0f };
+                glm::vec3 bitangent{ 0.0f };
+                for (uint32_t c = firstCorner[v]; c < firstCorner[v + 1]; ++c)
+                {
+                    tangent += faceTangents[vertexTriangles[c] * 2];
+                    bitangent += faceTangents[vertexTriangles[c] * 2 + 1];
+                }
+                vertexTangents[v * 2] = tangent;
+                vertexTangents[v * 2 + 1] = bitangent;
             }
-            
-            if (generatedIndexes[v2i])
+        });
+    }
+
+    _tangent.resize(vertexCount * 3);
+    _tangentHandedness.resize(vertexCount);
+    auto orthonormalize = [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+        {
+            const glm::vec3& tangent = vertexTangents[v * 2];
+            const glm::vec3& bitangent = vertexTangents[v * 2 + 1];
+
+            // Without a normal, the tangents are orthonormalized against the surface normal
+            glm::vec3 normal = hasNormals ? glm::vec3{ _normal[v * 3], _normal[v * 3 + 1], _normal[v * 3 + 2] } : glm::vec3{ 0.0f };
+            if (glm::length(normal) == 0.0f)
             {
-                _tangent.push_back(tangent.x);
-                _tangent.push_back(tangent.y);
-                _tangent.push_back(tangent.z);
-                generatedIndexes[v2i] = true;
+                normal = glm::cross(tangent, bitangent);
             }
+            float normalLength = glm::length(normal);
+            normal = normalLength > 0.0f ? normal / normalLength : glm::vec3{ 0.0f, 0.0f, 1.0f };
+
+            // Gram-Schmidt
+            glm::vec3 t = tangent - normal * glm::dot(normal, tangent);
+            float length = glm::length(t);
+            t = length > 1e-20f ? t / length : perpendicular(normal);
+
+            _tangent[v * 3] = t.x;
+            _tangent[v * 3 + 1] = t.y;
+            _tangent[v * 3 + 2] = t.z;
+            _tangentHandedness[v] = glm::dot(glm::cross(normal, t), bitangent) < 0.0f ? -1.0f : 1.0f;
         }
+    };
+    if (parallel)
+    {
+        pool.parallelFor(vertexCount, grain, orthonormalize);
     }
     else
     {
-        for (uint32_t i = 0; i < _index.size(); i += 3)
-        {
-            _tangent.push_back(0.0f);
-            _tangent.push_back(0.0f);
-            _tangent.push_back(1.0f);
-        }
+        orthonormalize(0, vertexCount);
     }
-    
+
     if (invalidUV)
     {
         std::cerr << "WARN: Invalid UV texture coords found in PolyList '" << name()
@@ -163,5 +263,84 @@ void PolyList::rebuildTangents()
     }
 }
 
+PolyListBounds PolyList::computeBounds() const
+{
+    PolyListBounds result;
+    if (_vertex.size() < 3)
+    {
+        return result;
+    }
+    
+    result.min = result.max = glm::vec3{ _vertex[0], _vertex[1], _vertex[2] };
+    for (size_t i = 3; i + 2 < _vertex.size(); i += 3)
+    {
+        glm::vec3 v{ _vertex[i], _vertex[i + 1], _vertex[i + 2] };
+        result.min = glm::min(result.min, v);
+        result.max = glm::max(result.max, v);
+    }
+    return result;
+}
+
+void PolyList::remapVertices(const std::vector<uint32_t>& remap, size_t newVertexCount)
+{
+    const size_t vertexCount = _vertex.size() / 3;
+    if (remap.size() != vertexCount)
+    {
+        throw std::runtime_error("PolyList::remapVertices(): the remap table does not match the vertex count");
+    }
+
+    auto checkIndices = [&](const std::vector<uint32_t>& indices) {
+        for (auto index : indices)
+        {
+            if (index >= vertexCount || remap[index] == RemovedVertex || remap[index] >= newVertexCount)
+            {
+                throw std::runtime_error("PolyList::remapVertices(): invalid vertex index in poly list '" + name() + "'");
+            }
+        }
+    };
+    checkIndices(_index);
+    for (const auto& lod : _lods)
+    {
+        checkIndices(lod.index);
+    }
+    for (auto& index : _index)
+    {
+        index = remap[index];
+    }
+    for (auto& lod : _lods)
+    {
+        for (auto& index : lod.index)
+        {
+            index = remap[index];
+        }
+    }
+
+    // Streams that do not have one item per vertex are not valid, and they are removed
+    auto remapStream = [&](std::vector<float>& stream, size_t components) {
+        if (stream.size() != vertexCount * components)
+        {
+            stream.clear();
+            return;
+        }
+        std::vector<float> result(newVertexCount * components, 0.0f);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            if (remap[v] != RemovedVertex && remap[v] < newVertexCount)
+            {
+                std::copy_n(&stream[v * components], components, &result[remap[v] * components]);
+            }
+        }
+        stream.swap(result);
+    };
+    remapStream(_vertex, 3);
+    remapStream(_normal, 3);
+    remapStream(_texCoord0, 2);
+    remapStream(_texCoord1, 2);
+    remapStream(_texCoord2, 2);
+    remapStream(_color, 4);
+    remapStream(_tangent, 3);
+    remapStream(_tangentHandedness, 1);
+}
+
 }
 }
@@ -8,6 +8,10 @@
 namespace bg2e {
 namespace base {
 
+static_assert(tools::JsonFieldSet<Texture>::fieldMask("wrapModeX") == TextureFieldWrapModeX &&
+              tools::JsonFieldSet<Texture>::fieldMask("componentFormat") == TextureFieldComponentFormat,
+              "TextureField bits must match the order of Texture::jsonFields()");
+
 Texture::Texture()
 {
     
@@ -36,5 +40,30 @@ void Texture::loadImageData(bool refresh)
     }
 }
 
+uint32_t Texture::applyPatch(tools::JsonNode& patch)
+{
+    bool sizeChanged = false;
+    auto changed = static_cast<uint32_t>(tools::JsonFieldSet<Texture>::patch(patch, *this, [&](std::string_view key, tools::JsonNode& value)
+    {
+        if (key == "size" && value.isList() && value.listSize() >= 2)
+        {
+            auto size = value.vec2Value();
+            Size newSize;
+            newSize.width = static_cast<uint32_t>(size.x);
+            newSize.height = static_cast<uint32_t>(size.y);
+            sizeChanged = newSize.width != _size.width || newSize.height != _size.height;
+            _size = newSize;
+            return true;
+        }
+        return false;
+    }));
+    if (sizeChanged)
+    {
+        changed |= TextureFieldSize;
+    }
+    _dirtyFields |= changed;
+    return changed;
+}
+
 }
 }
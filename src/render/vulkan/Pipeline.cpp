@@ -54,7 +54,12 @@ void Pipeline::build(VulkanAPI *vulkanApi)
     
 
     // Vertex input
-    // TODO: vertex input
+    vk::PipelineVertexInputStateCreateInfo vertexInput;
+    vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindings.size());
+    vertexInput.pVertexBindingDescriptions = vertexBindings.data();
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+    vertexInput.pVertexAttributeDescriptions = vertexAttributes.data();
+    _createInfo.pVertexInputState = &vertexInput;
 
     // Input assembly
     _createInfo.pInputAssemblyState = &inputAssembly;
@@ -126,6 +131,23 @@ void Pipeline::build(VulkanAPI *vulkanApi)
     // Destroy shader modules
 }
 
+vk::Format Pipeline::vertexFormat(uint32_t floatComponents)
+{
+    switch (floatComponents)
+    {
+    case 1:
+        return vk::Format::eR32Sfloat;
+    case 2:
+        return vk::Format::eR32G32Sfloat;
+    case 3:
+        return vk::Format::eR32G32B32Sfloat;
+    case 4:
+        return vk::Format::eR32G32B32A32Sfloat;
+    default:
+        throw std::runtime_error("Invalid vertex attribute size");
+    }
+}
+
 void Pipeline::destroy()
 {
     _device.destroyPipeline(_pipeline);
@@ -1,12 +1,178 @@
 
 #include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 namespace bg2e {
 namespace tools {
 
+JsonKey JsonKey::copy(std::string_view name)
+{
+    JsonKey result;
+    result._storage = std::make_shared<const std::string>(name);
+    result._name = *result._storage;
+    result._hash = jsonKeyHash(result._name, 0);
+    return result;
+}
+
+JsonKey JsonKeyTable::intern(std::string_view name)
+{
+    if ((_count + 1) * 2 > _slots.size()) {
+        std::vector<JsonKey> slots(std::max<size_t>(_slots.size() * 2, 64));
+        size_t mask = slots.size() - 1;
+        for (auto & key : _slots) {
+            if (key.ownsName()) {
+                size_t slot = key.hash() & mask;
+                while (slots[slot].ownsName()) {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = std::move(key);
+            }
+        }
+        _slots = std::move(slots);
+    }
+
+    uint32_t hash = jsonKeyHash(name, 0);
+    size_t mask = _slots.size() - 1;
+    size_t slot = hash & mask;
+    while (_slots[slot].ownsName()) {
+        if (_slots[slot].hash() == hash && _slots[slot].name() == name) {
+            return _slots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    _slots[slot] = JsonKey::copy(name);
+    ++_count;
+    return _slots[slot];
+}
+
+void JsonKeyTable::clear()
+{
+    _slots.clear();
+    _count = 0;
+}
+
+JsonObject::JsonObject(std::initializer_list<value_type> items)
+{
+    reserve(items.size());
+    for (auto & item : items) {
+        // Same as std::map: the first value of a duplicated key is kept
+        if (!contains(item.first)) {
+            (*this)[item.first] = item.second;
+        }
+    }
+}
+
+void JsonObject::clear()
+{
+    _items.clear();
+    _index.clear();
+}
+
+void JsonObject::reserve(size_t size)
+{
+    _items.reserve(size);
+}
+
+size_t JsonObject::findItem(const JsonKey& key) const
+{
+    if (_index.empty()) {
+        for (size_t i = 0; i < _items.size(); ++i) {
+            if (_items[i].first == key) {
+                return i;
+            }
+        }
+        return _items.size();
+    }
+
+    size_t mask = _index.size() - 1;
+    for (size_t slot = key.hash() & mask; _index[slot] != 0; slot = (slot + 1) & mask) {
+        size_t item = _index[slot] - 1;
+        if (_items[item].first == key) {
+            return item;
+        }
+    }
+    return _items.size();
+}
+
+void JsonObject::indexItem(size_t item)
+{
+    size_t mask = _index.size() - 1;
+    size_t slot = _items[item].first.hash() & mask;
+    while (_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    _index[slot] = static_cast<uint32_t>(item + 1);
+}
+
+void JsonObject::rebuildIndex()
+{
+    if (_items.size() <= IndexThreshold) {
+        _index.clear();
+        return;
+    }
+    size_t indexSize = 32;
+    while (indexSize < _items.size() * 2) {
+        indexSize *= 2;
+    }
+    _index.assign(indexSize, 0);
+    for (size_t i = 0; i < _items.size(); ++i) {
+        indexItem(i);
+    }
+}
+
+std::shared_ptr<JsonNode>& JsonObject::operator[](const JsonKey& key)
+{
+    size_t item = findItem(key);
+    if (item < _items.size()) {
+        return _items[item].second;
+    }
+
+    _items.emplace_back(key.ownsName() ? key : JsonKey::copy(key.name()), nullptr);
+    if (_items.size() > IndexThreshold) {
+        if (_items.size() * 2 > _index.size()) {
+            rebuildIndex();
+        }
+        else {
+            indexItem(item);
+        }
+    }
+    return _items.back().second;
+}
+
+std::shared_ptr<JsonNode>& JsonObject::at(const JsonKey& key)
+{
+    size_t item = findItem(key);
+    if (item == _items.size()) {
+        throw std::out_of_range("JsonObject: key not found: " + std::string(key.name()));
+    }
+    return _items[item].second;
+}
+
+const std::shared_ptr<JsonNode>& JsonObject::at(const JsonKey& key) const
+{
+    size_t item = findItem(key);
+    if (item == _items.size()) {
+        throw std::out_of_range("JsonObject: key not found: " + std::string(key.name()));
+    }
+    return _items[item].second;
+}
+
+size_t JsonObject::erase(const JsonKey& key)
+{
+    size_t item = findItem(key);
+    if (item == _items.size()) {
+        return 0;
+    }
+    _items.erase(_items.begin() + item);
+    rebuildIndex();
+    return 1;
+}
+
 JsonNode::JsonNode() :type(Type::Null)
 {
     
@@ -22,7 +188,7 @@ JsonNode::JsonNode(const JsonObject& p) {
 }
 
 JsonNode::JsonNode(JsonObject&& p) {
-    setValue(p);
+    setValue(std::move(p));
 }
 
 JsonNode::JsonNode(const JsonList& p) {
@@ -30,15 +196,31 @@ JsonNode::JsonNode(const JsonList& p) {
 }
 
 JsonNode::JsonNode(JsonList&& p) {
+    setValue(std::move(p));
+}
+
+JsonNode::JsonNode(const std::vector<float>& p) {
     setValue(p);
 }
 
+JsonNode::JsonNode(std::vector<float>&& p) {
+    setValue(std::move(p));
+}
+
+JsonNode::JsonNode(const std::vector<int32_t>& p) {
+    setValue(p);
+}
+
+JsonNode::JsonNode(std::vector<int32_t>&& p) {
+    setValue(std::move(p));
+}
+
 JsonNode::JsonNode(const char* p) {
     setValue(p);
 }
 
 JsonNode::JsonNode(std::string&& p) {
-    setValue(p);
+    setValue(std::move(p));
 }
 
 JsonNode::JsonNode(const std::string & p) {
@@ -57,6 +239,10 @@ JsonNode::JsonNode(uint32_t p) {
     setValue(p);
 }
 
+JsonNode::JsonNode(int64_t p) {
+    setValue(p);
+}
+
 JsonNode::JsonNode(float p) {
     setValue(p);
 }
@@ -88,70 +274,116 @@ JsonNode::JsonNode(const glm::mat4& p) {
 JsonNode::~JsonNode() {
 }
 
-void JsonNode::printNode(int indentationLevel) {
-    std::cout << toString(indentationLevel);
+void JsonNode::unpack() {
+    if (type == Type::FloatArray || type == Type::IntArray) {
+        _listValue = packedItems();
+        _floatArray = std::vector<float>();
+        _intArray = std::vector<int32_t>();
+        type = Type::List;
+    }
 }
 
-std::string JsonNode::toString(int indentationLevel) {
-    std::string indentation = std::string(indentationLevel * 2, ' ');
-    std::string innerIndentation = std::string((indentationLevel + 1) * 2, ' ');
-    std::string outputString = "";
+JsonList JsonNode::packedItems() const {
+    JsonList result;
+    if (type == Type::FloatArray) {
+        result.reserve(_floatArray.size());
+        for (auto v : _floatArray) {
+            result.push_back(std::make_shared<JsonNode>(v));
+        }
+    }
+    else if (type == Type::IntArray) {
+        result.reserve(_intArray.size());
+        for (auto v : _intArray) {
+            result.push_back(std::make_shared<JsonNode>(v));
+        }
+    }
+    return result;
+}
 
+bool JsonNode::readFloats(float* result, size_t count) {
     switch (type) {
-    case Type::String:
-        outputString += "\"" + _stringValue + "\"";
-        break;
-    case Type::Number:
-        outputString += std::to_string(_numberValue);
-        break;
-    case Type::Bool:
-        outputString += (_boolValue ? "true" : "false");
-        break;
-    case Type::Null:
-        outputString += "null";
-        break;
-    
-    case Type::List: {
-        outputString += "[";
-        size_t index = 0;
-        bool emptyList = true;
-        for (auto node : (_listValue)) {
-            if (emptyList) {
-                outputString += "\n";
-            }
-            emptyList = false;
-            outputString += innerIndentation + node->toString(indentationLevel + 1);
-            if (index < (_listValue).size() - 1) {
-                outputString += ",";
-            }
-            outputString += "\n";
-            index++;
-        }
-        outputString += (emptyList ? "" : indentation) + "]";
-        break;
-    }
-    case Type::Object: {
-        outputString += "{";
-        bool emptyObject = true;
-        for (JsonObject::iterator i = (_objectValue).begin();
-            i != (_objectValue).end(); ++i) {
-            if (emptyObject) {
-                outputString += "\n";
+    case Type::FloatArray:
+        if (_floatArray.size() < count) {
+            return false;
+        }
+        std::copy_n(_floatArray.data(), count, result);
+        return true;
+    case Type::IntArray:
+        if (_intArray.size() < count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = static_cast<float>(_intArray[i]);
+        }
+        return true;
+    case Type::List:
+        if (_listValue.size() < count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = _listValue[i]->numberValue();
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::shared_ptr<JsonNode> JsonNode::clone() const {
+    auto result = std::make_shared<JsonNode>(*this);
+    if (type == Type::Object) {
+        for (auto & item : result->_objectValue) {
+            if (item.second) {
+                item.second = item.second->clone();
             }
-            emptyObject = false;
-            outputString += innerIndentation + "\"" + i->first + "\" : ";
-            outputString += i->second->toString(indentationLevel + 1);
-            JsonObject::iterator next = i;
-            next++;
-            if (next != (_objectValue).end()) {
-                outputString += ",";
+        }
+    }
+    else if (type == Type::List) {
+        for (auto & item : result->_listValue) {
+            if (item) {
+                item = item->clone();
             }
-            outputString += "\n";
         }
-        outputString += (emptyObject ? "" : indentation) + "}";
-        break;
     }
+    return result;
+}
+
+void JsonNode::applyMergePatch(JsonNode& patch) {
+    if (!patch.isObject()) {
+        *this = *patch.clone();
+        return;
+    }
+    if (!isObject()) {
+        setValue(JsonObject());
+    }
+    for (auto & item : patch.objectValue()) {
+        if (!item.second || item.second->isNull()) {
+            _objectValue.erase(item.first);
+        }
+        else if (item.second->isObject()) {
+            // Copy on write: the items of the copy are still shared, and they are copied
+            // when the patch reaches them
+            auto & target = _objectValue[item.first];
+            target = target ? std::make_shared<JsonNode>(*target) : std::make_shared<JsonNode>();
+            target->applyMergePatch(*item.second);
+        }
+        else {
+            _objectValue[item.first] = item.second->clone();
+        }
     }
+}
+
+void JsonNode::printNode(int indentationLevel) {
+    JsonWriter writer(std::cout, JsonWriterFormat::Pretty);
+    writer.setIndentationLevel(indentationLevel);
+    writer.write(*this);
+}
+
+std::string JsonNode::toString(int indentationLevel) {
+    std::string outputString;
+    JsonWriter writer(outputString, JsonWriterFormat::Pretty);
+    writer.setIndentationLevel(indentationLevel);
+    writer.write(*this);
     return outputString;
 }
 
@@ -162,7 +394,7 @@ std::shared_ptr<JsonNode> JSON(const JsonObject& p)
 
 std::shared_ptr<JsonNode> JSON(JsonObject&& p)
 {
-    return std::make_shared<JsonNode>(p);
+    return std::make_shared<JsonNode>(std::move(p));
 }
 
 std::shared_ptr<JsonNode> JSON(const JsonList& p)
@@ -171,10 +403,30 @@ std::shared_ptr<JsonNode> JSON(const JsonList& p)
 }
 
 std::shared_ptr<JsonNode> JSON(JsonList&& p)
+{
+    return std::make_shared<JsonNode>(std::move(p));
+}
+
+std::shared_ptr<JsonNode> JSON(const std::vector<float>& p)
 {
     return std::make_shared<JsonNode>(p);
 }
 
+std::shared_ptr<JsonNode> JSON(std::vector<float>&& p)
+{
+    return std::make_shared<JsonNode>(std::move(p));
+}
+
+std::shared_ptr<JsonNode> JSON(const std::vector<int32_t>& p)
+{
+    return std::make_shared<JsonNode>(p);
+}
+
+std::shared_ptr<JsonNode> JSON(std::vector<int32_t>&& p)
+{
+    return std::make_shared<JsonNode>(std::move(p));
+}
+
 std::shared_ptr<JsonNode> JSON(const char* p)
 {
     return std::make_shared<JsonNode>(p);
@@ -182,7 +434,7 @@ std::shared_ptr<JsonNode> JSON(const char* p)
 
 std::shared_ptr<JsonNode> JSON(std::string&& p)
 {
-    return std::make_shared<JsonNode>(p);
+    return std::make_shared<JsonNode>(std::move(p));
 }
 
 std::shared_ptr<JsonNode> JSON(const std::string& p)
@@ -205,6 +457,11 @@ std::shared_ptr<JsonNode> JSON(uint32_t p)
     return std::make_shared<JsonNode>(p);
 }
 
+std::shared_ptr<JsonNode> JSON(int64_t p)
+{
+    return std::make_shared<JsonNode>(p);
+}
+
 std::shared_ptr<JsonNode> JSON(float p)
 {
     return std::make_shared<JsonNode>(p);
@@ -240,5 +497,44 @@ std::shared_ptr<JsonNode> JSON(const glm::mat4& v)
     return std::make_shared<JsonNode>(v);
 }
 
+std::shared_ptr<JsonNode> JsonNumberListBuilder::node() const
+{
+    if (_largeIntegers || (!_int32 && !_decimalFloats)) {
+        JsonList list;
+        appendNodes(list);
+        return std::make_shared<JsonNode>(std::move(list));
+    }
+    if (_int32) {
+        std::vector<int32_t> values(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i) {
+            values[i] = static_cast<int32_t>(_items[i].integer);
+        }
+        return std::make_shared<JsonNode>(std::move(values));
+    }
+    std::vector<float> values(_items.size());
+    for (size_t i = 0; i < _items.size(); ++i) {
+        values[i] = static_cast<float>(_items[i].number);
+    }
+    return std::make_shared<JsonNode>(std::move(values));
+}
+
+void JsonNumberListBuilder::appendNodes(JsonList& list) const
+{
+    for (auto & item : _items) {
+        if (item.isInteger) {
+            list.push_back(std::make_shared<JsonNode>(item.integer));
+        }
+        else {
+            list.push_back(std::make_shared<JsonNode>(item.number));
+        }
+    }
+}
+
+bool JsonNumberListBuilder::isDecimalFloat(double value)
+{
+    float single = static_cast<float>(value);
+    return std::isfinite(single) && jsonDecimalValue(single) == value;
+}
+
 }
 }
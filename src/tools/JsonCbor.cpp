@@ -0,0 +1,399 @@
+
+#include <bg2e/tools/JsonCbor.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <span>
+#include <type_traits>
+
+namespace bg2e {
+namespace tools {
+
+// CBOR major types
+static const uint8_t g_cborUnsigned = 0;
+static const uint8_t g_cborNegative = 1;
+static const uint8_t g_cborBytes = 2;
+static const uint8_t g_cborText = 3;
+static const uint8_t g_cborArray = 4;
+static const uint8_t g_cborMap = 5;
+static const uint8_t g_cborTag = 6;
+static const uint8_t g_cborSimple = 7;
+
+// RFC 8746 typed array tags
+static const uint64_t g_tagInt32BigEndian = 74;
+static const uint64_t g_tagInt32LittleEndian = 78;
+static const uint64_t g_tagFloat32BigEndian = 81;
+static const uint64_t g_tagFloat64BigEndian = 82;
+static const uint64_t g_tagFloat32LittleEndian = 85;
+static const uint64_t g_tagFloat64LittleEndian = 86;
+
+template <typename T>
+static void swapItems(Byte* data, size_t count)
+{
+    for (size_t item = 0; item < count; ++item) {
+        Byte* bytes = data + item * sizeof(T);
+        for (size_t i = 0; i < sizeof(T) / 2; ++i) {
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+    }
+}
+
+class JsonCborEncoder {
+public:
+    JsonCborEncoder(std::vector<Byte>& result) :_out(result) {}
+
+    void encode(JsonNode& node) {
+        if (node.isObject()) {
+            auto & object = node.objectValue();
+            head(g_cborMap, object.size());
+            for (auto & item : object) {
+                text(item.first.name());
+                encodeItem(item.second);
+            }
+        }
+        else if (node.isFloatArray()) {
+            typedArray(g_tagFloat32LittleEndian, node.floatArrayValue());
+        }
+        else if (node.isIntArray()) {
+            typedArray(g_tagInt32LittleEndian, node.intArrayValue());
+        }
+        else if (node.isList()) {
+            auto & list = node.listValue();
+            if (!encodePackedFloats(list)) {
+                head(g_cborArray, list.size());
+                for (auto & item : list) {
+                    encodeItem(item);
+                }
+            }
+        }
+        else if (node.isString()) {
+            text(node.stringValue());
+        }
+        else if (node.isInteger()) {
+            int64_t value = node.int64Value();
+            if (value >= 0) {
+                head(g_cborUnsigned, static_cast<uint64_t>(value));
+            }
+            else {
+                head(g_cborNegative, static_cast<uint64_t>(-1 - value));
+            }
+        }
+        else if (node.isNumber()) {
+            // The precision is kept, so that the decoded node is written with the same text
+            if (node.isSinglePrecision()) {
+                _out.push_back(0xFA);
+                bigEndian(std::bit_cast<uint32_t>(node.numberValue()), 4);
+            }
+            else {
+                _out.push_back(0xFB);
+                bigEndian(std::bit_cast<uint64_t>(node.doubleValue()), 8);
+            }
+        }
+        else if (node.isBool()) {
+            _out.push_back(node.boolValue(false) ? 0xF5 : 0xF4);
+        }
+        else {
+            _out.push_back(0xF6);
+        }
+    }
+
+protected:
+    std::vector<Byte>& _out;
+
+    void encodeItem(const std::shared_ptr<JsonNode>& node) {
+        if (node) {
+            encode(*node);
+        }
+        else {
+            _out.push_back(0xF6);
+        }
+    }
+
+    void bigEndian(uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            _out.push_back(static_cast<Byte>(value >> (i * 8)));
+        }
+    }
+
+    void head(uint8_t major, uint64_t value) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (value < 24) {
+            _out.push_back(type | static_cast<uint8_t>(value));
+        }
+        else if (value <= 0xFF) {
+            _out.push_back(type | 24);
+            bigEndian(value, 1);
+        }
+        else if (value <= 0xFFFF) {
+            _out.push_back(type | 25);
+            bigEndian(value, 2);
+        }
+        else if (value <= 0xFFFFFFFF) {
+            _out.push_back(type | 26);
+            bigEndian(value, 4);
+        }
+        else {
+            _out.push_back(type | 27);
+            bigEndian(value, 8);
+        }
+    }
+
+    void text(std::string_view str) {
+        head(g_cborText, str.size());
+        _out.insert(_out.end(), str.begin(), str.end());
+    }
+
+    template <typename T>
+    void typedArray(uint64_t tag, std::span<const T> values) {
+        head(g_cborTag, tag);
+        head(g_cborBytes, values.size_bytes());
+        size_t offset = _out.size();
+        _out.resize(offset + values.size_bytes());
+        if (!values.empty()) {
+            std::memcpy(_out.data() + offset, values.data(), values.size_bytes());
+        }
+        if (std::endian::native != std::endian::little) {
+            swapItems<T>(_out.data() + offset, values.size());
+        }
+    }
+
+    // Lists of single precision numbers are written as a single byte string
+    bool encodePackedFloats(JsonList& list) {
+        if (list.size() < 2) {
+            return false;
+        }
+        for (auto & item : list) {
+            if (!item || !item->isSinglePrecision()) {
+                return false;
+            }
+        }
+
+        head(g_cborTag, g_tagFloat32LittleEndian);
+        head(g_cborBytes, list.size() * sizeof(float));
+        for (auto & item : list) {
+            uint32_t bits = std::bit_cast<uint32_t>(static_cast<float>(item->doubleValue()));
+            for (int i = 0; i < 4; ++i) {
+                _out.push_back(static_cast<Byte>(bits >> (i * 8)));
+            }
+        }
+        return true;
+    }
+};
+
+class JsonCborDecoder {
+public:
+    JsonCborDecoder(const Byte* data, size_t size) :_data(data), _size(size) {}
+
+    std::shared_ptr<JsonNode> decode(int depth) {
+        if (depth > static_cast<int>(JsonMaxDepth)) {
+            throw std::logic_error("CBOR: maximum nesting depth exceeded");
+        }
+        uint8_t initial = byte();
+        uint8_t major = initial >> 5;
+        uint8_t info = initial & 0x1F;
+
+        if (major == g_cborSimple) {
+            return decodeSimple(info);
+        }
+
+        uint64_t value = argument(info);
+        switch (major) {
+        case g_cborUnsigned:
+            if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                return std::make_shared<JsonNode>(static_cast<double>(value));
+            }
+            return std::make_shared<JsonNode>(static_cast<int64_t>(value));
+        case g_cborNegative:
+            if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                return std::make_shared<JsonNode>(-1.0 - static_cast<double>(value));
+            }
+            return std::make_shared<JsonNode>(-1 - static_cast<int64_t>(value));
+        case g_cborBytes:
+            throw std::logic_error("CBOR: byte strings are only supported as typed arrays");
+        case g_cborText: {
+            const Byte* str = take(value);
+            return std::make_shared<JsonNode>(std::string(reinterpret_cast<const char*>(str), static_cast<size_t>(value)));
+        }
+        case g_cborArray: {
+            JsonList list;
+            // Each item takes at least one byte, so a corrupt length can not reserve more than the input size
+            list.reserve(static_cast<size_t>(std::min<uint64_t>(value, _size - _pos)));
+            for (uint64_t i = 0; i < value; ++i) {
+                list.push_back(decode(depth + 1));
+            }
+            return std::make_shared<JsonNode>(std::move(list));
+        }
+        case g_cborMap: {
+            JsonObject object;
+            for (uint64_t i = 0; i < value; ++i) {
+                uint8_t keyHead = byte();
+                if ((keyHead >> 5) != g_cborText) {
+                    throw std::logic_error("CBOR: map keys must be text strings");
+                }
+                uint64_t keySize = argument(keyHead & 0x1F);
+                const Byte* key = take(keySize);
+                object[_keys.intern(std::string_view(reinterpret_cast<const char*>(key), static_cast<size_t>(keySize)))] = decode(depth + 1);
+            }
+            return std::make_shared<JsonNode>(std::move(object));
+        }
+        case g_cborTag:
+        default:
+            if (value == g_tagFloat32LittleEndian || value == g_tagFloat32BigEndian ||
+                value == g_tagFloat64LittleEndian || value == g_tagFloat64BigEndian ||
+                value == g_tagInt32LittleEndian || value == g_tagInt32BigEndian)
+            {
+                return decodeTypedArray(value);
+            }
+            // Other tags do not change the JSON value
+            return decode(depth + 1);
+        }
+    }
+
+    inline bool atEnd() const { return _pos == _size; }
+
+protected:
+    const Byte* _data;
+    size_t _size;
+    size_t _pos = 0;
+    JsonKeyTable _keys;
+
+    inline uint8_t byte() {
+        return *take(1);
+    }
+
+    const Byte* take(uint64_t count) {
+        if (count > _size - _pos) {
+            throw std::logic_error("CBOR: unexpected end of data");
+        }
+        const Byte* result = _data + _pos;
+        _pos += static_cast<size_t>(count);
+        return result;
+    }
+
+    uint64_t bigEndian(int bytes) {
+        const Byte* data = take(bytes);
+        uint64_t result = 0;
+        for (int i = 0; i < bytes; ++i) {
+            result = (result << 8) | data[i];
+        }
+        return result;
+    }
+
+    uint64_t argument(uint8_t info) {
+        if (info < 24) {
+            return info;
+        }
+        switch (info) {
+        case 24: return bigEndian(1);
+        case 25: return bigEndian(2);
+        case 26: return bigEndian(4);
+        case 27: return bigEndian(8);
+        case 31: throw std::logic_error("CBOR: indefinite length items are not supported");
+        default: throw std::logic_error("CBOR: invalid additional information");
+        }
+    }
+
+    static double halfToDouble(uint16_t half) {
+        int exponent = (half >> 10) & 0x1F;
+        int mantissa = half & 0x3FF;
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        }
+        else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        }
+        else {
+            value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return (half & 0x8000) ? -value : value;
+    }
+
+    std::shared_ptr<JsonNode> decodeSimple(uint8_t info) {
+        switch (info) {
+        case 20: return std::make_shared<JsonNode>(false);
+        case 21: return std::make_shared<JsonNode>(true);
+        case 22:
+        case 23: return std::make_shared<JsonNode>();
+        case 25: return std::make_shared<JsonNode>(halfToDouble(static_cast<uint16_t>(bigEndian(2))));
+        case 26: return std::make_shared<JsonNode>(std::bit_cast<float>(static_cast<uint32_t>(bigEndian(4))));
+        case 27: return std::make_shared<JsonNode>(std::bit_cast<double>(bigEndian(8)));
+        default: throw std::logic_error("CBOR: unsupported simple value");
+        }
+    }
+
+    // Float32 and int32 arrays are decoded into packed array nodes
+    template <typename T>
+    std::shared_ptr<JsonNode> decodeItems(const Byte* blob, size_t count, bool littleEndian) {
+        std::vector<T> values(count);
+        if (count > 0) {
+            std::memcpy(values.data(), blob, count * sizeof(T));
+        }
+        if (littleEndian != (std::endian::native == std::endian::little)) {
+            swapItems<T>(reinterpret_cast<Byte*>(values.data()), count);
+        }
+        if constexpr (std::is_same_v<T, double>) {
+            JsonList list;
+            list.reserve(count);
+            for (auto v : values) {
+                list.push_back(std::make_shared<JsonNode>(v));
+            }
+            return std::make_shared<JsonNode>(std::move(list));
+        }
+        else {
+            return std::make_shared<JsonNode>(std::move(values));
+        }
+    }
+
+    std::shared_ptr<JsonNode> decodeTypedArray(uint64_t tag) {
+        uint8_t blobHead = byte();
+        if ((blobHead >> 5) != g_cborBytes) {
+            throw std::logic_error("CBOR: typed array tag without byte string");
+        }
+        uint64_t size = argument(blobHead & 0x1F);
+        const Byte* blob = take(size);
+        bool littleEndian = tag == g_tagFloat32LittleEndian || tag == g_tagFloat64LittleEndian || tag == g_tagInt32LittleEndian;
+        size_t itemSize = (tag == g_tagFloat64LittleEndian || tag == g_tagFloat64BigEndian) ? sizeof(double) : sizeof(float);
+        if (size % itemSize != 0) {
+            throw std::logic_error("CBOR: invalid typed array size");
+        }
+        size_t count = static_cast<size_t>(size / itemSize);
+        if (tag == g_tagFloat32LittleEndian || tag == g_tagFloat32BigEndian) {
+            return decodeItems<float>(blob, count, littleEndian);
+        }
+        else if (tag == g_tagInt32LittleEndian || tag == g_tagInt32BigEndian) {
+            return decodeItems<int32_t>(blob, count, littleEndian);
+        }
+        return decodeItems<double>(blob, count, littleEndian);
+    }
+};
+
+void encodeJsonCbor(JsonNode& node, std::vector<Byte>& result)
+{
+    JsonCborEncoder encoder(result);
+    encoder.encode(node);
+}
+
+std::vector<Byte> encodeJsonCbor(JsonNode& node)
+{
+    std::vector<Byte> result;
+    encodeJsonCbor(node, result);
+    return result;
+}
+
+std::shared_ptr<JsonNode> decodeJsonCbor(const Byte* data, size_t size)
+{
+    JsonCborDecoder decoder(data, size);
+    auto result = decoder.decode(0);
+    if (!decoder.atEnd()) {
+        throw std::logic_error("CBOR: unexpected data after the root item");
+    }
+    return result;
+}
+
+}
+}
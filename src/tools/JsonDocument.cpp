@@ -0,0 +1,461 @@
+
+#include <bg2e/tools/JsonDocument.hpp>
+#include <bg2e/tools/JsonToken.hpp>
+#include <bg2e/tools/JsonStructuralIndex.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+
+#include <vector>
+#include <cstring>
+
+namespace bg2e {
+namespace tools {
+
+JsonView JsonListView::Iterator::operator*() const {
+    return JsonView(_document, _node);
+}
+
+JsonView JsonListView::operator[](size_t index) const {
+    if (index >= _size) {
+        throw std::out_of_range("JsonListView: index out of range");
+    }
+    return JsonView(_document, _first + index);
+}
+
+std::pair<std::string_view, JsonView> JsonObjectView::Iterator::operator*() const {
+    std::string_view key(_document->strings() + _node->offset, _node->size);
+    return std::make_pair(key, JsonView(_document, _node + 1));
+}
+
+JsonView JsonObjectView::operator[](std::string_view key) const {
+    const JsonDocumentNode* keyNode = _first;
+    const JsonDocumentNode* end = _first + _size * 2;
+    const char* strings = _size > 0 ? _document->strings() : nullptr;
+    for (; keyNode != end; keyNode += 2) {
+        if (keyNode->size == key.size() && std::memcmp(strings + keyNode->offset, key.data(), key.size()) == 0) {
+            return JsonView(_document, keyNode + 1);
+        }
+    }
+    return JsonView();
+}
+
+bool JsonObjectView::contains(std::string_view key) const {
+    return (*this)[key].isValid();
+}
+
+JsonObjectView JsonView::objectValue() const {
+    if (isObject()) {
+        return JsonObjectView(_document, _document->nodes() + _node->offset, _node->size);
+    }
+    throw std::logic_error("Improper return type: object");
+}
+
+JsonObjectView JsonView::objectValue(JsonObjectView defaultValue) const {
+    return isObject() ? objectValue() : defaultValue;
+}
+
+JsonListView JsonView::listValue() const {
+    if (isList()) {
+        return JsonListView(_document, _document->nodes() + _node->offset, _node->size);
+    }
+    throw std::logic_error("Improper return type: list");
+}
+
+JsonListView JsonView::listValue(JsonListView defaultValue) const {
+    return isList() ? listValue() : defaultValue;
+}
+
+JsonView JsonView::operator[](std::string_view key) const {
+    if (isObject()) {
+        return objectValue()[key];
+    }
+    return JsonView();
+}
+
+JsonView JsonView::operator[](size_t index) const {
+    if (isList() && index < _node->size) {
+        return JsonView(_document, _document->nodes() + _node->offset + index);
+    }
+    return JsonView();
+}
+
+std::string_view JsonView::stringValue() const {
+    if (isString()) {
+        return std::string_view(_document->strings() + _node->offset, _node->size);
+    }
+    throw std::logic_error("Improper return type: string");
+}
+
+std::string_view JsonView::stringValue(std::string_view defaultValue) const {
+    return isString() ? stringValue() : defaultValue;
+}
+
+void JsonView::readFloats(float* result, uint32_t count) const {
+    const JsonDocumentNode* items = _document->nodes() + _node->offset;
+    for (uint32_t i = 0; i < count; ++i) {
+        result[i] = items[i].type == JsonDocumentNodeType::Number ? static_cast<float>(numberOf(items + i)) : 0.0f;
+    }
+}
+
+glm::vec2 JsonView::vec2Value(const glm::vec2& defaultValue) const {
+    if (isList() && _node->size >= 2) {
+        glm::vec2 result;
+        readFloats(&result.x, 2);
+        return result;
+    }
+    return defaultValue;
+}
+
+glm::vec3 JsonView::vec3Value(const glm::vec3& defaultValue) const {
+    if (isList() && _node->size >= 3) {
+        glm::vec3 result;
+        readFloats(&result.x, 3);
+        return result;
+    }
+    return defaultValue;
+}
+
+glm::vec4 JsonView::vec4Value(const glm::vec4& defaultValue) const {
+    if (isList() && _node->size >= 4) {
+        glm::vec4 result;
+        readFloats(&result.x, 4);
+        return result;
+    }
+    return defaultValue;
+}
+
+glm::mat4 JsonView::mat4Value(const glm::mat4& defaultValue) const {
+    if (isList() && _node->size >= 16) {
+        // Same element order as JsonNode::mat4Value
+        glm::mat4 result;
+        readFloats(&result[0][0], 16);
+        return result;
+    }
+    return defaultValue;
+}
+
+std::shared_ptr<JsonNode> JsonView::toNode() const {
+    JsonKeyTable keys;
+    return toNode(keys);
+}
+
+std::shared_ptr<JsonNode> JsonView::toNode(JsonKeyTable& keys) const {
+    switch (type()) {
+    case JsonDocumentNodeType::Object: {
+        JsonObject object;
+        for (auto item : objectValue()) {
+            object[keys.intern(item.first)] = item.second.toNode(keys);
+        }
+        return JSON(std::move(object));
+    }
+    case JsonDocumentNodeType::List: {
+        // Lists of numbers are stored in a packed array
+        JsonNumberListBuilder numbers;
+        for (auto item : listValue()) {
+            if (!item.isNumber()) {
+                break;
+            }
+            if (item.isInteger()) {
+                numbers.add(item.int64Value());
+            }
+            else {
+                numbers.add(item.doubleValue());
+            }
+        }
+        if (numbers.size() > 0 && numbers.size() == _node->size) {
+            return numbers.node();
+        }
+        JsonList list;
+        list.reserve(_node->size);
+        for (auto item : listValue()) {
+            list.push_back(item.toNode(keys));
+        }
+        return JSON(std::move(list));
+    }
+    case JsonDocumentNodeType::String:
+        return JSON(std::string(stringValue()));
+    case JsonDocumentNodeType::Number:
+        return isInteger() ? JSON(_node->integer) : JSON(_node->number);
+    case JsonDocumentNodeType::Bool:
+        return JSON(_node->boolean);
+    case JsonDocumentNodeType::Null:
+    default:
+        return std::make_shared<JsonNode>();
+    }
+}
+
+// Builds the document in post order: the children of a container are kept in a scratch
+// stack until the container is closed, and then copied to a contiguous block in the arena
+template <typename Tokenizer>
+class JsonDocumentBuilder {
+public:
+    JsonDocumentBuilder(Tokenizer& tokenizer, JsonDocumentNode* nodes, char* strings)
+        :_tokenizer(tokenizer), _nodes(nodes), _strings(strings)
+    {
+        _stack.reserve(64);
+    }
+
+    size_t build() {
+        parseValue(_tokenizer.getToken());
+        if (_tokenizer.hasMoreTokens()) {
+            throw std::logic_error("Unexpected token after the root element at position " + std::to_string(_tokenizer.position()));
+        }
+        _nodes[_nodeCount] = _stack.back();
+        return _nodeCount++;
+    }
+
+    inline size_t nodeCount() const { return _nodeCount; }
+    inline size_t stringSize() const { return _stringSize; }
+
+protected:
+    Tokenizer& _tokenizer;
+    JsonDocumentNode* _nodes;
+    char* _strings;
+    size_t _nodeCount = 0;
+    size_t _stringSize = 0;
+    size_t _depth = 0;
+    std::vector<JsonDocumentNode> _stack;
+    std::string _unescaped;
+
+    void pushString(const JsonTokenView& token) {
+        JsonDocumentNode node;
+        node.type = JsonDocumentNodeType::String;
+        node.offset = _stringSize;
+        if (token.escaped) {
+            _unescaped.clear();
+            unescapeJsonString(token.value, _unescaped);
+            std::memcpy(_strings + _stringSize, _unescaped.data(), _unescaped.size());
+            node.size = static_cast<uint32_t>(_unescaped.size());
+        }
+        else {
+            std::memcpy(_strings + _stringSize, token.value.data(), token.value.size());
+            node.size = static_cast<uint32_t>(token.value.size());
+        }
+        _stringSize += node.size;
+        _stack.push_back(node);
+    }
+
+    void closeContainer(JsonDocumentNodeType type, size_t start, uint32_t size) {
+        JsonDocumentNode node;
+        node.type = type;
+        node.size = size;
+        node.offset = _nodeCount;
+        size_t count = _stack.size() - start;
+        if (count > 0) {
+            std::memcpy(_nodes + _nodeCount, _stack.data() + start, count * sizeof(JsonDocumentNode));
+        }
+        _nodeCount += count;
+        _stack.resize(start);
+        _stack.push_back(node);
+    }
+
+    void parseValue(const JsonTokenView& token) {
+        JsonDocumentNode node;
+        switch (token.type) {
+        case JsonTokenType::CurlyOpen:
+            parseObject();
+            return;
+        case JsonTokenType::ListOpen:
+            parseList();
+            return;
+        case JsonTokenType::String:
+            pushString(token);
+            return;
+        case JsonTokenType::Number: {
+            JsonNumber number = parseJsonNumber(token.value);
+            node.type = JsonDocumentNodeType::Number;
+            if (number.isInteger) {
+                node.flags = JsonDocumentNode::FlagInteger;
+                node.integer = number.integerValue;
+            }
+            else {
+                node.number = number.doubleValue;
+            }
+            break;
+        }
+        case JsonTokenType::Boolean:
+            node.type = JsonDocumentNodeType::Bool;
+            node.boolean = token.value == "true";
+            break;
+        case JsonTokenType::NullType:
+            node.type = JsonDocumentNodeType::Null;
+            break;
+        default:
+            throw std::logic_error("Unexpected token at position " + std::to_string(_tokenizer.position()));
+        }
+        _stack.push_back(node);
+    }
+
+    void parseObject() {
+        checkJsonDepth(++_depth);
+        size_t start = _stack.size();
+        uint32_t size = 0;
+        if (_tokenizer.peekToken().type == JsonTokenType::CurlyClose) {
+            _tokenizer.getToken();
+        }
+        else {
+            while (true) {
+                JsonTokenView keyToken = _tokenizer.getToken();
+                if (keyToken.type != JsonTokenType::String) {
+                    throw std::logic_error("Expected object key at position " + std::to_string(_tokenizer.position()));
+                }
+                if (_tokenizer.getToken().type != JsonTokenType::Colon) {
+                    throw std::logic_error("Expected ':' at position " + std::to_string(_tokenizer.position()));
+                }
+                pushString(keyToken);
+                parseValue(_tokenizer.getToken());
+                ++size;
+
+                JsonTokenType next = _tokenizer.getToken().type;
+                if (next == JsonTokenType::CurlyClose) {
+                    break;
+                }
+                else if (next != JsonTokenType::Comma) {
+                    throw std::logic_error("Expected ',' or '}' at position " + std::to_string(_tokenizer.position()));
+                }
+            }
+        }
+        closeContainer(JsonDocumentNodeType::Object, start, size);
+        --_depth;
+    }
+
+    void parseList() {
+        checkJsonDepth(++_depth);
+        size_t start = _stack.size();
+        uint32_t size = 0;
+        if (_tokenizer.peekToken().type == JsonTokenType::ListClose) {
+            _tokenizer.getToken();
+        }
+        else {
+            while (true) {
+                parseValue(_tokenizer.getToken());
+                ++size;
+
+                JsonTokenType next = _tokenizer.getToken().type;
+                if (next == JsonTokenType::ListClose) {
+                    break;
+                }
+                else if (next != JsonTokenType::Comma) {
+                    throw std::logic_error("Expected ',' or ']' at position " + std::to_string(_tokenizer.position()));
+                }
+            }
+        }
+        closeContainer(JsonDocumentNodeType::List, start, size);
+        --_depth;
+    }
+};
+
+JsonDocument::JsonDocument()
+{
+
+}
+
+JsonDocument::JsonDocument(std::string_view buffer)
+{
+    parse(buffer);
+}
+
+JsonDocument::~JsonDocument()
+{
+
+}
+
+JsonDocument::JsonDocument(JsonDocument&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+JsonDocument& JsonDocument::operator=(JsonDocument&& other) noexcept
+{
+    if (this != &other) {
+        _arena = std::move(other._arena);
+        _arenaSize = other._arenaSize;
+        _nodeCount = other._nodeCount;
+        _rootIndex = other._rootIndex;
+        _stringsOffset = other._stringsOffset;
+        other.clear();
+    }
+    return *this;
+}
+
+void JsonDocument::parse(std::string_view buffer, JsonParseMode mode)
+{
+    clear();
+
+    if (mode == JsonParseMode::StructuralIndex || mode == JsonParseMode::Parallel ||
+        (mode == JsonParseMode::Automatic && buffer.size() > JsonStructuralIndex::AutomaticThreshold))
+    {
+        // The structural index already contains the node count and the string size
+        JsonStructuralIndex index(buffer);
+        JsonIndexedTokenizer tokenizer(buffer, index);
+        build(tokenizer, index.valueCount(), index.stringBytes());
+        return;
+    }
+
+    // First pass: count the nodes and string bytes, so that the whole document fits
+    // in a single allocation
+    size_t nodeCount = 0;
+    size_t stringBytes = 0;
+    JsonBufferTokenizer counter(buffer);
+    while (counter.hasMoreTokens()) {
+        JsonTokenView token = counter.getToken();
+        switch (token.type) {
+        case JsonTokenType::String:
+            stringBytes += token.value.size();
+            ++nodeCount;
+            break;
+        case JsonTokenType::CurlyOpen:
+        case JsonTokenType::ListOpen:
+        case JsonTokenType::Number:
+        case JsonTokenType::Boolean:
+        case JsonTokenType::NullType:
+            ++nodeCount;
+            break;
+        default:
+            break;
+        }
+    }
+
+    JsonBufferTokenizer tokenizer(buffer);
+    build(tokenizer, nodeCount, stringBytes);
+}
+
+template <typename Tokenizer>
+void JsonDocument::build(Tokenizer& tokenizer, size_t nodeCount, size_t stringBytes)
+{
+    if (nodeCount == 0) {
+        throw std::logic_error("Empty JSON document");
+    }
+
+    size_t stringsOffset = nodeCount * sizeof(JsonDocumentNode);
+    size_t arenaSize = stringsOffset + stringBytes;
+    std::unique_ptr<Byte[]> arena(new Byte[arenaSize]);
+
+    JsonDocumentBuilder<Tokenizer> builder(tokenizer,
+        reinterpret_cast<JsonDocumentNode*>(arena.get()),
+        reinterpret_cast<char*>(arena.get() + stringsOffset));
+    size_t rootIndex = builder.build();
+
+    _arena = std::move(arena);
+    _arenaSize = arenaSize;
+    _nodeCount = builder.nodeCount();
+    _rootIndex = rootIndex;
+    _stringsOffset = stringsOffset;
+}
+
+void JsonDocument::parseFile(const std::string& path, JsonParseMode mode)
+{
+    MappedFile file(path);
+    parse(file.view(), mode);
+}
+
+void JsonDocument::clear()
+{
+    _arena.reset();
+    _arenaSize = 0;
+    _nodeCount = 0;
+    _rootIndex = 0;
+    _stringsOffset = 0;
+}
+
+}
+}
@@ -0,0 +1,183 @@
+
+#include <bg2e/tools/JsonIncrementalParser.hpp>
+#include <bg2e/tools/JsonParser.hpp>
+
+#include <stdexcept>
+
+namespace bg2e {
+namespace tools {
+
+JsonIncrementalParser::JsonIncrementalParser(ElementHandler handler, JsonStreamMode mode)
+    :_handler(std::move(handler))
+    ,_mode(mode)
+{
+
+}
+
+void JsonIncrementalParser::feed(std::string_view data)
+{
+    _buffer.append(data);
+    const char* buffer = _buffer.data();
+    size_t size = _buffer.size();
+    for (size_t i = _scanPos; i < size; ++i) {
+        char c = buffer[i];
+        if (_inString) {
+            if (_escape) {
+                _escape = false;
+            }
+            else if (c == '\\') {
+                _escape = true;
+            }
+            else if (c == '"') {
+                _inString = false;
+                if (_depth == 0) {
+                    completeElement(i + 1);
+                }
+            }
+            continue;
+        }
+
+        if (_scalar) {
+            // Numbers and literals end at whitespace or at a structural character
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r' &&
+                c != ',' && c != ':' && c != ']' && c != '}' && c != '[' && c != '{' && c != '"')
+            {
+                continue;
+            }
+            completeElement(i);
+        }
+
+        switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            break;
+        case '"':
+            if (!inElement()) {
+                startElement(i);
+            }
+            _inString = true;
+            break;
+        case '{':
+        case '[':
+            if (!inElement()) {
+                if (_mode == JsonStreamMode::ListItems && _listState == ListState::BeforeList && c == '[') {
+                    _listState = ListState::BeforeFirstItem;
+                    break;
+                }
+                startElement(i);
+            }
+            checkJsonDepth(++_depth);
+            break;
+        case '}':
+        case ']':
+            if (_depth > 0) {
+                // Mismatched brackets are reported by the element parser
+                if (--_depth == 0) {
+                    completeElement(i + 1);
+                }
+            }
+            else {
+                separator(c, i);
+            }
+            break;
+        case ',':
+        case ':':
+            if (_depth == 0) {
+                separator(c, i);
+            }
+            break;
+        default:
+            if (!inElement()) {
+                startElement(i);
+                _scalar = true;
+            }
+            break;
+        }
+    }
+
+    // Only the incomplete element is kept for the next call
+    size_t keep = inElement() ? _elementStart : size;
+    _buffer.erase(0, keep);
+    _bufferOffset += keep;
+    if (inElement()) {
+        _elementStart = 0;
+    }
+    _scanPos = _buffer.size();
+}
+
+void JsonIncrementalParser::finish()
+{
+    if (_scalar) {
+        completeElement(_buffer.size());
+        _buffer.clear();
+        _scanPos = 0;
+    }
+    if (inElement() || _inString) {
+        throw std::logic_error("Unexpected end of JSON data at position " + std::to_string(_bufferOffset + _buffer.size()));
+    }
+    if (_mode == JsonStreamMode::ListItems && _listState != ListState::AfterList) {
+        throw std::logic_error("Unexpected end of JSON list at position " + std::to_string(_bufferOffset + _buffer.size()));
+    }
+}
+
+void JsonIncrementalParser::reset()
+{
+    _buffer.clear();
+    _bufferOffset = 0;
+    _scanPos = 0;
+    _elementStart = std::string::npos;
+    _depth = 0;
+    _inString = false;
+    _escape = false;
+    _scalar = false;
+    _listState = ListState::BeforeList;
+    _elementCount = 0;
+}
+
+void JsonIncrementalParser::startElement(size_t pos)
+{
+    if (_mode == JsonStreamMode::ListItems) {
+        switch (_listState) {
+        case ListState::BeforeList:
+            throw std::logic_error("Expected '[' at position " + std::to_string(_bufferOffset + pos));
+        case ListState::AfterItem:
+            throw std::logic_error("Expected ',' or ']' at position " + std::to_string(_bufferOffset + pos));
+        case ListState::AfterList:
+            throw std::logic_error("Unexpected data after the list at position " + std::to_string(_bufferOffset + pos));
+        default:
+            break;
+        }
+    }
+    _elementStart = pos;
+}
+
+void JsonIncrementalParser::completeElement(size_t end)
+{
+    JsonParser parser;
+    auto element = parser.parse(std::string_view(_buffer.data() + _elementStart, end - _elementStart), JsonParseMode::Tokenizer);
+    _elementStart = std::string::npos;
+    _scalar = false;
+    _listState = ListState::AfterItem;
+    ++_elementCount;
+    _handler(element);
+}
+
+void JsonIncrementalParser::separator(char c, size_t pos)
+{
+    if (_mode == JsonStreamMode::ListItems) {
+        if (c == ',' && _listState == ListState::AfterItem) {
+            _listState = ListState::BeforeItem;
+            return;
+        }
+        else if (c == ']' && (_listState == ListState::AfterItem || _listState == ListState::BeforeFirstItem)) {
+            _listState = ListState::AfterList;
+            return;
+        }
+    }
+    throw std::logic_error(std::string("Unexpected '") + c + "' at position " + std::to_string(_bufferOffset + pos));
+}
+
+}
+}
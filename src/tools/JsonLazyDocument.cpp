@@ -0,0 +1,439 @@
+
+#include <bg2e/tools/JsonLazyDocument.hpp>
+
+#include <stdexcept>
+
+namespace bg2e {
+namespace tools {
+
+bool JsonLazyValue::isObject() const {
+    return isValid() && _document->entryChar(_entry) == '{';
+}
+
+bool JsonLazyValue::isList() const {
+    return isValid() && _document->entryChar(_entry) == '[';
+}
+
+bool JsonLazyValue::isString() const {
+    return isValid() && _document->entryChar(_entry) == '"';
+}
+
+bool JsonLazyValue::isNumber() const {
+    if (!isValid()) {
+        return false;
+    }
+    char c = _document->entryChar(_entry);
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+bool JsonLazyValue::isBool() const {
+    if (!isValid()) {
+        return false;
+    }
+    char c = _document->entryChar(_entry);
+    return c == 't' || c == 'f';
+}
+
+bool JsonLazyValue::isNull() const {
+    return !isValid() || _document->entryChar(_entry) == 'n';
+}
+
+size_t JsonLazyValue::size() const {
+    if (!isObject() && !isList()) {
+        return 0;
+    }
+    bool object = isObject();
+    uint32_t end = _document->_closeEntry[_entry];
+    uint32_t entry = _entry + 1;
+    size_t result = 0;
+    while (entry < end) {
+        // Object members are key, colon and value
+        entry = _document->skipValue(object ? entry + 2 : entry);
+        ++result;
+        if (entry < end) {
+            ++entry;
+        }
+    }
+    return result;
+}
+
+JsonLazyValue JsonLazyValue::operator[](std::string_view key) const {
+    if (!isObject()) {
+        return JsonLazyValue();
+    }
+    uint32_t end = _document->_closeEntry[_entry];
+    uint32_t entry = _entry + 1;
+    std::string unescaped;
+    while (entry < end) {
+        JsonTokenView keyToken = _document->token(entry);
+        bool found = false;
+        if (keyToken.escaped) {
+            unescaped.clear();
+            unescapeJsonString(keyToken.value, unescaped);
+            found = unescaped == key;
+        }
+        else {
+            found = keyToken.value == key;
+        }
+        if (found) {
+            return JsonLazyValue(_document, entry + 2);
+        }
+        entry = _document->skipValue(entry + 2) + 1;
+    }
+    return JsonLazyValue();
+}
+
+JsonLazyValue JsonLazyValue::operator[](size_t index) const {
+    if (!isList()) {
+        return JsonLazyValue();
+    }
+    uint32_t end = _document->_closeEntry[_entry];
+    uint32_t entry = _entry + 1;
+    for (size_t i = 0; entry < end; ++i) {
+        if (i == index) {
+            return JsonLazyValue(_document, entry);
+        }
+        entry = _document->skipValue(entry) + 1;
+    }
+    return JsonLazyValue();
+}
+
+JsonLazyValue JsonLazyValue::find(std::string_view pointer) const {
+    JsonLazyValue current = *this;
+    std::string referenceToken;
+    while (!pointer.empty() && current.isValid()) {
+        if (pointer[0] != '/') {
+            throw std::logic_error("Invalid JSON Pointer: '" + std::string(pointer) + "'");
+        }
+        pointer.remove_prefix(1);
+        size_t separator = pointer.find('/');
+        std::string_view token = pointer.substr(0, separator);
+        pointer = separator == std::string_view::npos ? std::string_view() : pointer.substr(separator);
+
+        // Escape sequences: "~1" is '/' and "~0" is '~'
+        referenceToken.clear();
+        for (size_t i = 0; i < token.size(); ++i) {
+            if (token[i] == '~' && i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1')) {
+                referenceToken += token[i + 1] == '0' ? '~' : '/';
+                ++i;
+            }
+            else {
+                referenceToken += token[i];
+            }
+        }
+
+        if (current.isObject()) {
+            current = current[referenceToken];
+        }
+        else if (current.isList()) {
+            // Array indexes are decimal numbers without leading zeros
+            bool validIndex = !referenceToken.empty() && (referenceToken.size() == 1 || referenceToken[0] != '0');
+            size_t index = 0;
+            for (char c : referenceToken) {
+                validIndex = validIndex && c >= '0' && c <= '9';
+                index = index * 10 + static_cast<size_t>(c - '0');
+            }
+            current = validIndex ? current[index] : JsonLazyValue();
+        }
+        else {
+            current = JsonLazyValue();
+        }
+    }
+    return current;
+}
+
+std::shared_ptr<JsonNode> JsonLazyValue::node() const {
+    return isValid() ? _document->cachedNode(_entry)->clone() : nullptr;
+}
+
+std::string JsonLazyValue::stringValue(const std::string& defaultValue) const {
+    if (!isString()) {
+        return defaultValue;
+    }
+    JsonTokenView stringToken = _document->token(_entry);
+    return stringToken.stringValue();
+}
+
+float JsonLazyValue::numberValue(float defaultValue) const {
+    return isNumber() ? static_cast<float>(parseJsonNumber(_document->token(_entry).value).doubleValue) : defaultValue;
+}
+
+double JsonLazyValue::numberValue(double defaultValue) const {
+    return isNumber() ? parseJsonNumber(_document->token(_entry).value).doubleValue : defaultValue;
+}
+
+static int64_t integerValue(const JsonNumber& number) {
+    return number.isInteger ? number.integerValue : static_cast<int64_t>(number.doubleValue);
+}
+
+int32_t JsonLazyValue::intValue(int32_t defaultValue) const {
+    return isNumber() ? static_cast<int32_t>(integerValue(parseJsonNumber(_document->token(_entry).value))) : defaultValue;
+}
+
+uint32_t JsonLazyValue::uintValue(uint32_t defaultValue) const {
+    return isNumber() ? static_cast<uint32_t>(integerValue(parseJsonNumber(_document->token(_entry).value))) : defaultValue;
+}
+
+bool JsonLazyValue::boolValue(bool defaultValue) const {
+    return isBool() ? _document->entryChar(_entry) == 't' : defaultValue;
+}
+
+glm::vec2 JsonLazyValue::vec2Value(const glm::vec2& defaultValue) const {
+    return isList() ? _document->cachedNode(_entry)->vec2Value(defaultValue) : defaultValue;
+}
+
+glm::vec3 JsonLazyValue::vec3Value(const glm::vec3& defaultValue) const {
+    return isList() ? _document->cachedNode(_entry)->vec3Value(defaultValue) : defaultValue;
+}
+
+glm::vec4 JsonLazyValue::vec4Value(const glm::vec4& defaultValue) const {
+    return isList() ? _document->cachedNode(_entry)->vec4Value(defaultValue) : defaultValue;
+}
+
+glm::mat4 JsonLazyValue::mat4Value(const glm::mat4& defaultValue) const {
+    return isList() ? _document->cachedNode(_entry)->mat4Value(defaultValue) : defaultValue;
+}
+
+JsonLazyDocument::JsonLazyDocument()
+{
+
+}
+
+JsonLazyDocument::~JsonLazyDocument()
+{
+
+}
+
+void JsonLazyDocument::parse(std::string_view buffer)
+{
+    clear();
+    _index.build(buffer);
+    _buffer = buffer;
+    try {
+        validate();
+    }
+    catch (std::logic_error&) {
+        clear();
+        throw;
+    }
+}
+
+void JsonLazyDocument::parseFile(const std::string& path)
+{
+    MappedFile file(path);
+    parse(file.view());
+    _file = std::move(file);
+}
+
+void JsonLazyDocument::clear()
+{
+    _nodeCache.clear();
+    _pointerCache.clear();
+    _keys.clear();
+    _closeEntry.clear();
+    _index = JsonStructuralIndex();
+    _buffer = std::string_view();
+    _file.close();
+}
+
+std::shared_ptr<JsonNode> JsonLazyDocument::at(std::string_view pointer)
+{
+    std::string key(pointer);
+    auto it = _pointerCache.find(key);
+    if (it != _pointerCache.end()) {
+        return it->second->clone();
+    }
+    JsonLazyValue value = root().find(pointer);
+    if (!value.isValid()) {
+        return nullptr;
+    }
+    auto result = cachedNode(value.entry());
+    _pointerCache[key] = result;
+    return result->clone();
+}
+
+std::shared_ptr<JsonNode> JsonLazyDocument::cachedNode(uint32_t entry)
+{
+    auto it = _nodeCache.find(entry);
+    if (it != _nodeCache.end()) {
+        return it->second;
+    }
+    auto result = materialize(entry);
+    _nodeCache[entry] = result;
+    return result;
+}
+
+JsonTokenView JsonLazyDocument::token(uint32_t entry) const
+{
+    JsonIndexedTokenizer tokenizer(_buffer, _index, entry, 1);
+    return tokenizer.getToken();
+}
+
+// Checks the document grammar over the index entries, and stores the closing entry of
+// every container. Numbers are only checked when they are materialized
+void JsonLazyDocument::validate()
+{
+    enum class Expect {
+        Value,
+        ValueOrClose,
+        Key,
+        KeyOrClose,
+        Colon,
+        CommaOrClose,
+        End
+    };
+
+    size_t count = _index.size();
+    if (count == 0) {
+        throw std::logic_error("Empty JSON document");
+    }
+    _closeEntry.assign(count, 0);
+
+    std::vector<uint32_t> stack;
+    JsonIndexedTokenizer tokenizer(_buffer, _index);
+    Expect expect = Expect::Value;
+    auto afterValue = [&]() {
+        expect = stack.empty() ? Expect::End : Expect::CommaOrClose;
+    };
+    auto position = [&](uint32_t entry) {
+        return std::to_string(_index.positions()[entry]);
+    };
+
+    for (uint32_t entry = 0; entry < count; ++entry) {
+        JsonTokenType type = tokenizer.getToken().type;
+        switch (expect) {
+        case Expect::Value:
+        case Expect::ValueOrClose:
+            if (type == JsonTokenType::CurlyOpen) {
+                checkJsonDepth(stack.size() + 1);
+                stack.push_back(entry);
+                expect = Expect::KeyOrClose;
+            }
+            else if (type == JsonTokenType::ListOpen) {
+                checkJsonDepth(stack.size() + 1);
+                stack.push_back(entry);
+                expect = Expect::ValueOrClose;
+            }
+            else if (type == JsonTokenType::ListClose && expect == Expect::ValueOrClose) {
+                _closeEntry[stack.back()] = entry;
+                stack.pop_back();
+                afterValue();
+            }
+            else if (type == JsonTokenType::String || type == JsonTokenType::Number ||
+                     type == JsonTokenType::Boolean || type == JsonTokenType::NullType) {
+                afterValue();
+            }
+            else {
+                throw std::logic_error("Unexpected token at position " + position(entry));
+            }
+            break;
+        case Expect::Key:
+        case Expect::KeyOrClose:
+            if (type == JsonTokenType::String) {
+                expect = Expect::Colon;
+            }
+            else if (type == JsonTokenType::CurlyClose && expect == Expect::KeyOrClose) {
+                _closeEntry[stack.back()] = entry;
+                stack.pop_back();
+                afterValue();
+            }
+            else {
+                throw std::logic_error("Expected object key at position " + position(entry));
+            }
+            break;
+        case Expect::Colon:
+            if (type != JsonTokenType::Colon) {
+                throw std::logic_error("Expected ':' at position " + position(entry));
+            }
+            expect = Expect::Value;
+            break;
+        case Expect::CommaOrClose: {
+            bool object = entryChar(stack.back()) == '{';
+            if (type == JsonTokenType::Comma) {
+                expect = object ? Expect::Key : Expect::Value;
+            }
+            else if (type == (object ? JsonTokenType::CurlyClose : JsonTokenType::ListClose)) {
+                _closeEntry[stack.back()] = entry;
+                stack.pop_back();
+                afterValue();
+            }
+            else {
+                throw std::logic_error(std::string("Expected ',' or '") + (object ? "}" : "]") + "' at position " + position(entry));
+            }
+            break;
+        }
+        case Expect::End:
+            throw std::logic_error("Unexpected token after the root element at position " + position(entry));
+        }
+    }
+
+    if (expect != Expect::End) {
+        throw std::logic_error("Exhaused tokens");
+    }
+}
+
+std::shared_ptr<JsonNode> JsonLazyDocument::materialize(uint32_t entry)
+{
+    char c = entryChar(entry);
+    if (c == '{' || c == '[') {
+        // Subtrees that are already materialized are shared with the cache
+        auto cached = _nodeCache.find(entry);
+        if (cached != _nodeCache.end()) {
+            return cached->second;
+        }
+        uint32_t end = _closeEntry[entry];
+        if (c == '{') {
+            JsonObject object;
+            for (uint32_t child = entry + 1; child < end; child = skipValue(child + 2) + 1) {
+                JsonTokenView key = token(child);
+                object[key.escaped ? _keys.intern(key.stringValue()) : _keys.intern(key.value)] = materialize(child + 2);
+            }
+            return std::make_shared<JsonNode>(std::move(object));
+        }
+        // Lists of numbers are stored in a packed array
+        JsonNumberListBuilder numbers;
+        uint32_t child = entry + 1;
+        for (; child < end; child += 2) {
+            JsonTokenView value = token(child);
+            if (value.type != JsonTokenType::Number) {
+                break;
+            }
+            JsonNumber number = parseJsonNumber(value.value);
+            if (number.isInteger) {
+                numbers.add(number.integerValue);
+            }
+            else {
+                numbers.add(number.doubleValue);
+            }
+        }
+        if (child >= end && numbers.size() > 0) {
+            return numbers.node();
+        }
+        JsonList list;
+        numbers.appendNodes(list);
+        for (; child < end; child = skipValue(child) + 1) {
+            list.push_back(materialize(child));
+        }
+        return std::make_shared<JsonNode>(std::move(list));
+    }
+
+    JsonTokenView value = token(entry);
+    switch (value.type) {
+    case JsonTokenType::String:
+        return std::make_shared<JsonNode>(value.stringValue());
+    case JsonTokenType::Number: {
+        JsonNumber number = parseJsonNumber(value.value);
+        if (number.isInteger) {
+            return std::make_shared<JsonNode>(number.integerValue);
+        }
+        return std::make_shared<JsonNode>(number.doubleValue);
+    }
+    case JsonTokenType::Boolean:
+        return std::make_shared<JsonNode>(value.value == "true");
+    default:
+        return std::make_shared<JsonNode>();
+    }
+}
+
+}
+}
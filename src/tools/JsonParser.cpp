@@ -1,11 +1,17 @@
 
 #include <bg2e/tools/JsonParser.hpp>
+#include <bg2e/tools/MappedFile.hpp>
+#include <bg2e/tools/ThreadPool.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace bg2e {
 namespace tools {
 
 std::shared_ptr<JsonNode> & JsonParser::parse() {
     std::string key = "";
+    depth = 0;
     while (tokenizer.hasMoreTokens()) {
         JsonToken token;
         try {
@@ -58,6 +64,7 @@ std::shared_ptr<JsonNode> & JsonParser::parse() {
 }
 
 std::shared_ptr<JsonNode> JsonParser::parseObject() {
+    checkJsonDepth(++depth);
     std::shared_ptr<JsonNode> node = std::make_shared<JsonNode>();
     JsonObject keyObjectMap;
     bool hasCompleted = false;
@@ -114,6 +121,7 @@ std::shared_ptr<JsonNode> JsonParser::parseObject() {
         }
     }
     node->setValue(keyObjectMap);
+    --depth;
     return node;
 }
 
@@ -128,13 +136,18 @@ std::shared_ptr<JsonNode> JsonParser::parseString() {
 std::shared_ptr<JsonNode> JsonParser::parseNumber() {
     std::shared_ptr<JsonNode> node = std::make_shared<JsonNode>();
     JsonToken nextToken = tokenizer.getToken();
-    std::string value = nextToken.value;
-    float fValue = std::stof(value);
-    node->setValue(fValue);
+    JsonNumber number = parseJsonNumber(nextToken.value);
+    if (number.isInteger) {
+        node->setValue(number.integerValue);
+    }
+    else {
+        node->setValue(number.doubleValue);
+    }
     return node;
 }
 
 std::shared_ptr<JsonNode> JsonParser::parseList() {
+    checkJsonDepth(++depth);
     std::shared_ptr<JsonNode> node = std::make_shared<JsonNode>();
     JsonList list;
     bool hasCompleted = false;
@@ -187,6 +200,7 @@ std::shared_ptr<JsonNode> JsonParser::parseList() {
         }
     }
     node->setValue(list);
+    --depth;
     return node;
 }
 
@@ -203,5 +217,254 @@ std::shared_ptr<JsonNode> JsonParser::parseNull() {
     return node;
 }
 
+std::shared_ptr<JsonNode> JsonParser::parse(std::string_view buffer, JsonParseMode mode) {
+    if (mode == JsonParseMode::Parallel ||
+        (mode == JsonParseMode::Automatic && buffer.size() > ParallelThreshold))
+    {
+        JsonStructuralIndex index(buffer);
+        return parseParallel(buffer, index);
+    }
+    if (mode == JsonParseMode::StructuralIndex ||
+        (mode == JsonParseMode::Automatic && buffer.size() > JsonStructuralIndex::AutomaticThreshold))
+    {
+        JsonStructuralIndex index(buffer);
+        JsonIndexedTokenizer indexedTokenizer(buffer, index);
+        return parseBuffer(indexedTokenizer);
+    }
+    JsonBufferTokenizer bufferTokenizer(buffer);
+    return parseBuffer(bufferTokenizer);
+}
+
+std::shared_ptr<JsonNode> JsonParser::parseFile(const std::string& path, JsonParseMode mode) {
+    MappedFile file(path);
+    return parse(file.view(), mode);
+}
+
+template <typename Tokenizer>
+std::shared_ptr<JsonNode> JsonParser::parseBuffer(Tokenizer& bufferTokenizer) {
+    if (!bufferTokenizer.hasMoreTokens()) {
+        throw std::logic_error("Empty JSON document");
+    }
+    JsonKeyTable keys;
+    root = parseValue(bufferTokenizer, keys, 0);
+    if (bufferTokenizer.hasMoreTokens()) {
+        throw std::logic_error("Unexpected token after the root element at position " + std::to_string(bufferTokenizer.position()));
+    }
+    return root;
+}
+
+std::shared_ptr<JsonNode> JsonParser::parseParallel(std::string_view buffer, const JsonStructuralIndex& index) {
+    const char* data = buffer.data();
+    const uint32_t* positions = index.positions().data();
+    size_t count = index.size();
+    if (count < 2 || data[positions[0]] != '[') {
+        JsonIndexedTokenizer indexedTokenizer(buffer, index);
+        return parseBuffer(indexedTokenizer);
+    }
+
+    // Bracket matching scan over the index: the elements of the root list are the ranges
+    // between the commas found at depth one. Each range is validated by its own parser
+    std::vector<size_t> starts;
+    starts.push_back(1);
+    size_t close = count;
+    int depth = 0;
+    for (size_t i = 0; i < count && close == count; ++i) {
+        switch (data[positions[i]]) {
+        case '[':
+        case '{':
+            ++depth;
+            break;
+        case ']':
+        case '}':
+            if (--depth == 0) {
+                close = i;
+            }
+            break;
+        case ',':
+            if (depth == 1) {
+                starts.push_back(i + 1);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (close == count) {
+        throw std::logic_error("Exhaused tokens");
+    }
+    if (data[positions[close]] != ']') {
+        throw std::logic_error("Expected ',' or ']' at position " + std::to_string(positions[close]));
+    }
+    if (close + 1 != count) {
+        throw std::logic_error("Unexpected token after the root element at position " + std::to_string(positions[close + 1]));
+    }
+    if (close == 1) {
+        root = std::make_shared<JsonNode>(JsonList());
+        return root;
+    }
+    starts.push_back(close + 1);
+
+    size_t elements = starts.size() - 1;
+    ThreadPool& pool = ThreadPool::shared();
+    size_t grain = std::max<size_t>(elements / ((pool.threadCount() + 1) * 4), 1);
+
+    // A list of numbers is packed as in the sequential parser: the numbers are parsed in
+    // parallel and added to the builder in order
+    bool numbers = true;
+    for (size_t i = 0; i < elements && numbers; ++i) {
+        char c = data[positions[starts[i]]];
+        numbers = starts[i + 1] - starts[i] == 2 && (c == '-' || (c >= '0' && c <= '9'));
+    }
+    if (numbers) {
+        std::vector<JsonNumber> values(elements);
+        pool.parallelFor(elements, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                JsonIndexedTokenizer elementTokenizer(buffer, index, starts[i], 1);
+                values[i] = parseJsonNumber(elementTokenizer.getToken().value);
+            }
+        });
+        JsonNumberListBuilder builder;
+        for (auto & number : values) {
+            if (number.isInteger) {
+                builder.add(number.integerValue);
+            }
+            else {
+                builder.add(number.doubleValue);
+            }
+        }
+        root = builder.node();
+        return root;
+    }
+
+    JsonList list(elements);
+    pool.parallelFor(elements, grain, [&](size_t begin, size_t end) {
+        JsonKeyTable keys;
+        for (size_t i = begin; i < end; ++i) {
+            // The range excludes the comma or the closing bracket that ends the element
+            JsonIndexedTokenizer elementTokenizer(buffer, index, starts[i], starts[i + 1] - starts[i] - 1);
+            if (!elementTokenizer.hasMoreTokens()) {
+                throw std::logic_error("Unexpected token at position " + std::to_string(positions[starts[i]]));
+            }
+            list[i] = parseValue(elementTokenizer, keys, 1);
+            if (elementTokenizer.hasMoreTokens()) {
+                throw std::logic_error("Expected ',' or ']' at position " + std::to_string(elementTokenizer.position()));
+            }
+        }
+    });
+
+    root = std::make_shared<JsonNode>(std::move(list));
+    return root;
+}
+
+template <typename Tokenizer>
+std::shared_ptr<JsonNode> JsonParser::parseValue(Tokenizer& bufferTokenizer, JsonKeyTable& keys, size_t depth) {
+    JsonTokenView token = bufferTokenizer.getToken();
+    switch (token.type) {
+    case JsonTokenType::CurlyOpen:
+        return parseObject(bufferTokenizer, keys, depth + 1);
+    case JsonTokenType::ListOpen:
+        return parseList(bufferTokenizer, keys, depth + 1);
+    case JsonTokenType::String:
+        return std::make_shared<JsonNode>(token.stringValue());
+    case JsonTokenType::Number:
+        return parseNumber(token);
+    case JsonTokenType::Boolean:
+        return std::make_shared<JsonNode>(token.value == "true");
+    case JsonTokenType::NullType:
+        return std::make_shared<JsonNode>();
+    default:
+        throw std::logic_error("Unexpected token at position " + std::to_string(bufferTokenizer.position()));
+    }
+}
+
+template <typename Tokenizer>
+std::shared_ptr<JsonNode> JsonParser::parseObject(Tokenizer& bufferTokenizer, JsonKeyTable& keys, size_t depth) {
+    checkJsonDepth(depth);
+    JsonObject keyObjectMap;
+    if (bufferTokenizer.peekToken().type == JsonTokenType::CurlyClose) {
+        bufferTokenizer.getToken();
+        return std::make_shared<JsonNode>(std::move(keyObjectMap));
+    }
+
+    while (true) {
+        JsonTokenView keyToken = bufferTokenizer.getToken();
+        if (keyToken.type != JsonTokenType::String) {
+            throw std::logic_error("Expected object key at position " + std::to_string(bufferTokenizer.position()));
+        }
+        if (bufferTokenizer.getToken().type != JsonTokenType::Colon) {
+            throw std::logic_error("Expected ':' at position " + std::to_string(bufferTokenizer.position()));
+        }
+        JsonKey key = keyToken.escaped ? keys.intern(keyToken.stringValue()) : keys.intern(keyToken.value);
+        keyObjectMap[key] = parseValue(bufferTokenizer, keys, depth);
+
+        JsonTokenView nextToken = bufferTokenizer.getToken();
+        if (nextToken.type == JsonTokenType::CurlyClose) {
+            break;
+        }
+        else if (nextToken.type != JsonTokenType::Comma) {
+            throw std::logic_error("Expected ',' or '}' at position " + std::to_string(bufferTokenizer.position()));
+        }
+    }
+    return std::make_shared<JsonNode>(std::move(keyObjectMap));
+}
+
+template <typename Tokenizer>
+std::shared_ptr<JsonNode> JsonParser::parseList(Tokenizer& bufferTokenizer, JsonKeyTable& keys, size_t depth) {
+    checkJsonDepth(depth);
+    JsonList list;
+    if (bufferTokenizer.peekToken().type == JsonTokenType::ListClose) {
+        bufferTokenizer.getToken();
+        return std::make_shared<JsonNode>(std::move(list));
+    }
+
+    // Lists of numbers are stored in a packed array. If other value is found, the numbers
+    // read so far are added to the list as nodes
+    if (bufferTokenizer.peekToken().type == JsonTokenType::Number) {
+        JsonNumberListBuilder numbers;
+        while (true) {
+            JsonNumber number = parseJsonNumber(bufferTokenizer.getToken().value);
+            if (number.isInteger) {
+                numbers.add(number.integerValue);
+            }
+            else {
+                numbers.add(number.doubleValue);
+            }
+
+            JsonTokenView nextToken = bufferTokenizer.getToken();
+            if (nextToken.type == JsonTokenType::ListClose) {
+                return numbers.node();
+            }
+            else if (nextToken.type != JsonTokenType::Comma) {
+                throw std::logic_error("Expected ',' or ']' at position " + std::to_string(bufferTokenizer.position()));
+            }
+            else if (bufferTokenizer.peekToken().type != JsonTokenType::Number) {
+                numbers.appendNodes(list);
+                break;
+            }
+        }
+    }
+
+    while (true) {
+        list.push_back(parseValue(bufferTokenizer, keys, depth));
+
+        JsonTokenView nextToken = bufferTokenizer.getToken();
+        if (nextToken.type == JsonTokenType::ListClose) {
+            break;
+        }
+        else if (nextToken.type != JsonTokenType::Comma) {
+            throw std::logic_error("Expected ',' or ']' at position " + std::to_string(bufferTokenizer.position()));
+        }
+    }
+    return std::make_shared<JsonNode>(std::move(list));
+}
+
+std::shared_ptr<JsonNode> JsonParser::parseNumber(const JsonTokenView& token) {
+    JsonNumber number = parseJsonNumber(token.value);
+    if (number.isInteger) {
+        return std::make_shared<JsonNode>(number.integerValue);
+    }
+    return std::make_shared<JsonNode>(number.doubleValue);
+}
+
 }
 }
@@ -0,0 +1,308 @@
+
+#include <bg2e/tools/JsonReader.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace bg2e {
+namespace tools {
+
+JsonReader::JsonReader(std::string_view buffer)
+    :_tokenizer(buffer)
+{
+    _stack.reserve(16);
+}
+
+JsonEvent JsonReader::next() {
+    if (_stack.empty() && _rootDone) {
+        if (_tokenizer.hasMoreTokens()) {
+            throw std::logic_error("Unexpected token after the root element at position " + std::to_string(_tokenizer.position()));
+        }
+        _event = JsonEvent::EndDocument;
+        return _event;
+    }
+
+    if (!_stack.empty() && !_afterKey) {
+        Frame& frame = _stack.back();
+        JsonTokenView token = _tokenizer.getToken();
+        JsonTokenType closeType = frame.object ? JsonTokenType::CurlyClose : JsonTokenType::ListClose;
+        if (token.type == closeType) {
+            return closeContainer(frame.object);
+        }
+        if (!frame.first) {
+            if (token.type != JsonTokenType::Comma) {
+                throw std::logic_error(std::string("Expected ',' or '") + (frame.object ? "}" : "]") + "' at position " + std::to_string(_tokenizer.position()));
+            }
+            token = _tokenizer.getToken();
+        }
+        frame.first = false;
+
+        if (frame.object) {
+            if (token.type != JsonTokenType::String) {
+                throw std::logic_error("Expected object key at position " + std::to_string(_tokenizer.position()));
+            }
+            if (_tokenizer.getToken().type != JsonTokenType::Colon) {
+                throw std::logic_error("Expected ':' at position " + std::to_string(_tokenizer.position()));
+            }
+            _token = token;
+            _afterKey = true;
+            _event = JsonEvent::Key;
+            return _event;
+        }
+        return valueEvent(token);
+    }
+
+    _afterKey = false;
+    return valueEvent(_tokenizer.getToken());
+}
+
+JsonEvent JsonReader::valueEvent(const JsonTokenView& token) {
+    _token = token;
+    switch (token.type) {
+    case JsonTokenType::CurlyOpen:
+        checkJsonDepth(_stack.size() + 1);
+        _stack.push_back({ true, true });
+        _event = JsonEvent::StartObject;
+        return _event;
+    case JsonTokenType::ListOpen:
+        checkJsonDepth(_stack.size() + 1);
+        _stack.push_back({ false, true });
+        _event = JsonEvent::StartList;
+        return _event;
+    case JsonTokenType::String:
+        _event = JsonEvent::String;
+        break;
+    case JsonTokenType::Number:
+        _event = JsonEvent::Number;
+        break;
+    case JsonTokenType::Boolean:
+        _event = JsonEvent::Bool;
+        break;
+    case JsonTokenType::NullType:
+        _event = JsonEvent::Null;
+        break;
+    default:
+        throw std::logic_error("Unexpected token at position " + std::to_string(_tokenizer.position()));
+    }
+    if (_stack.empty()) {
+        _rootDone = true;
+    }
+    return _event;
+}
+
+JsonEvent JsonReader::closeContainer(bool object) {
+    _stack.pop_back();
+    if (_stack.empty()) {
+        _rootDone = true;
+    }
+    _event = object ? JsonEvent::EndObject : JsonEvent::EndList;
+    return _event;
+}
+
+void JsonReader::parse(JsonHandler& handler) {
+    while (true) {
+        switch (next()) {
+        case JsonEvent::StartObject:
+            handler.startObject();
+            break;
+        case JsonEvent::EndObject:
+            handler.endObject();
+            break;
+        case JsonEvent::StartList:
+            handler.startList();
+            break;
+        case JsonEvent::EndList:
+            handler.endList();
+            break;
+        case JsonEvent::Key:
+            handler.key(stringValue());
+            break;
+        case JsonEvent::String:
+            handler.string(stringValue());
+            break;
+        case JsonEvent::Number:
+            handler.number(numberValue());
+            break;
+        case JsonEvent::Bool:
+            handler.boolean(boolValue());
+            break;
+        case JsonEvent::Null:
+            handler.null();
+            break;
+        case JsonEvent::EndDocument:
+            return;
+        }
+    }
+}
+
+std::string_view JsonReader::stringValue() {
+    if (_event != JsonEvent::String && _event != JsonEvent::Key) {
+        throw std::logic_error("Improper return type: string");
+    }
+    if (_token.escaped) {
+        _scratch.clear();
+        unescapeJsonString(_token.value, _scratch);
+        return _scratch;
+    }
+    return _token.value;
+}
+
+double JsonReader::numberValue() const {
+    if (_event != JsonEvent::Number) {
+        throw std::logic_error("Improper return type: number");
+    }
+    return parseJsonNumber(_token.value).doubleValue;
+}
+
+int64_t JsonReader::integerValue() const {
+    if (_event != JsonEvent::Number) {
+        throw std::logic_error("Improper return type: number");
+    }
+    JsonNumber number = parseJsonNumber(_token.value);
+    return number.isInteger ? number.integerValue : static_cast<int64_t>(number.doubleValue);
+}
+
+bool JsonReader::isInteger() const {
+    return _event == JsonEvent::Number && parseJsonNumber(_token.value).isInteger;
+}
+
+void JsonReader::skipValue() {
+    JsonEvent event = next();
+    if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+}
+
+void JsonReader::skipContainer() {
+    if (_stack.empty()) {
+        return;
+    }
+    size_t targetDepth = _stack.size() - 1;
+    while (_stack.size() > targetDepth) {
+        if (next() == JsonEvent::EndDocument) {
+            break;
+        }
+    }
+}
+
+float JsonReader::readFloat(float defaultValue) {
+    return static_cast<float>(readDouble(static_cast<double>(defaultValue)));
+}
+
+double JsonReader::readDouble(double defaultValue) {
+    JsonEvent event = next();
+    if (event == JsonEvent::Number) {
+        return numberValue();
+    }
+    else if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+    return defaultValue;
+}
+
+int32_t JsonReader::readInt(int32_t defaultValue) {
+    JsonEvent event = next();
+    if (event == JsonEvent::Number) {
+        return static_cast<int32_t>(integerValue());
+    }
+    else if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+    return defaultValue;
+}
+
+uint32_t JsonReader::readUInt(uint32_t defaultValue) {
+    JsonEvent event = next();
+    if (event == JsonEvent::Number) {
+        return static_cast<uint32_t>(integerValue());
+    }
+    else if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+    return defaultValue;
+}
+
+bool JsonReader::readBool(bool defaultValue) {
+    JsonEvent event = next();
+    if (event == JsonEvent::Bool) {
+        return boolValue();
+    }
+    else if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+    return defaultValue;
+}
+
+std::string JsonReader::readString(const std::string& defaultValue) {
+    JsonEvent event = next();
+    if (event == JsonEvent::String) {
+        return std::string(stringValue());
+    }
+    else if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+        skipContainer();
+    }
+    return defaultValue;
+}
+
+bool JsonReader::readFloats(float* result, size_t count) {
+    JsonEvent event = next();
+    if (event == JsonEvent::StartObject) {
+        skipContainer();
+        return false;
+    }
+    else if (event != JsonEvent::StartList) {
+        return false;
+    }
+
+    // Values are read in a temporary buffer, so that the result is not modified if the list is not valid
+    float values[16];
+    size_t read = 0;
+    while (true) {
+        event = next();
+        if (event == JsonEvent::EndList) {
+            break;
+        }
+        else if (event == JsonEvent::Number) {
+            if (read < count && read < 16) {
+                values[read] = static_cast<float>(numberValue());
+            }
+            ++read;
+        }
+        else {
+            if (event == JsonEvent::StartObject || event == JsonEvent::StartList) {
+                skipContainer();
+            }
+            skipContainer();
+            return false;
+        }
+    }
+
+    if (read < count || count > 16) {
+        return false;
+    }
+    std::copy(values, values + count, result);
+    return true;
+}
+
+glm::vec2 JsonReader::readVec2(const glm::vec2& defaultValue) {
+    glm::vec2 result;
+    return readFloats(&result.x, 2) ? result : defaultValue;
+}
+
+glm::vec3 JsonReader::readVec3(const glm::vec3& defaultValue) {
+    glm::vec3 result;
+    return readFloats(&result.x, 3) ? result : defaultValue;
+}
+
+glm::vec4 JsonReader::readVec4(const glm::vec4& defaultValue) {
+    glm::vec4 result;
+    return readFloats(&result.x, 4) ? result : defaultValue;
+}
+
+glm::mat4 JsonReader::readMat4(const glm::mat4& defaultValue) {
+    glm::mat4 result;
+    return readFloats(&result[0][0], 16) ? result : defaultValue;
+}
+
+}
+}
@@ -0,0 +1,374 @@
+
+#include <bg2e/tools/JsonStructuralIndex.hpp>
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BG2E_JSON_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BG2E_JSON_SSE2
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define BG2E_JSON_NEON
+#endif
+
+namespace bg2e {
+namespace tools {
+
+// Character classes of a 64 byte block, one bit per byte
+struct JsonBlockMasks {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t open;
+    uint64_t close;
+    uint64_t separator;
+    uint64_t whitespace;
+};
+
+#if defined(BG2E_JSON_AVX2)
+
+static inline uint64_t toMask(__m256i lo, __m256i hi) {
+    uint64_t l = static_cast<uint32_t>(_mm256_movemask_epi8(lo));
+    uint64_t h = static_cast<uint32_t>(_mm256_movemask_epi8(hi));
+    return l | (h << 32);
+}
+
+static inline void classifyHalf(__m256i v, __m256i* result) {
+    // '{' and '[', and '}' and ']', only differ in the 0x20 bit
+    __m256i v20 = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    result[0] = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+    result[1] = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+    result[2] = _mm256_cmpeq_epi8(v20, _mm256_set1_epi8('{'));
+    result[3] = _mm256_cmpeq_epi8(v20, _mm256_set1_epi8('}'));
+    result[4] = _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')));
+    result[5] = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+}
+
+static inline void classifyBlock(const char* data, JsonBlockMasks& masks) {
+    __m256i lo[6];
+    __m256i hi[6];
+    classifyHalf(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)), lo);
+    classifyHalf(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32)), hi);
+    masks.backslash = toMask(lo[0], hi[0]);
+    masks.quote = toMask(lo[1], hi[1]);
+    masks.open = toMask(lo[2], hi[2]);
+    masks.close = toMask(lo[3], hi[3]);
+    masks.separator = toMask(lo[4], hi[4]);
+    masks.whitespace = toMask(lo[5], hi[5]);
+}
+
+#elif defined(BG2E_JSON_SSE2)
+
+static inline uint64_t toMask(const __m128i* v) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(v[0]))) |
+        (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(v[1]))) << 16) |
+        (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(v[2]))) << 32) |
+        (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(v[3]))) << 48);
+}
+
+static inline void classifyBlock(const char* data, JsonBlockMasks& masks) {
+    __m128i result[6][4];
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+        // '{' and '[', and '}' and ']', only differ in the 0x20 bit
+        __m128i v20 = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        result[0][i] = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+        result[1][i] = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        result[2][i] = _mm_cmpeq_epi8(v20, _mm_set1_epi8('{'));
+        result[3][i] = _mm_cmpeq_epi8(v20, _mm_set1_epi8('}'));
+        result[4][i] = _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+        result[5][i] = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+    }
+    masks.backslash = toMask(result[0]);
+    masks.quote = toMask(result[1]);
+    masks.open = toMask(result[2]);
+    masks.close = toMask(result[3]);
+    masks.separator = toMask(result[4]);
+    masks.whitespace = toMask(result[5]);
+}
+
+#elif defined(BG2E_JSON_NEON)
+
+static inline uint64_t toMask(const uint8x16_t* v) {
+    const uint8x16_t bits = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(v[0], bits), vandq_u8(v[1], bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(v[2], bits), vandq_u8(v[3], bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+static inline void classifyBlock(const char* data, JsonBlockMasks& masks) {
+    uint8x16_t result[6][4];
+    for (int i = 0; i < 4; ++i) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i * 16));
+        // '{' and '[', and '}' and ']', only differ in the 0x20 bit
+        uint8x16_t v20 = vorrq_u8(v, vdupq_n_u8(0x20));
+        result[0][i] = vceqq_u8(v, vdupq_n_u8('\\'));
+        result[1][i] = vceqq_u8(v, vdupq_n_u8('"'));
+        result[2][i] = vceqq_u8(v20, vdupq_n_u8('{'));
+        result[3][i] = vceqq_u8(v20, vdupq_n_u8('}'));
+        result[4][i] = vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(',')));
+        result[5][i] = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\n'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')), vceqq_u8(v, vdupq_n_u8('\t'))));
+    }
+    masks.backslash = toMask(result[0]);
+    masks.quote = toMask(result[1]);
+    masks.open = toMask(result[2]);
+    masks.close = toMask(result[3]);
+    masks.separator = toMask(result[4]);
+    masks.whitespace = toMask(result[5]);
+}
+
+#else
+
+static inline void classifyBlock(const char* data, JsonBlockMasks& masks) {
+    masks = JsonBlockMasks{};
+    for (int i = 0; i < 64; ++i) {
+        uint64_t bit = 1ull << i;
+        switch (data[i]) {
+        case '\\': masks.backslash |= bit; break;
+        case '"': masks.quote |= bit; break;
+        case '{':
+        case '[': masks.open |= bit; break;
+        case '}':
+        case ']': masks.close |= bit; break;
+        case ':':
+        case ',': masks.separator |= bit; break;
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t': masks.whitespace |= bit; break;
+        default: break;
+        }
+    }
+}
+
+#endif
+
+const char* JsonStructuralIndex::implementation() {
+#if defined(BG2E_JSON_AVX2)
+    return "AVX2";
+#elif defined(BG2E_JSON_SSE2)
+    return "SSE2";
+#elif defined(BG2E_JSON_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+static inline uint64_t prefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+void JsonStructuralIndex::build(std::string_view buffer) {
+    if (buffer.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::logic_error("JsonStructuralIndex: the buffer is too large");
+    }
+
+    _positions.clear();
+    _valueCount = 0;
+    _stringBytes = 0;
+
+    const char* data = buffer.data();
+    size_t size = buffer.size();
+    size_t count = 0;
+
+    // State carried between blocks
+    uint64_t escapeCarry = 0;
+    uint64_t inStringCarry = 0;
+    uint64_t boundaryCarry = 1;
+
+    char lastBlock[64];
+    for (size_t blockStart = 0; blockStart < size; blockStart += 64) {
+        const char* block = data + blockStart;
+        if (size - blockStart < 64) {
+            std::memset(lastBlock, ' ', sizeof(lastBlock));
+            std::memcpy(lastBlock, block, size - blockStart);
+            block = lastBlock;
+        }
+
+        JsonBlockMasks masks;
+        classifyBlock(block, masks);
+
+        // Characters preceded by an odd number of backslashes. Escapes are rare in scene
+        // files, so they are resolved one by one
+        uint64_t escaped = escapeCarry;
+        escapeCarry = 0;
+        uint64_t backslash = masks.backslash & ~escaped;
+        while (backslash) {
+            int i = std::countr_zero(backslash);
+            if (i == 63) {
+                escapeCarry = 1;
+                break;
+            }
+            uint64_t next = 1ull << (i + 1);
+            escaped |= next;
+            backslash &= ~(next | (next >> 1));
+        }
+
+        // The opening quote is inside the string, and the closing quote is outside
+        uint64_t quotes = masks.quote & ~escaped;
+        uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+        inStringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        uint64_t openingQuotes = quotes & inString;
+        uint64_t closingQuotes = quotes & ~inString;
+
+        uint64_t structural = (masks.open | masks.close | masks.separator) & ~inString;
+
+        // Scalar values start after a structural character, a white space or a string
+        uint64_t boundary = masks.open | masks.close | masks.separator | masks.whitespace | closingQuotes;
+        uint64_t scalar = ~(boundary | quotes | inString);
+        uint64_t scalarStarts = scalar & ((boundary << 1) | boundaryCarry);
+        boundaryCarry = boundary >> 63;
+
+        uint64_t bits = structural | openingQuotes | scalarStarts;
+        _valueCount += std::popcount((masks.open & ~inString) | openingQuotes | scalarStarts);
+        _stringBytes += std::popcount(inString & ~quotes);
+
+        if (count + 64 > _positions.size()) {
+            _positions.resize(std::max(_positions.size() * 2, count + 64));
+        }
+        uint32_t* out = _positions.data() + count;
+        uint32_t base = static_cast<uint32_t>(blockStart);
+        count += std::popcount(bits);
+        while (bits) {
+            *out++ = base + std::countr_zero(bits);
+            bits &= bits - 1;
+        }
+    }
+
+    if (inStringCarry) {
+        throw std::logic_error("Unterminated string");
+    }
+
+    _positions.resize(count);
+    _positions.push_back(static_cast<uint32_t>(size));
+}
+
+JsonIndexedTokenizer::JsonIndexedTokenizer(std::string_view buffer, const JsonStructuralIndex& index)
+    :_buffer(buffer), _positions(index.positions().data()), _count(index.size())
+{
+
+}
+
+JsonIndexedTokenizer::JsonIndexedTokenizer(std::string_view buffer, const JsonStructuralIndex& index, size_t first, size_t count)
+    :_buffer(buffer), _positions(index.positions().data() + first), _count(count)
+{
+
+}
+
+const JsonTokenView& JsonIndexedTokenizer::peekToken() {
+    if (!hasMoreTokens()) {
+        throw std::logic_error("Exhaused tokens");
+    }
+    if (!_hasLookahead) {
+        scanToken(_current, _lookahead);
+        _hasLookahead = true;
+    }
+    return _lookahead;
+}
+
+JsonTokenView JsonIndexedTokenizer::getToken() {
+    if (_hasLookahead) {
+        _hasLookahead = false;
+        ++_current;
+        return _lookahead;
+    }
+    if (!hasMoreTokens()) {
+        throw std::logic_error("Exhaused tokens");
+    }
+    JsonTokenView token;
+    scanToken(_current++, token);
+    return token;
+}
+
+static inline bool isJsonWhiteSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+void JsonIndexedTokenizer::scanToken(size_t index, JsonTokenView& token) const {
+    const char* data = _buffer.data();
+    size_t pos = _positions[index];
+    token.escaped = false;
+    token.value = std::string_view();
+    char c = data[pos];
+    switch (c) {
+    case '{':
+        token.type = JsonTokenType::CurlyOpen;
+        return;
+    case '}':
+        token.type = JsonTokenType::CurlyClose;
+        return;
+    case '[':
+        token.type = JsonTokenType::ListOpen;
+        return;
+    case ']':
+        token.type = JsonTokenType::ListClose;
+        return;
+    case ':':
+        token.type = JsonTokenType::Colon;
+        return;
+    case ',':
+        token.type = JsonTokenType::Comma;
+        return;
+    default:
+        break;
+    }
+
+    // Strings and scalars end at the last non white space character before the next index entry
+    size_t end = _positions[index + 1];
+    while (end > pos + 1 && isJsonWhiteSpace(data[end - 1])) {
+        --end;
+    }
+
+    if (c == '"') {
+        if (end < pos + 2 || data[end - 1] != '"') {
+            throw std::logic_error("Unterminated string at position " + std::to_string(pos));
+        }
+        token.type = JsonTokenType::String;
+        token.value = std::string_view(data + pos + 1, end - pos - 2);
+        token.escaped = std::memchr(token.value.data(), '\\', token.value.size()) != nullptr;
+    }
+    else if (c == '-' || (c >= '0' && c <= '9')) {
+        token.type = JsonTokenType::Number;
+        token.value = std::string_view(data + pos, end - pos);
+    }
+    else if (c == 't' || c == 'f' || c == 'n') {
+        std::string_view literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+        token.value = std::string_view(data + pos, end - pos);
+        if (token.value != literal) {
+            throw std::logic_error("Unexpected literal at position " + std::to_string(pos));
+        }
+        token.type = c == 'n' ? JsonTokenType::NullType : JsonTokenType::Boolean;
+    }
+    else {
+        throw std::logic_error(std::string("Unexpected character '") + c + "' at position " + std::to_string(pos));
+    }
+}
+
+}
+}
@@ -1,6 +1,15 @@
 
 #include <bg2e/tools/JsonToken.hpp>
 
+#include <stdexcept>
+#include <charconv>
+#include <cstdio>
+#include <sstream>
+#include <locale>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
 namespace bg2e {
 namespace tools {
 
@@ -147,5 +156,447 @@ void JsonTokenizer::rollBackToken() {
     stream->seekg(prevPos);
 }
 
+std::string JsonTokenView::stringValue() const {
+    if (!escaped) {
+        return std::string(value);
+    }
+    std::string result;
+    unescapeJsonString(value, result);
+    return result;
+}
+
+static const double g_exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Overflow is infinity and underflow is zero, as in strtod. The text is a valid JSON number,
+// and the decimal exponent of its first significant digit decides the case
+static double outOfRangeValue(std::string_view text) {
+    bool negative = text[0] == '-';
+    size_t e = text.find_first_of("eE");
+    std::string_view mantissa = text.substr(negative ? 1 : 0, e == std::string_view::npos ? std::string_view::npos : e - (negative ? 1 : 0));
+    size_t point = mantissa.find('.');
+    size_t firstDigit = mantissa.find_first_of("123456789");
+    int64_t exponent = 0;
+    if (firstDigit != std::string_view::npos) {
+        size_t integerDigits = point == std::string_view::npos ? mantissa.size() : point;
+        exponent = firstDigit < integerDigits ?
+            static_cast<int64_t>(integerDigits - firstDigit) :
+            -static_cast<int64_t>(firstDigit - integerDigits - 1);
+    }
+    if (e != std::string_view::npos) {
+        std::string_view digits = text.substr(e + 1);
+        bool negativeExponent = !digits.empty() && digits[0] == '-';
+        if (!digits.empty() && (digits[0] == '-' || digits[0] == '+')) {
+            digits.remove_prefix(1);
+        }
+        int64_t explicitExponent = 0;
+        for (char c : digits) {
+            explicitExponent = std::min<int64_t>(explicitExponent * 10 + (c - '0'), 1000000);
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    double result = exponent > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+    return negative ? -result : result;
+}
+
+static double parseDoubleSlowPath(std::string_view text) {
+    double result = 0.0;
+#if defined(__cpp_lib_to_chars)
+    auto res = std::from_chars(text.data(), text.data() + text.size(), result);
+    if (res.ec == std::errc::result_out_of_range) {
+        return outOfRangeValue(text);
+    }
+    else if (res.ec != std::errc() || res.ptr != text.data() + text.size()) {
+        throw std::logic_error("Invalid number: " + std::string(text));
+    }
+#else
+    std::istringstream stream{ std::string(text) };
+    stream.imbue(std::locale::classic());
+    stream >> result;
+    if (stream.fail()) {
+        // The text is already validated, so the conversion only fails if the value is out
+        // of range. Some libraries also fail with subnormal values, that are kept
+        if (std::isfinite(result) && result != 0.0 && std::abs(result) < std::numeric_limits<double>::min()) {
+            return result;
+        }
+        return outOfRangeValue(text);
+    }
+    if (stream.peek() != std::char_traits<char>::eof()) {
+        throw std::logic_error("Invalid number: " + std::string(text));
+    }
+#endif
+    return result;
+}
+
+JsonNumber parseJsonNumber(std::string_view text) {
+    JsonNumber result;
+    const char * c = text.data();
+    const char * end = c + text.size();
+
+    bool negative = c < end && *c == '-';
+    if (negative) {
+        ++c;
+    }
+
+    // Leading zeros are not valid (RFC 8259)
+    if (c == end || *c < '0' || *c > '9' || (*c == '0' && c + 1 < end && c[1] >= '0' && c[1] <= '9')) {
+        throw std::logic_error("Invalid number: " + std::string(text));
+    }
+
+    // Mantissa digits, ignoring leading zeros. Up to 19 significant digits fit in 64 bits
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int droppedDigits = 0;
+    while (c < end && *c >= '0' && *c <= '9') {
+        if (significantDigits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+            if (mantissa != 0) {
+                ++significantDigits;
+            }
+        }
+        else {
+            ++droppedDigits;
+        }
+        ++c;
+    }
+
+    if (c == end) {
+        // Integer fast path
+        if (droppedDigits == 0) {
+            if (!negative && mantissa <= static_cast<uint64_t>(INT64_MAX)) {
+                result.isInteger = true;
+                result.integerValue = static_cast<int64_t>(mantissa);
+                result.doubleValue = static_cast<double>(result.integerValue);
+                return result;
+            }
+            else if (negative && mantissa <= static_cast<uint64_t>(INT64_MAX) + 1) {
+                result.isInteger = true;
+                result.integerValue = static_cast<int64_t>(0 - mantissa);
+                result.doubleValue = -static_cast<double>(mantissa);
+                return result;
+            }
+        }
+        result.doubleValue = parseDoubleSlowPath(text);
+        return result;
+    }
+
+    int exponent = droppedDigits;
+    if (*c == '.') {
+        ++c;
+        if (c == end || *c < '0' || *c > '9') {
+            throw std::logic_error("Invalid number: " + std::string(text));
+        }
+        while (c < end && *c >= '0' && *c <= '9') {
+            if (significantDigits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+                --exponent;
+                if (mantissa != 0) {
+                    ++significantDigits;
+                }
+            }
+            ++c;
+        }
+    }
+
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        ++c;
+        bool negativeExponent = false;
+        if (c < end && (*c == '+' || *c == '-')) {
+            negativeExponent = *c == '-';
+            ++c;
+        }
+        if (c == end || *c < '0' || *c > '9') {
+            throw std::logic_error("Invalid number: " + std::string(text));
+        }
+        int explicitExponent = 0;
+        while (c < end && *c >= '0' && *c <= '9') {
+            if (explicitExponent < 100000) {
+                explicitExponent = explicitExponent * 10 + (*c - '0');
+            }
+            ++c;
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    if (c != end) {
+        throw std::logic_error("Invalid number: " + std::string(text));
+    }
+
+    // Clinger fast path: both the mantissa and the power of ten are exact doubles, so a
+    // single multiplication or division is correctly rounded
+    if (significantDigits < 19 && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / g_exactPowersOfTen[-exponent] : value * g_exactPowersOfTen[exponent];
+        result.doubleValue = negative ? -value : value;
+        return result;
+    }
+
+    result.doubleValue = parseDoubleSlowPath(text);
+    return result;
+}
+
+template <typename T>
+static size_t formatShortest(T value, char* buffer) {
+#if defined(__cpp_lib_to_chars)
+    auto res = std::to_chars(buffer, buffer + JsonNumberBufferSize, value);
+    return static_cast<size_t>(res.ptr - buffer);
+#else
+    // Shortest precision that reads back as the same value. snprintf writes the decimal
+    // separator of the C locale, that can have more than one byte, so it is replaced by '.'
+    char text[64];
+    size_t length = 0;
+    for (int precision = 1; precision <= std::numeric_limits<T>::max_digits10; ++precision) {
+        int count = std::snprintf(text, sizeof(text), "%.*g", precision, static_cast<double>(value));
+        bool separator = false;
+        length = 0;
+        for (int i = 0; i < count && length < JsonNumberBufferSize; ++i) {
+            char c = text[i];
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == 'e') {
+                buffer[length++] = c;
+            }
+            else if (!separator) {
+                buffer[length++] = '.';
+                separator = true;
+            }
+        }
+        if (static_cast<T>(parseJsonNumber(std::string_view(buffer, length)).doubleValue) == value) {
+            break;
+        }
+    }
+    return length;
+#endif
+}
+
+size_t formatJsonNumber(float value, char* buffer) {
+    return formatShortest(value, buffer);
+}
+
+size_t formatJsonNumber(double value, char* buffer) {
+    return formatShortest(value, buffer);
+}
+
+double jsonDecimalValue(float value) {
+    if (!std::isfinite(value)) {
+        return static_cast<double>(value);
+    }
+    char text[JsonNumberBufferSize];
+    double result = parseJsonNumber(std::string_view(text, formatShortest(value, text))).doubleValue;
+    return static_cast<float>(result) == value ? result : static_cast<double>(value);
+}
+
+static void appendUtf8(uint32_t cp, std::string& result) {
+    if (cp < 0x80) {
+        result += static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        result += static_cast<char>(0xC0 | (cp >> 6));
+        result += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        result += static_cast<char>(0xE0 | (cp >> 12));
+        result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        result += static_cast<char>(0xF0 | (cp >> 18));
+        result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+static uint32_t parseHex4(std::string_view raw, size_t pos) {
+    if (pos + 4 > raw.size()) {
+        throw std::logic_error("Invalid unicode escape sequence");
+    }
+    uint32_t cp = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = raw[i];
+        cp <<= 4;
+        if (c >= '0' && c <= '9') cp |= static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') cp |= static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') cp |= static_cast<uint32_t>(c - 'A' + 10);
+        else throw std::logic_error("Invalid unicode escape sequence");
+    }
+    return cp;
+}
+
+void unescapeJsonString(std::string_view raw, std::string& result) {
+    result.reserve(result.size() + raw.size());
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t next = raw.find('\\', i);
+        if (next == std::string_view::npos) {
+            result.append(raw.data() + i, raw.size() - i);
+            break;
+        }
+        result.append(raw.data() + i, next - i);
+        if (next + 1 >= raw.size()) {
+            throw std::logic_error("Invalid escape sequence at end of string");
+        }
+        char c = raw[next + 1];
+        i = next + 2;
+        switch (c) {
+        case '"': result += '"'; break;
+        case '\\': result += '\\'; break;
+        case '/': result += '/'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'n': result += '\n'; break;
+        case 'r': result += '\r'; break;
+        case 't': result += '\t'; break;
+        case 'u': {
+            uint32_t cp = parseHex4(raw, i);
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 6 <= raw.size() && raw[i] == '\\' && raw[i + 1] == 'u') {
+                uint32_t low = parseHex4(raw, i + 2);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+            }
+            appendUtf8(cp, result);
+            break;
+        }
+        default:
+            throw std::logic_error(std::string("Invalid escape sequence: \\") + c);
+        }
+    }
+}
+
+JsonBufferTokenizer::JsonBufferTokenizer(std::string_view buffer)
+    :_buffer(buffer)
+{
+
+}
+
+bool JsonBufferTokenizer::hasMoreTokens() {
+    if (!_hasLookahead) {
+        _lookaheadPos = _pos;
+        _hasLookahead = scanToken(_lookahead);
+    }
+    return _hasLookahead;
+}
+
+const JsonTokenView& JsonBufferTokenizer::peekToken() {
+    if (!hasMoreTokens()) {
+        throw std::logic_error("Exhaused tokens");
+    }
+    return _lookahead;
+}
+
+JsonTokenView JsonBufferTokenizer::getToken() {
+    if (_hasLookahead) {
+        _hasLookahead = false;
+        return _lookahead;
+    }
+    JsonTokenView token;
+    if (!scanToken(token)) {
+        throw std::logic_error("Exhaused tokens");
+    }
+    return token;
+}
+
+void JsonBufferTokenizer::skipWhiteSpace() {
+    const char * data = _buffer.data();
+    size_t size = _buffer.size();
+    while (_pos < size) {
+        char c = data[_pos];
+        if (c != ' ' && c != '\n' && c != '\t' && c != '\r') {
+            break;
+        }
+        ++_pos;
+    }
+}
+
+bool JsonBufferTokenizer::scanToken(JsonTokenView& token) {
+    skipWhiteSpace();
+    const char * data = _buffer.data();
+    size_t size = _buffer.size();
+    if (_pos >= size) {
+        return false;
+    }
+
+    token.escaped = false;
+    token.value = std::string_view();
+    char c = data[_pos];
+    switch (c) {
+    case '{':
+        token.type = JsonTokenType::CurlyOpen;
+        ++_pos;
+        break;
+    case '}':
+        token.type = JsonTokenType::CurlyClose;
+        ++_pos;
+        break;
+    case '[':
+        token.type = JsonTokenType::ListOpen;
+        ++_pos;
+        break;
+    case ']':
+        token.type = JsonTokenType::ListClose;
+        ++_pos;
+        break;
+    case ':':
+        token.type = JsonTokenType::Colon;
+        ++_pos;
+        break;
+    case ',':
+        token.type = JsonTokenType::Comma;
+        ++_pos;
+        break;
+    case '"': {
+        size_t begin = ++_pos;
+        while (_pos < size && data[_pos] != '"') {
+            if (data[_pos] == '\\') {
+                token.escaped = true;
+                ++_pos;
+            }
+            ++_pos;
+        }
+        if (_pos >= size) {
+            throw std::logic_error("Unterminated string");
+        }
+        token.type = JsonTokenType::String;
+        token.value = std::string_view(data + begin, _pos - begin);
+        ++_pos;
+        break;
+    }
+    case 't':
+    case 'f':
+    case 'n': {
+        std::string_view literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+        if (_buffer.compare(_pos, literal.size(), literal) != 0) {
+            throw std::logic_error("Unexpected literal at position " + std::to_string(_pos));
+        }
+        token.type = c == 'n' ? JsonTokenType::NullType : JsonTokenType::Boolean;
+        token.value = std::string_view(data + _pos, literal.size());
+        _pos += literal.size();
+        break;
+    }
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            size_t begin = _pos++;
+            while (_pos < size) {
+                c = data[_pos];
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+') {
+                    ++_pos;
+                }
+                else {
+                    break;
+                }
+            }
+            token.type = JsonTokenType::Number;
+            token.value = std::string_view(data + begin, _pos - begin);
+        }
+        else {
+            throw std::logic_error(std::string("Unexpected character '") + c + "' at position " + std::to_string(_pos));
+        }
+    }
+    return true;
+}
+
 }
 }
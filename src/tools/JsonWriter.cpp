@@ -0,0 +1,362 @@
+
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/Json.hpp>
+#include <bg2e/tools/JsonDocument.hpp>
+#include <bg2e/tools/JsonToken.hpp>
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace bg2e {
+namespace tools {
+
+static const size_t g_streamBlockSize = 64 * 1024;
+
+template <typename T>
+static void appendFloat(std::string& buffer, T v) {
+    char text[JsonNumberBufferSize];
+    buffer.append(text, formatJsonNumber(v, text));
+}
+
+JsonWriter::JsonWriter(std::string& buffer, JsonWriterFormat format)
+    :_buffer(buffer), _format(format)
+{
+    _stack.reserve(16);
+}
+
+JsonWriter::JsonWriter(std::ostream& stream, JsonWriterFormat format)
+    :_buffer(_ownBuffer), _stream(&stream), _format(format)
+{
+    _stack.reserve(16);
+    _ownBuffer.reserve(g_streamBlockSize);
+}
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+void JsonWriter::flush()
+{
+    if (_stream && !_buffer.empty()) {
+        _stream->write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+        _buffer.clear();
+    }
+}
+
+void JsonWriter::checkFlush()
+{
+    if (_stream && _buffer.size() >= g_streamBlockSize) {
+        flush();
+    }
+}
+
+void JsonWriter::newLine(size_t level)
+{
+    _buffer += '\n';
+    _buffer.append(level * 2, ' ');
+}
+
+void JsonWriter::beginValue()
+{
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+    if (!_stack.empty()) {
+        Frame& frame = _stack.back();
+        if (frame.object) {
+            throw std::logic_error("JsonWriter: expected a key inside an object");
+        }
+        if (!frame.first) {
+            _buffer += ',';
+        }
+        frame.first = false;
+        if (_format == JsonWriterFormat::Pretty) {
+            newLine(_indentationLevel + _stack.size());
+        }
+    }
+}
+
+JsonWriter& JsonWriter::key(std::string_view key)
+{
+    if (_stack.empty() || !_stack.back().object || _afterKey) {
+        throw std::logic_error("JsonWriter: unexpected key");
+    }
+    Frame& frame = _stack.back();
+    if (!frame.first) {
+        _buffer += ',';
+    }
+    frame.first = false;
+    if (_format == JsonWriterFormat::Pretty) {
+        newLine(_indentationLevel + _stack.size());
+    }
+    _buffer += '"';
+    appendEscaped(key);
+    _buffer += _format == JsonWriterFormat::Pretty ? "\" : " : "\":";
+    _afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::startObject()
+{
+    beginValue();
+    _buffer += '{';
+    _stack.push_back({ true, true });
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    closeContainer('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::startList()
+{
+    beginValue();
+    _buffer += '[';
+    _stack.push_back({ false, true });
+    return *this;
+}
+
+JsonWriter& JsonWriter::endList()
+{
+    closeContainer(']');
+    return *this;
+}
+
+void JsonWriter::closeContainer(char c)
+{
+    if (_stack.empty() || _stack.back().object != (c == '}') || _afterKey) {
+        throw std::logic_error(std::string("JsonWriter: unexpected '") + c + "'");
+    }
+    bool empty = _stack.back().first;
+    _stack.pop_back();
+    if (_format == JsonWriterFormat::Pretty && !empty) {
+        newLine(_indentationLevel + _stack.size());
+    }
+    _buffer += c;
+    checkFlush();
+}
+
+void JsonWriter::appendEscaped(std::string_view str)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        _buffer.append(str.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+        case '"': _buffer += "\\\""; break;
+        case '\\': _buffer += "\\\\"; break;
+        case '\b': _buffer += "\\b"; break;
+        case '\f': _buffer += "\\f"; break;
+        case '\n': _buffer += "\\n"; break;
+        case '\r': _buffer += "\\r"; break;
+        case '\t': _buffer += "\\t"; break;
+        default: {
+            char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+            _buffer.append(escape, 6);
+        }
+        }
+    }
+    _buffer.append(str.data() + runStart, str.size() - runStart);
+}
+
+JsonWriter& JsonWriter::value(std::string_view v)
+{
+    beginValue();
+    _buffer += '"';
+    appendEscaped(v);
+    _buffer += '"';
+    checkFlush();
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t v)
+{
+    beginValue();
+    char text[24];
+    auto res = std::to_chars(text, text + sizeof(text), v);
+    _buffer.append(text, res.ptr - text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(float v)
+{
+    beginValue();
+    if (std::isfinite(v)) {
+        appendFloat(_buffer, v);
+    }
+    else {
+        _buffer += "null";
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double v)
+{
+    beginValue();
+    if (std::isfinite(v)) {
+        appendFloat(_buffer, v);
+    }
+    else {
+        _buffer += "null";
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool v)
+{
+    beginValue();
+    _buffer += v ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    beginValue();
+    _buffer += "null";
+    return *this;
+}
+
+void JsonWriter::writeFloats(const float* values, size_t count)
+{
+    startList();
+    for (size_t i = 0; i < count; ++i) {
+        value(values[i]);
+    }
+    endList();
+}
+
+JsonWriter& JsonWriter::value(const glm::vec2& v)
+{
+    writeFloats(&v.x, 2);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const glm::vec3& v)
+{
+    writeFloats(&v.x, 3);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const glm::vec4& v)
+{
+    writeFloats(&v.x, 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const glm::mat4& v)
+{
+    // Same element order as JsonNode::setValue(const glm::mat4&)
+    writeFloats(&v[0][0], 16);
+    return *this;
+}
+
+JsonWriter& JsonWriter::write(JsonNode& node)
+{
+    if (node.isObject()) {
+        startObject();
+        for (auto & item : node.objectValue()) {
+            key(item.first);
+            if (item.second) {
+                write(*item.second);
+            }
+            else {
+                null();
+            }
+        }
+        endObject();
+    }
+    else if (node.isFloatArray()) {
+        auto values = node.floatArrayValue();
+        writeFloats(values.data(), values.size());
+    }
+    else if (node.isIntArray()) {
+        startList();
+        for (auto v : node.intArrayValue()) {
+            value(v);
+        }
+        endList();
+    }
+    else if (node.isList()) {
+        startList();
+        for (auto & item : node.listValue()) {
+            if (item) {
+                write(*item);
+            }
+            else {
+                null();
+            }
+        }
+        endList();
+    }
+    else if (node.isString()) {
+        value(node.stringValue());
+    }
+    else if (node.isInteger()) {
+        value(node.int64Value());
+    }
+    else if (node.isSinglePrecision()) {
+        value(node.numberValue());
+    }
+    else if (node.isNumber()) {
+        value(node.doubleValue());
+    }
+    else if (node.isBool()) {
+        value(node.boolValue(false));
+    }
+    else {
+        null();
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::write(const JsonView& view)
+{
+    switch (view.type()) {
+    case JsonDocumentNodeType::Object:
+        startObject();
+        for (auto item : view.objectValue()) {
+            key(item.first);
+            write(item.second);
+        }
+        endObject();
+        break;
+    case JsonDocumentNodeType::List:
+        startList();
+        for (auto item : view.listValue()) {
+            write(item);
+        }
+        endList();
+        break;
+    case JsonDocumentNodeType::String:
+        value(view.stringValue());
+        break;
+    case JsonDocumentNodeType::Number:
+        if (view.isInteger()) {
+            value(view.int64Value());
+        }
+        else {
+            value(view.doubleValue());
+        }
+        break;
+    case JsonDocumentNodeType::Bool:
+        value(view.boolValue(false));
+        break;
+    case JsonDocumentNodeType::Null:
+    default:
+        null();
+    }
+    return *this;
+}
+
+}
+}
@@ -0,0 +1,177 @@
+
+#include <bg2e/tools/MappedFile.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bg2e {
+namespace tools {
+
+MappedFile::MappedFile()
+{
+
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    open(path);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _path = std::move(other._path);
+        _fileHandle = std::exchange(other._fileHandle, nullptr);
+        _mappingHandle = std::exchange(other._mappingHandle, nullptr);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string& path)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Could not get the size of file '" + path + "'");
+    }
+
+    _path = path;
+    _fileHandle = file;
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    if (_size == 0)
+    {
+        // Empty files can not be mapped
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        close();
+        throw std::runtime_error("Could not map file '" + path + "'");
+    }
+    _mappingHandle = mapping;
+
+    _data = static_cast<const Byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr)
+    {
+        close();
+        throw std::runtime_error("Could not map file '" + path + "'");
+    }
+}
+
+void MappedFile::close()
+{
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mappingHandle != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(_mappingHandle));
+    }
+    if (_fileHandle != nullptr)
+    {
+        CloseHandle(static_cast<HANDLE>(_fileHandle));
+    }
+    _data = nullptr;
+    _size = 0;
+    _fileHandle = nullptr;
+    _mappingHandle = nullptr;
+    _path = "";
+}
+
+#else
+
+void MappedFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not get the size of file '" + path + "'");
+    }
+
+    _path = path;
+    // The descriptor is stored with an offset of one, so that nullptr means "closed"
+    _fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+    _size = static_cast<size_t>(fileStat.st_size);
+    if (_size == 0)
+    {
+        // Empty files can not be mapped
+        return;
+    }
+
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        throw std::runtime_error("Could not map file '" + path + "'");
+    }
+    madvise(data, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const Byte*>(data);
+}
+
+void MappedFile::close()
+{
+    if (_data != nullptr)
+    {
+        munmap(const_cast<Byte*>(_data), _size);
+    }
+    if (_fileHandle != nullptr)
+    {
+        ::close(static_cast<int>(reinterpret_cast<intptr_t>(_fileHandle) - 1));
+    }
+    _data = nullptr;
+    _size = 0;
+    _fileHandle = nullptr;
+    _mappingHandle = nullptr;
+    _path = "";
+}
+
+#endif
+
+}
+}
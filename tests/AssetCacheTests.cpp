@@ -0,0 +1,56 @@
+#include "Tests.hpp"
+
+#include <bg2e/base/AssetCache.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace bg2e::base;
+using bg2e::tests::check;
+
+static void writeFile(const std::filesystem::path& path, const std::string& contents)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+}
+
+static float diffuseRed(const std::shared_ptr<Bg2CookedModel>& model)
+{
+    return model->materials()->listValue()[0]->objectValue()["diffuseR"]->numberValue();
+}
+
+// The key of an OBJ model includes its .mtl files, and concurrent loads cook the model once
+BG2E_TEST(assetCacheObjModel)
+{
+    auto directory = std::filesystem::temp_directory_path() / "bg2e-asset-cache-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const std::string geometry = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nusemtl red\nf 1/1 2/2 3/3\n";
+    writeFile(directory / "model.obj", "mtllib model.mtl\n" + geometry);
+    writeFile(directory / "model.mtl", "newmtl red\nKd 1 0 0\n");
+
+    {
+        AssetCache cache((directory / "cache").string());
+        const std::string path = (directory / "model.obj").string();
+        check(diffuseRed(cache.loadModel(path, false)) == 1.0f, "material of the first load");
+        writeFile(directory / "model.mtl", "newmtl red\nKd 0.5 0 0\n");
+        check(diffuseRed(cache.loadModel(path, false)) == 0.5f, "stale material after the .mtl file changed");
+        check(cache.stats().misses == 2 && cache.stats().stores == 2, "the changed .mtl file is not a cache miss");
+
+        cache.resetStats();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&]() { cache.loadModel(path, true); });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        check(cache.stats().stores == 1 && cache.stats().hits == 3, "concurrent loads stored " + std::to_string(cache.stats().stores) + " entries");
+    }
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,277 @@
+#include "Tests.hpp"
+
+#include <bg2e/tools/JsonParser.hpp>
+#include <bg2e/tools/JsonDocument.hpp>
+#include <bg2e/tools/JsonLazyDocument.hpp>
+#include <bg2e/tools/JsonWriter.hpp>
+#include <bg2e/tools/JsonToken.hpp>
+#include <bg2e/tools/JsonReader.hpp>
+#include <bg2e/tools/JsonIncrementalParser.hpp>
+
+#include <sstream>
+
+#include <limits>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace bg2e::tools;
+using bg2e::tests::check;
+
+static std::string compact(JsonNode& node)
+{
+    std::string result;
+    JsonWriter writer(result, JsonWriterFormat::Compact);
+    writer.write(node);
+    return result;
+}
+
+// The result of each parser for the same input
+static std::vector<std::shared_ptr<JsonNode>> parseAll(const std::string& input)
+{
+    JsonParser parser;
+    JsonDocument document(input);
+    JsonLazyDocument lazyDocument;
+    lazyDocument.parse(input);
+    return { parser.parse(input), document.root().toNode(), lazyDocument.root().node() };
+}
+
+// Number lists are packed only if no value changes
+BG2E_TEST(jsonNumberListPrecision)
+{
+    const std::vector<std::pair<std::string, std::vector<double>>> cases = {
+        { "[123456789, 0.5]", { 123456789.0, 0.5 } },
+        { "[0.1, 2]", { 0.1, 2.0 } },
+        { "[1e300, 0.5]", { 1e300, 0.5 } },
+        { "[0.25, -1.5, 3]", { 0.25, -1.5, 3.0 } }
+    };
+    for (auto & item : cases)
+    {
+        for (auto & node : parseAll(item.first))
+        {
+            auto& list = node->listValue();
+            bool valid = list.size() == item.second.size();
+            for (size_t i = 0; valid && i < list.size(); ++i)
+            {
+                valid = list[i]->doubleValue() == item.second[i];
+            }
+            check(valid && node->toString().find("null") == std::string::npos,
+                "number list " + item.first + " is not preserved: " + node->toString());
+        }
+    }
+}
+
+// Decimal numbers that are the shortest text of a float are packed, and the items read back
+// as the same decimal values. It includes the vectors and matrices written by the engine
+BG2E_TEST(jsonPackedFloatLists)
+{
+    glm::mat4 matrix(1.0f);
+    for (int i = 0; i < 16; ++i)
+    {
+        matrix[i / 4][i % 4] = std::sin(static_cast<float>(i + 1)) * 100.0f;
+    }
+    JsonNode vector(glm::vec3(0.8f, 0.3f, 1.0f));
+    JsonNode matrixNode(matrix);
+    const std::vector<std::pair<std::string, std::vector<double>>> cases = {
+        { "[0.8, 0.8, 0.8, 1]", { 0.8, 0.8, 0.8, 1.0 } },
+        { "[0.1, 0.2, 0.3]", { 0.1, 0.2, 0.3 } },
+        { compact(vector), { 0.8, 0.3, 1.0 } },
+        { vector.toString(), { 0.8, 0.3, 1.0 } },
+        { compact(matrixNode), {} },
+        { matrixNode.toString(), {} }
+    };
+    for (auto & item : cases)
+    {
+        for (auto & node : parseAll(item.first))
+        {
+            check(node->isFloatArray(), "number list " + item.first + " is not packed");
+            const JsonNode& packed = *node;
+            JsonList list = packed.listValue();
+            for (size_t i = 0; i < item.second.size(); ++i)
+            {
+                check(list[i]->doubleValue() == item.second[i], "number list " + item.first + " item " + std::to_string(i) + " read as " + std::to_string(list[i]->doubleValue()));
+            }
+        }
+    }
+
+    auto matrixValues = matrixNode.floatArrayValue();
+    for (auto & node : parseAll(compact(matrixNode)))
+    {
+        auto values = node->floatArrayValue();
+        check(std::equal(values.begin(), values.end(), matrixValues.begin(), matrixValues.end()), "matrix values changed: " + compact(*node));
+    }
+    // More digits than a float can keep
+    for (auto & node : parseAll("[0.123456789, 1]"))
+    {
+        check(!node->isFloatArray(), "number list with double precision packed");
+    }
+}
+
+// The parallel parser produces the same tree as the sequential parser, packed number lists
+// included
+BG2E_TEST(jsonParallelParse)
+{
+    std::string integers = "[";
+    std::string decimals = "[";
+    std::string doubles = "[";
+    std::string mixed = "[";
+    for (int i = 0; i < 300000; ++i)
+    {
+        std::string separator = i == 0 ? "" : ",";
+        integers += separator + std::to_string(i * 7 - 1000);
+        decimals += separator + std::to_string(i % 1000) + ".25";
+        doubles += separator + "0." + std::to_string(123456789 + i);
+        mixed += separator + (i % 3 == 0 ? "{\"id\":" + std::to_string(i) + "}" : std::to_string(i));
+    }
+    for (std::string input : { integers + "]", decimals + "]", doubles + "]", mixed + "]", std::string("[1e400, 5]") })
+    {
+        JsonParser parser;
+        auto sequential = parser.parse(input, JsonParseMode::Tokenizer);
+        auto parallel = parser.parse(input, JsonParseMode::Parallel);
+        check(sequential->isIntArray() == parallel->isIntArray() && sequential->isFloatArray() == parallel->isFloatArray() && sequential->isList() == parallel->isList(),
+            "parallel tree type is different: " + input.substr(0, 32));
+        check(compact(*sequential) == compact(*parallel), "parallel tree is different: " + input.substr(0, 32));
+    }
+}
+
+// Deeply nested documents throw std::logic_error instead of running out of stack
+BG2E_TEST(jsonMaxDepth)
+{
+    auto throwsLogicError = [](const std::function<void()>& parse) {
+        try
+        {
+            parse();
+        }
+        catch (std::logic_error&)
+        {
+            return true;
+        }
+        return false;
+    };
+    const std::string valid = std::string(JsonMaxDepth, '[') + std::string(JsonMaxDepth, ']');
+    const std::string nested = std::string(100000, '[');
+    const std::string nestedObjects = [] {
+        std::string result;
+        for (int i = 0; i < 100000; ++i)
+        {
+            result += "{\"a\":";
+        }
+        return result;
+    }();
+    const std::vector<std::pair<std::string, bool>> cases = { { valid, false }, { nested, true }, { nestedObjects, true } };
+    for (auto & [input, expected] : cases)
+    {
+        std::string name = input.substr(0, 8);
+        for (auto mode : { JsonParseMode::Tokenizer, JsonParseMode::StructuralIndex, JsonParseMode::Parallel })
+        {
+            check(throwsLogicError([&] { JsonParser().parse(input, mode); }) == expected, "JsonParser " + name);
+            check(throwsLogicError([&] { JsonDocument document; document.parse(input, mode); }) == expected, "JsonDocument " + name);
+        }
+        check(throwsLogicError([&] { JsonLazyDocument document; document.parse(input); }) == expected, "JsonLazyDocument " + name);
+        check(throwsLogicError([&] { JsonReader reader(input); reader.skipValue(); }) == expected, "JsonReader " + name);
+        check(throwsLogicError([&] { JsonIncrementalParser parser([](std::shared_ptr<JsonNode>) {}); parser.feed(input); parser.finish(); }) == expected, "JsonIncrementalParser " + name);
+
+        // The stream parser reports the error and returns an empty root
+        std::istringstream stream(input);
+        JsonParser streamParser(&stream);
+        check((streamParser.parse() != nullptr) != expected, "JsonParser stream " + name);
+    }
+}
+
+// Scalar reads do not materialize nodes, and the nodes returned by the lazy document are
+// copies: modifying them does not change later lookups
+BG2E_TEST(jsonLazyDocumentCache)
+{
+    JsonLazyDocument document;
+    document.parse(std::string_view(R"({ "count": 42, "scale": -3.5, "list": [1, 2, 3], "position": [0.5, 1, 2] })"));
+    check(document["count"].intValue(0) == 42 && document["count"].uintValue(0) == 42, "integer read");
+    check(document["scale"].intValue(0) == -3, "integer read of a decimal number");
+    check(document.cachedNodeCount() == 0, "scalar reads created nodes");
+
+    auto list = document["list"].node();
+    list->listValue().push_back(JSON(std::string("extra")));
+    auto root = document.root().node();
+    check(document["list"].node()->isIntArray() && compact(*document["list"].node()) == "[1,2,3]", "cached list modified: " + compact(*document["list"].node()));
+    check(compact(*root->objectValue()["list"]) == "[1,2,3]", "shared list modified: " + compact(*root));
+
+    auto position = document.at("/position");
+    position->listValue().clear();
+    check(document.at("/position")->isFloatArray() && document["position"].vec3Value() == glm::vec3(0.5f, 1.0f, 2.0f), "cached pointer node modified");
+}
+
+// Two patches of the same key, applied to a document that shares its items with a copy. The
+// patches and the copy must not change
+BG2E_TEST(jsonMergePatchSharedNodes)
+{
+    JsonParser parser;
+    auto document = parser.parse(std::string_view(R"({ "light": { "color": [1, 1, 1], "intensity": 1 } })"));
+    auto firstPatch = parser.parse(std::string_view(R"({ "light": { "intensity": 2, "range": { "near": 1 } } })"));
+    auto secondPatch = parser.parse(std::string_view(R"({ "light": { "intensity": 3, "range": { "near": 5 } } })"));
+    JsonNode copy(document->objectValue());
+
+    document->applyMergePatch(*firstPatch);
+    document->applyMergePatch(*secondPatch);
+
+    check(compact(*document) == R"({"light":{"color":[1,1,1],"intensity":3,"range":{"near":5}}})", "patched document: " + compact(*document));
+    check(compact(copy) == R"({"light":{"color":[1,1,1],"intensity":1}})", "shared copy: " + compact(copy));
+    check(compact(*firstPatch) == R"({"light":{"intensity":2,"range":{"near":1}}})", "first patch: " + compact(*firstPatch));
+}
+
+// The writer uses the shortest text that reads back as the same value
+BG2E_TEST(jsonNumberFormat)
+{
+    char text[JsonNumberBufferSize];
+    const std::vector<std::pair<double, std::string>> doubles = {
+        { 0.1, "0.1" }, { 0.5, "0.5" }, { 1e300, "1e+300" }, { 123456789.0, "123456789" }, { -2.5, "-2.5" }
+    };
+    for (auto & item : doubles)
+    {
+        std::string result(text, formatJsonNumber(item.first, text));
+        check(result == item.second, "double " + item.second + " written as " + result);
+        check(parseJsonNumber(result).doubleValue == item.first, "double " + result + " does not read back");
+    }
+    const std::vector<std::pair<float, std::string>> floats = {
+        { 0.1f, "0.1" }, { 0.3f, "0.3" }, { 16777216.0f, "16777216" }, { 1e-45f, "1e-45" }
+    };
+    for (auto & item : floats)
+    {
+        std::string result(text, formatJsonNumber(item.first, text));
+        check(result == item.second, "float " + item.second + " written as " + result);
+    }
+
+    JsonNode vector(glm::vec3(0.8f, 0.3f, 1.0f));
+    check(compact(vector) == "[0.8,0.3,1]", "vec3 written as " + compact(vector));
+}
+
+// Leading zeros are not valid, and out of range values are infinity or zero, as in strtod
+BG2E_TEST(jsonNumberParse)
+{
+    for (std::string text : { "01", "-01", "00.5", "1.", ".5", "1e", "-", "+1", "0x10" })
+    {
+        bool failed = false;
+        try
+        {
+            parseJsonNumber(text);
+        }
+        catch (std::logic_error&)
+        {
+            failed = true;
+        }
+        check(failed, "invalid number " + text + " accepted");
+    }
+    const std::vector<std::pair<std::string, double>> values = {
+        { "0", 0.0 }, { "-0", 0.0 }, { "10", 10.0 }, { "0.5", 0.5 }, { "-0.25e2", -25.0 },
+        { "1e400", std::numeric_limits<double>::infinity() }, { "-1e400", -std::numeric_limits<double>::infinity() },
+        { "1e-400", 0.0 }, { "5e-324", 5e-324 }, { "0.00001e310", 1e305 }
+    };
+    // The decimal exponent of the first digit decides between overflow and underflow
+    check(parseJsonNumber("1" + std::string(400, '0') + "e-5").doubleValue == std::numeric_limits<double>::infinity(), "long mantissa with negative exponent");
+    check(parseJsonNumber("0." + std::string(400, '0') + "1e10").doubleValue == 0.0, "long fraction with positive exponent");
+    for (auto & item : values)
+    {
+        check(parseJsonNumber(item.first).doubleValue == item.second, "number " + item.first + " read as " + std::to_string(parseJsonNumber(item.first).doubleValue));
+    }
+}
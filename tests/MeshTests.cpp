@@ -0,0 +1,89 @@
+#include "Tests.hpp"
+
+#include <bg2e/base/PolyList.hpp>
+#include <bg2e/base/MeshOptimizer.hpp>
+
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <string>
+
+using namespace bg2e::base;
+using bg2e::tests::check;
+
+// Height field grid with side * side * 2 triangles
+static std::shared_ptr<PolyList> buildGrid(uint32_t side)
+{
+    const uint32_t rowVertices = side + 1;
+    std::vector<float> vertex;
+    std::vector<float> normal;
+    std::vector<float> texCoord;
+    std::vector<uint32_t> index;
+    for (uint32_t y = 0; y < rowVertices; ++y)
+    {
+        for (uint32_t x = 0; x < rowVertices; ++x)
+        {
+            float u = static_cast<float>(x) / side;
+            float v = static_cast<float>(y) / side;
+            vertex.insert(vertex.end(), { u, v, 0.05f * std::sin(u * 20.0f) * std::cos(v * 20.0f) });
+            normal.insert(normal.end(), { 0.0f, 0.0f, 1.0f });
+            texCoord.insert(texCoord.end(), { u, v });
+        }
+    }
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            uint32_t i = y * rowVertices + x;
+            index.insert(index.end(), { i, i + 1, i + rowVertices + 1, i, i + rowVertices + 1, i + rowVertices });
+        }
+    }
+
+    auto result = std::make_shared<PolyList>();
+    result->setName("grid");
+    result->setVertex(std::move(vertex));
+    result->setNormal(std::move(normal));
+    result->setTexCoord0(std::move(texCoord));
+    result->setIndex(std::move(index));
+    return result;
+}
+
+// The parallel path is used above 32768 triangles, and it must produce the same tangents
+BG2E_TEST(polyListParallelTangents)
+{
+    auto plist = buildGrid(200);
+    plist->rebuildTangents(false);
+    std::vector<float> serialTangents = plist->tangent();
+    std::vector<float> serialHandedness = plist->tangentHandedness();
+    plist->rebuildTangents(true);
+    check(!serialTangents.empty(), "no tangents generated");
+    check(plist->tangent() == serialTangents, "the parallel tangents are different from the serial tangents");
+    check(plist->tangentHandedness() == serialHandedness, "the parallel handedness is different from the serial handedness");
+}
+
+// The vertices used only by a level of detail are kept, and the level of detail still
+// references the same positions
+BG2E_TEST(meshOptimizerVertexFetchLods)
+{
+    auto plist = buildGrid(4);
+    std::vector<uint32_t> index = plist->index();
+    std::vector<float> vertex = plist->vertex();
+    PolyListLod lod;
+    lod.index = index;
+    plist->setLods({ lod });
+    plist->setIndex(std::vector<uint32_t>(index.begin(), index.begin() + index.size() / 2));
+
+    MeshOptimizer optimizer;
+    optimizer.optimizeVertexFetch(*plist);
+    check(plist->vertex().size() == vertex.size(), "vertices removed: " + std::to_string(plist->vertex().size() / 3));
+    const auto& lodIndex = plist->lods()[0].index;
+    bool samePositions = lodIndex.size() == index.size();
+    for (size_t i = 0; samePositions && i < index.size(); ++i)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            samePositions = samePositions && plist->vertex()[lodIndex[i] * 3 + c] == vertex[index[i] * 3 + c];
+        }
+    }
+    check(samePositions, "the level of detail references different positions");
+}
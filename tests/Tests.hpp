@@ -0,0 +1,46 @@
+#ifndef bg2e_tests_tests_hpp
+#define bg2e_tests_tests_hpp
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bg2e {
+namespace tests {
+
+struct TestCase
+{
+    std::string name;
+    std::function<void()> run;
+};
+
+std::vector<TestCase>& testCases();
+
+struct TestRegistration
+{
+    TestRegistration(const std::string& name, std::function<void()> run)
+    {
+        testCases().push_back({ name, std::move(run) });
+    }
+};
+
+// A test fails if it throws an exception
+inline void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+}
+}
+
+// Defines a test function and registers it in the list of tests run by the test program
+#define BG2E_TEST(name) \
+    static void name(); \
+    static bg2e::tests::TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#endif
@@ -0,0 +1,47 @@
+#include "Tests.hpp"
+
+#include <bg2e/base/Texture.hpp>
+#include <bg2e/tools/JsonParser.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using namespace bg2e::base;
+using bg2e::tests::check;
+
+static uint32_t applyPatch(Texture& texture, const std::string& patch)
+{
+    bg2e::tools::JsonParser parser;
+    return texture.applyPatch(*parser.parse(std::string_view(patch)));
+}
+
+// Enumeration values out of range throw std::logic_error, and the texture is not modified
+BG2E_TEST(textureEnumPatch)
+{
+    Texture texture;
+    texture.setUpdated(true);
+    uint32_t changed = applyPatch(texture, R"({ "wrapModeX": 2, "magFilter": 4, "renderTargetAttachment": 100 })");
+    check(changed == (TextureFieldWrapModeX | TextureFieldMagFilter | TextureFieldRenderTargetAttachment), "changed fields: " + std::to_string(changed));
+    check(texture.wrapModeX() == TextureWrap::MirroredRepeat && texture.magFilter() == TextureFilter::Nearest &&
+        texture.renderTargetAttachment() == TextureRenderTargetAttachment::DepthAttachment, "patched values");
+
+    texture.setUpdated(true);
+    for (std::string patch : {
+        R"({ "wrapModeY": 1, "minFilter": 99 })",
+        R"({ "wrapModeY": 1, "wrapModeX": -1 })",
+        R"({ "wrapModeY": 1, "renderTargetAttachment": 50 })",
+        R"({ "wrapModeY": 1, "size": [16, 16], "componentFormat": 2 })" })
+    {
+        bool failed = false;
+        try
+        {
+            applyPatch(texture, patch);
+        }
+        catch (std::logic_error&)
+        {
+            failed = true;
+        }
+        check(failed, "invalid patch accepted: " + patch);
+        check(texture.wrapModeY() == TextureWrap::Repeat && texture.size().width == 0 && !texture.dirty(), "texture modified by invalid patch: " + patch);
+    }
+}
@@ -0,0 +1,49 @@
+#include "Tests.hpp"
+
+#include <iostream>
+#include <exception>
+#include <string>
+
+// Usage: tests [name]
+// Runs the tests whose name contains `name`, or all of them. Returns 1 if a test fails.
+
+namespace bg2e {
+namespace tests {
+
+std::vector<TestCase>& testCases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+}
+}
+
+int main(int argc, char ** argv)
+{
+    using namespace bg2e::tests;
+
+    std::string filter = argc > 1 ? argv[1] : "";
+    size_t passed = 0;
+    size_t failed = 0;
+    for (auto & test : testCases())
+    {
+        if (test.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        try
+        {
+            test.run();
+            ++passed;
+            std::cout << "PASS " << test.name << std::endl;
+        }
+        catch (std::exception& err)
+        {
+            ++failed;
+            std::cout << "FAIL " << test.name << ": " << err.what() << std::endl;
+        }
+    }
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}